@@ -65,5 +65,26 @@ namespace zuluide {
       auto newHeight = newSize.height > size.height ? size.height : newSize.height;
       return { {center, y}, {newWidth, newHeight}};
     }
+
+    bool IsEmpty() {
+      return size.width == 0 || size.height == 0;
+    }
+
+    /***
+        Returns the smallest rectangle containing both this rectangle and other.
+     */
+    Rectangle Union(Rectangle other) {
+      if (IsEmpty()) {
+        return other;
+      } else if (other.IsEmpty()) {
+        return *this;
+      }
+
+      uint16_t left = topLeft.x < other.topLeft.x ? topLeft.x : other.topLeft.x;
+      uint16_t top = topLeft.y < other.topLeft.y ? topLeft.y : other.topLeft.y;
+      uint16_t right = Right() > other.Right() ? Right() : other.Right();
+      uint16_t bottom = Bottom() > other.Bottom() ? Bottom() : other.Bottom();
+      return { {left, top}, {(uint16_t)(right - left), (uint16_t)(bottom - top)}};
+    }
   };
 }
@@ -25,6 +25,8 @@
 
 #include "display_ssd1306.h"
 #include "ZuluIDE_log.h"
+#include <zuluide/i2c/i2c_master_dma.h>
+#include <string.h>
 
 using namespace zuluide;
 using namespace zuluide::status;
@@ -41,16 +43,34 @@ using namespace zuluide::status;
 #define SCROLL_START_DELAY_MS 1000
 #endif
 
-#define WIDTH 128
-#define HEIGHT 32
+#ifndef SS1306_CLK_DURING
+#define SS1306_CLK_DURING 400000
+#endif
+
+#ifndef SS1306_CLK_AFTER
+#define SS1306_CLK_AFTER 100000
+#endif
+
+// Bytes per data transaction when falling back to blocking Wire writes,
+// the control byte takes one byte of the Wire buffer.
+#ifndef SS1306_WIRE_CHUNK
+#define SS1306_WIRE_CHUNK 31
+#endif
+
+#ifndef SS1306_DMA_TIMEOUT_MS
+#define SS1306_DMA_TIMEOUT_MS 100
+#endif
+
+#define WIDTH SSD1306_WIDTH
+#define HEIGHT SSD1306_HEIGHT
 
-DisplaySSD1306::DisplaySSD1306() : nextRefresh(at_the_end_of_time)
+DisplaySSD1306::DisplaySSD1306() : nextRefresh(at_the_end_of_time), sentBufferValid(false), transferActive(false)
 {
 }
 
 void DisplaySSD1306::init(TwoWire* wire) {
   m_wire = wire;
-  graph = Adafruit_SSD1306(WIDTH, HEIGHT, m_wire, -1, 400000, 100000);
+  graph = Adafruit_SSD1306(WIDTH, HEIGHT, m_wire, -1, SS1306_CLK_DURING, SS1306_CLK_AFTER);
   m_i2c_addr = SS1306_ADDR;
 
   if(graph.begin(SSD1306_SWITCHCAPVCC, m_i2c_addr, false, false)) {
@@ -60,6 +80,11 @@ void DisplaySSD1306::init(TwoWire* wire) {
     wBounds = {h, w};
     graph.setTextWrap(false);
 
+    // Bring the panel RAM to a known state, after this only changes are sent.
+    graph.display();
+    memcpy(sentBuffer, graph.getBuffer(), sizeof(sentBuffer));
+    sentBufferValid = true;
+
     //currentWidget = std::make_unique<zuluide::SplashWidget>(&graph, Rectangle{{0,0}, {WIDTH, HEIGHT}});
     //updateDisplay();
   } else {
@@ -133,7 +158,8 @@ void DisplaySSD1306::updateDisplay() {
   graph.clearDisplay();
 
   currentWidget->Display();
-  graph.display();
+  currentWidget->TakeDirtyRegion();
+  sendRegion(Rectangle{{0,0}, {WIDTH, HEIGHT}});
   nextRefresh = make_timeout_time_ms(SCROLL_INTERVAL_MS);
 }
 
@@ -145,8 +171,119 @@ void DisplaySSD1306::Refresh() {
   nextRefresh = make_timeout_time_ms(SCROLL_INTERVAL_MS);
 
   if (currentDispState && currentSysStatus && currentWidget->Refresh()) {
-    graph.clearDisplay();
+    // Only the damaged area is cleared, the rest of the widget redraws
+    // identical pixels on top of what is already in the framebuffer.
+    auto region = currentWidget->TakeDirtyRegion();
+    graph.fillRect(region.topLeft.x, region.topLeft.y, region.size.width, region.size.height, BLACK);
     currentWidget->Display();
-    graph.display();
+    sendRegion(region);
+  }
+}
+
+void DisplaySSD1306::FinishTransfer() {
+  if (!transferActive) {
+    return;
+  }
+
+  if (!zuluide::i2c::I2CMasterDmaFinish(make_timeout_time_ms(SS1306_DMA_TIMEOUT_MS))) {
+    dbgmsg("SSD1306 DMA transfer failed, resending full frame");
+    sentBufferValid = false;
+  }
+  m_wire->setClock(SS1306_CLK_AFTER);
+  transferActive = false;
+}
+
+/***
+    Compares the framebuffer to what was last sent to the panel within the
+    pages covered by region, and sends the bounding box of the changed bytes.
+ */
+void DisplaySSD1306::sendRegion(Rectangle region) {
+  FinishTransfer();
+
+  if (region.IsEmpty()) {
+    return;
+  }
+
+  if (!sentBufferValid) {
+    region = Rectangle{{0,0}, {WIDTH, HEIGHT}};
+  }
+
+  uint16_t right = region.Right() > WIDTH ? WIDTH : region.Right();
+  uint16_t bottom = region.Bottom() > HEIGHT ? HEIGHT : region.Bottom();
+  if (region.topLeft.x >= right || region.topLeft.y >= bottom) {
+    return;
+  }
+
+  const uint8_t* buffer = graph.getBuffer();
+  int firstPage = SSD1306_PAGES, lastPage = -1;
+  int firstCol = WIDTH, lastCol = -1;
+  for (int page = region.topLeft.y / 8; page <= (bottom - 1) / 8; page++) {
+    for (int col = region.topLeft.x; col < right; col++) {
+      int idx = page * WIDTH + col;
+      if (!sentBufferValid || buffer[idx] != sentBuffer[idx]) {
+        if (page < firstPage) firstPage = page;
+        if (page > lastPage) lastPage = page;
+        if (col < firstCol) firstCol = col;
+        if (col > lastCol) lastCol = col;
+      }
+    }
+  }
+
+  if (lastPage < 0) {
+    // Nothing changed on the panel.
+    return;
+  }
+
+  sendWindow(firstPage, lastPage, firstCol, lastCol);
+}
+
+/***
+    Sets the SSD1306 addressing window and sends the framebuffer bytes inside it.
+    In horizontal addressing mode the panel wraps to the next page at lastCol,
+    so the window is sent as one contiguous run.
+ */
+void DisplaySSD1306::sendWindow(uint8_t firstPage, uint8_t lastPage, uint8_t firstCol, uint8_t lastCol) {
+  const uint8_t* buffer = graph.getBuffer();
+  uint16_t len = 0;
+  for (int page = firstPage; page <= lastPage; page++) {
+    int idx = page * WIDTH + firstCol;
+    int count = lastCol - firstCol + 1;
+    memcpy(&txBuffer[len], &buffer[idx], count);
+    memcpy(&sentBuffer[idx], &buffer[idx], count);
+    len += count;
+  }
+  sentBufferValid = true;
+
+  m_wire->setClock(SS1306_CLK_DURING);
+  m_wire->beginTransmission(m_i2c_addr);
+  m_wire->write((uint8_t)0x00); // Co = 0, D/C = 0: command stream
+  m_wire->write((uint8_t)SSD1306_COLUMNADDR);
+  m_wire->write(firstCol);
+  m_wire->write(lastCol);
+  m_wire->write((uint8_t)SSD1306_PAGEADDR);
+  m_wire->write(firstPage);
+  m_wire->write(lastPage);
+  if (m_wire->endTransmission() != 0) {
+    sentBufferValid = false;
+    m_wire->setClock(SS1306_CLK_AFTER);
+    return;
+  }
+
+  // Data stream, D/C = 1
+  if (zuluide::i2c::I2CMasterDmaWriteAsync(m_i2c_addr, 0x40, txBuffer, len)) {
+    transferActive = true;
+    return;
+  }
+
+  for (uint16_t pos = 0; pos < len; pos += SS1306_WIRE_CHUNK) {
+    uint16_t toSend = (pos + SS1306_WIRE_CHUNK) < len ? SS1306_WIRE_CHUNK : len - pos;
+    m_wire->beginTransmission(m_i2c_addr);
+    m_wire->write((uint8_t)0x40);
+    m_wire->write(&txBuffer[pos], toSend);
+    if (m_wire->endTransmission() != 0) {
+      sentBufferValid = false;
+      break;
+    }
   }
+  m_wire->setClock(SS1306_CLK_AFTER);
 }
@@ -42,6 +42,11 @@
 
 using namespace zuluide::status;
 
+#define SSD1306_WIDTH 128
+#define SSD1306_HEIGHT 32
+#define SSD1306_PAGES (SSD1306_HEIGHT / 8)
+#define SSD1306_FRAMEBUFFER_SIZE (SSD1306_WIDTH * SSD1306_PAGES)
+
 namespace zuluide {
   class DisplaySSD1306 {
   public:
@@ -54,6 +59,11 @@ namespace zuluide {
 	itself (e.g., scrolling text.)
      */
     void Refresh();
+    /***
+	Waits for a framebuffer update still being sent over DMA to complete.
+	Must be called before anything else uses the shared I2C bus.
+     */
+    void FinishTransfer();
   private:
     TwoWire* m_wire;
     Adafruit_SSD1306 graph;
@@ -63,6 +73,13 @@ namespace zuluide {
     std::unique_ptr<zuluide::control::DisplayState> currentDispState;
     std::unique_ptr<SystemStatus> currentSysStatus;
     std::unique_ptr<zuluide::Widget> currentWidget;
+    // Copy of what the panel currently shows, used to send only changed bytes.
+    uint8_t sentBuffer[SSD1306_FRAMEBUFFER_SIZE];
+    uint8_t txBuffer[SSD1306_FRAMEBUFFER_SIZE];
+    bool sentBufferValid;
+    bool transferActive;
     void updateDisplay();
+    void sendRegion(Rectangle region);
+    void sendWindow(uint8_t firstPage, uint8_t lastPage, uint8_t firstCol, uint8_t lastCol);
   };
 }
@@ -51,7 +51,12 @@ void InfoWidget::Update (const zuluide::control::DisplayState &disp) {
 }
 
 bool InfoWidget::Refresh () {
-  return firmwareversion.CheckAndUpdateScrolling(get_absolute_time());
+  if (firmwareversion.CheckAndUpdateScrolling(get_absolute_time())) {
+    MarkDirty(firmwareversion.GetBounds());
+    return true;
+  }
+
+  return false;
 }
 
 void InfoWidget::Display () {
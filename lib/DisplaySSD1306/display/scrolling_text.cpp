@@ -23,6 +23,7 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
 **/
 #include "scrolling_text.h"
+#include <string.h>
 using namespace zuluide;
 
 #ifndef SCROLL_INTERVAL_MS
@@ -49,6 +50,7 @@ void ScrollingText::SetToDisplay(const char* toDisp) {
   int16_t x = 0, y = 0;
   graph->getTextBounds(toDisplay.c_str(), 0 ,0, &x, &y, &toDispSize.width, &toDispSize.height);
   isStationaryText = toDispSize.width <= bounds.size.width;
+  renderStrip();
   
   // When changing the text, don't start scrolling immediately.
   Reset();
@@ -96,10 +98,19 @@ bool ScrollingText::CheckAndUpdateScrolling(absolute_time_t now) {
 void ScrollingText::Display() {
   if (isStationaryText) {
     auto dispBox = bounds.MakeCentered(toDispSize);
+    if (!strip.empty()) {
+      blitStrip(dispBox.topLeft.x, dispBox.topLeft.y);
+      return;
+    }
     graph->setCursor(dispBox.topLeft.x, dispBox.topLeft.y);
     graph->print(toDisplay.c_str());
   } else {
-    auto left = bounds.topLeft.x - imageNameOffsetPixels;
+    int16_t left = bounds.topLeft.x - imageNameOffsetPixels;
+    if (!strip.empty()) {
+      blitStrip(left, bounds.topLeft.y);
+      return;
+    }
+
     // Move the cursor.
     graph->setCursor(left, bounds.topLeft.y);
     
@@ -108,6 +119,86 @@ void ScrollingText::Display() {
   }
 }
 
+/**
+   Rasterizes the whole text once into an off-screen canvas and converts it
+   to the vertical byte per column layout of the SSD1306 framebuffer, so that
+   each frame only has to copy the visible window.
+   Leaves the strip empty (Display() falls back to printing) if the text does
+   not fit in a single page.
+ **/
+void ScrollingText::renderStrip() {
+  strip.clear();
+  if (toDispSize.width == 0 || toDispSize.height > 8) {
+    return;
+  }
+
+  GFXcanvas1 canvas(toDispSize.width, 8);
+  if (!canvas.getBuffer()) {
+    return;
+  }
+
+  canvas.setTextWrap(false);
+  canvas.setTextColor(1);
+  canvas.setCursor(0, 0);
+  canvas.print(toDisplay.c_str());
+
+  strip.resize(toDispSize.width);
+  for (uint16_t x = 0; x < toDispSize.width; x++) {
+    uint8_t column = 0;
+    for (uint8_t y = 0; y < 8; y++) {
+      if (canvas.getPixel(x, y)) {
+        column |= 1 << y;
+      }
+    }
+    strip[x] = column;
+  }
+}
+
+/**
+   Copies the visible part of the strip into the framebuffer with its left
+   edge at the given x coordinate, which may be negative while scrolling.
+   Pixels are written opaque, matching text drawn with a background color.
+ **/
+void ScrollingText::blitStrip(int16_t left, int16_t top) {
+  int16_t width = graph->width();
+  int16_t pages = graph->height() / 8;
+  int16_t page = top / 8;
+  uint8_t shift = top & 7;
+  if (top < 0 || page >= pages) {
+    return;
+  }
+
+  int16_t first = left < 0 ? -left : 0;
+  int16_t last = (int16_t)strip.size();
+  if (left + last > width) {
+    last = width - left;
+  }
+  if (first >= last) {
+    return;
+  }
+
+  uint8_t *row0 = graph->getBuffer() + page * width;
+  if (shift == 0) {
+    memcpy(row0 + left + first, strip.data() + first, last - first);
+    return;
+  }
+
+  uint8_t *row1 = (page + 1 < pages) ? row0 + width : nullptr;
+  uint8_t mask0 = 0xFF << shift;
+  uint8_t mask1 = 0xFF >> (8 - shift);
+  for (int16_t i = first; i < last; i++) {
+    int16_t x = left + i;
+    row0[x] = (row0[x] & ~mask0) | (uint8_t)(strip[i] << shift);
+    if (row1) {
+      row1[x] = (row1[x] & ~mask1) | (uint8_t)(strip[i] >> (8 - shift));
+    }
+  }
+}
+
 void ScrollingText::SetCenterStationaryText(bool value) {
   centerStationaryText = value;
 }
+
+Rectangle ScrollingText::GetBounds() {
+  return bounds;
+}
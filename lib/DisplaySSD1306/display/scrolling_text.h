@@ -28,6 +28,7 @@
 #include "dimensions.h"
 #include <Adafruit_SSD1306.h>
 #include <string>
+#include <vector>
 
 namespace zuluide {
   class ScrollingText {
@@ -49,6 +50,11 @@ namespace zuluide {
     void Reset();
 
     void SetCenterStationaryText(bool value);
+
+    /**
+       Returns the area of the display this text draws into.
+     **/
+    Rectangle GetBounds();
   private:
     Rectangle bounds;
     std::string toDisplay;
@@ -61,5 +67,9 @@ namespace zuluide {
     bool isDirty;
     bool centerStationaryText;
     bool isStationaryText;
+    // The text rendered once in SSD1306 page format, one byte per pixel column.
+    std::vector<uint8_t> strip;
+    void renderStrip();
+    void blitStrip(int16_t left, int16_t top);
   };
 }
@@ -52,7 +52,12 @@ void SelectWidget::Update (const zuluide::control::DisplayState &disp) {
 }
 
 bool SelectWidget::Refresh () {
-  return image.CheckAndUpdateScrolling(get_absolute_time());
+  if (image.CheckAndUpdateScrolling(get_absolute_time())) {
+    MarkDirty(image.GetBounds());
+    return true;
+  }
+
+  return false;
 }
 
 void SelectWidget::Display () {
@@ -57,8 +57,17 @@ void StatusWidget::Update (const zuluide::control::DisplayState &disp) {
 }
 
 bool StatusWidget::Refresh () {
-  bool update = imagename.CheckAndUpdateScrolling(get_absolute_time());
-  update = deferred_load.CheckAndUpdateScrolling(get_absolute_time()) || update;
+  bool update = false;
+  if (imagename.CheckAndUpdateScrolling(get_absolute_time())) {
+    MarkDirty(imagename.GetBounds());
+    update = true;
+  }
+
+  if (deferred_load.CheckAndUpdateScrolling(get_absolute_time())) {
+    MarkDirty(deferred_load.GetBounds());
+    update = true;
+  }
+
   return update;
 }
 
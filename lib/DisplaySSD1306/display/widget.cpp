@@ -27,7 +27,7 @@
 
 using namespace zuluide;
 
-Widget::Widget (Adafruit_SSD1306 *g, Rectangle b) : graph(g), bounds(b) { }
+Widget::Widget (Adafruit_SSD1306 *g, Rectangle b) : graph(g), bounds(b), dirtyRegion({{0,0}, {0,0}}) { }
 
 void Widget::DrawCenteredText (const char* text) {
   // Make a text box centered inside of the bounds.
@@ -66,3 +66,14 @@ void Widget::Update (const zuluide::control::DisplayState &disp) {
 bool Widget::Refresh () {
   return false;
 }
+
+void Widget::MarkDirty (Rectangle region) {
+  dirtyRegion = dirtyRegion.Union(region);
+}
+
+Rectangle Widget::TakeDirtyRegion () {
+  // Widgets that do not track their damage get redrawn completely.
+  Rectangle result = dirtyRegion.IsEmpty() ? bounds : dirtyRegion;
+  dirtyRegion = {{0,0}, {0,0}};
+  return result;
+}
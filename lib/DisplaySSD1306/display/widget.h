@@ -41,10 +41,18 @@ namespace zuluide {
     void DrawCenteredText (const char* text);
     void DrawCenteredTextAt (const char* text, int y);
     Size MeasureText (const char* text);
+    /***
+        Returns the area that changed since the last call and resets it.
+        Only meaningful after Refresh() returned true, full updates always
+        redraw the whole widget.
+     */
+    Rectangle TakeDirtyRegion ();
   protected:
     Widget (Adafruit_SSD1306 *g, Rectangle b);
     Adafruit_SSD1306 *graph;
     Rectangle bounds;
+    Rectangle dirtyRegion;
+    void MarkDirty (Rectangle region);
     std::unique_ptr<zuluide::status::SystemStatus> currentSysStatus;
     std::unique_ptr<zuluide::control::DisplayState> currentDispState;
   };
@@ -29,6 +29,15 @@
 using namespace zuluide::control;
 
 static volatile bool g_control_input_flag = false;
+static volatile uint32_t g_control_input_time = 0;
+
+// PCA9554 INT is open drain and stays low until the input port is read.
+static void control_input_isr() {
+  if (!g_control_input_flag) {
+    g_control_input_time = millis();
+    g_control_input_flag = true;
+  }
+}
 
 #ifndef DEBOUNCE_IN_MS
 #define DEBOUNCE_IN_MS 20
@@ -39,16 +48,40 @@ void RotaryControl::SetReceiver(InputReceiver* receiver) {
 }
 
 void RotaryControl::StartSendingEvents() {  
-  eject_btn_millis = insert_btn_millis = 0;
+  eject_btn_millis = insert_btn_millis = rotate_btn_millis = 0;
+  eventHead = eventTail = 0;
   isSending = true;
   lrmem = 3;
   lrsum = 0;
+
+#ifdef GPIO_EXT_INTERRUPT
+  if (deviceExists && interruptAllowed && !interruptEnabled) {
+    pinMode(GPIO_EXT_INTERRUPT, INPUT_PULLUP);
+    attachInterrupt(digitalPinToInterrupt(GPIO_EXT_INTERRUPT), control_input_isr, FALLING);
+    interruptEnabled = true;
+    // Read once so the current state is known and INT is released.
+    g_control_input_flag = true;
+    g_control_input_time = millis();
+    dbgmsg("Rotary control reading expander on interrupt from GPIO ", (int)GPIO_EXT_INTERRUPT);
+  }
+#endif
 }
 
 void RotaryControl::StopSendingEvents() {
   isSending = false;
 }
 
+void RotaryControl::SetInterruptAllowed(bool allowed) {
+  interruptAllowed = allowed;
+#ifdef GPIO_EXT_INTERRUPT
+  if (!allowed && interruptEnabled) {
+    detachInterrupt(digitalPinToInterrupt(GPIO_EXT_INTERRUPT));
+    interruptEnabled = false;
+    dbgmsg("Rotary control reading expander on every poll");
+  }
+#endif
+}
+
 bool RotaryControl::CheckForDevice()
 {
   wire->begin();
@@ -64,7 +97,8 @@ bool RotaryControl::GetDeviceExists()
 }
 
 RotaryControl::RotaryControl(int addr) :
-  pcaAddr(addr), deviceExists(false), isSending(false), tick_count(0), going_cw(true), number_of_ticks(1), rotary_state(ROTARY_TICK_000) {
+  pcaAddr(addr), deviceExists(false), isSending(false), interruptAllowed(true), interruptEnabled(false), eventHead(0), eventTail(0),
+  tick_count(0), going_cw(true), number_of_ticks(1), rotary_state(ROTARY_TICK_000) {
 }
 
 uint8_t RotaryControl::getValue() {
@@ -96,25 +130,78 @@ void RotaryControl::Poll() {
   if(!deviceExists || !isSending) {
     return;
   }
-  
-  uint8_t input_byte = getValue();
-  uint32_t check_time = millis();
+
+  uint32_t check_time;
+  if (interruptEnabled) {
+#ifdef GPIO_EXT_INTERRUPT
+    // The level check catches a change that happened while the previous
+    // read was in progress, as INT then stays low without a new edge.
+    if (!g_control_input_flag && digitalRead(GPIO_EXT_INTERRUPT)) {
+      dispatchEvents();
+      return;
+    }
+#endif
+    check_time = g_control_input_flag ? g_control_input_time : millis();
+    // Clear before reading, so an edge during the transaction is not lost.
+    g_control_input_flag = false;
+  } else {
+    check_time = millis();
+  }
+
+  decode(getValue(), check_time);
+  dispatchEvents();
+}
+
+void RotaryControl::queueEvent(input_event_type_t type, int offset) {
+  uint8_t next = (eventHead + 1) % ROTARY_EVENT_QUEUE_SIZE;
+  if (next == eventTail) {
+    // Receiver is not keeping up, drop the oldest event.
+    eventTail = (eventTail + 1) % ROTARY_EVENT_QUEUE_SIZE;
+  }
+
+  eventQueue[eventHead] = {type, offset};
+  eventHead = next;
+}
+
+void RotaryControl::dispatchEvents() {
+  while (eventTail != eventHead) {
+    InputEvent event = eventQueue[eventTail];
+    eventTail = (eventTail + 1) % ROTARY_EVENT_QUEUE_SIZE;
+
+    switch (event.type) {
+    case INPUT_EVENT_ROTATE:
+      inputReceiver->RotaryUpdate(event.offset);
+      break;
+    case INPUT_EVENT_ROTARY_BUTTON:
+      inputReceiver->RotaryButtonPressed();
+      break;
+    case INPUT_EVENT_PRIMARY_BUTTON:
+      inputReceiver->PrimaryButtonPressed();
+      break;
+    case INPUT_EVENT_SECONDARY_BUTTON:
+      inputReceiver->SecondaryButtonPressed();
+      break;
+    }
+  }
+}
+
+void RotaryControl::decode(uint8_t input_byte, uint32_t check_time) {
   bool ejectButtonIsDown = ((1 << EXP_EJECT_PIN) & input_byte) != 0;
   bool insertButtonIsPressed = ((1 << EXP_INSERT_PIN) & input_byte) != 0;  
   bool rotateButton = ((1 << EXP_ROT_PIN) & input_byte) != 0;  
 
   if (buttonIsPressed(ejectButtonIsDown, &eject_btn_millis, check_time)) {
     // Eject button was pressed succsfully.
-    inputReceiver->PrimaryButtonPressed();
+    queueEvent(INPUT_EVENT_PRIMARY_BUTTON, 0);
   }
 
   if (buttonIsPressed(insertButtonIsPressed, &insert_btn_millis, check_time)) {
     // Insert button was pressed succsfully.
-    inputReceiver->SecondaryButtonPressed();
+    queueEvent(INPUT_EVENT_SECONDARY_BUTTON, 0);
   }
 
   if (buttonIsPressed(rotateButton, &rotate_btn_millis, check_time)) {
-    inputReceiver->RotaryButtonPressed();
+    queueEvent(INPUT_EVENT_ROTARY_BUTTON, 0);
   }
   uint8_t chan_a = 1 & (input_byte >> EXP_ROT_A_PIN);
   uint8_t chan_b = 1 & (input_byte >> EXP_ROT_B_PIN);
@@ -127,13 +214,13 @@ void RotaryControl::Poll() {
       if (tick_count < number_of_ticks - 1) {
         tick_count++;
       } else {
-        inputReceiver->RotaryUpdate(-1);
+        queueEvent(INPUT_EVENT_ROTATE, -1);
         tick_count = 0;
       }
     } else  if (rotaryDirection == ROTARY_DIR_CCW) {
       tick_count = 1;
       if (tick_count > number_of_ticks - 1) {
-        inputReceiver->RotaryUpdate(1);
+        queueEvent(INPUT_EVENT_ROTATE, 1);
       }
       going_cw = false;
     }
@@ -142,13 +229,13 @@ void RotaryControl::Poll() {
       if (tick_count < number_of_ticks - 1) {
         tick_count++;
       } else {
-        inputReceiver->RotaryUpdate(1);
+        queueEvent(INPUT_EVENT_ROTATE, 1);
         tick_count = 0;
       }
     } else if (rotaryDirection == ROTARY_DIR_CW) {
       tick_count = 1;
       if (tick_count > number_of_ticks - 1) {
-        inputReceiver->RotaryUpdate(-1);
+        queueEvent(INPUT_EVENT_ROTATE, -1);
       }
       going_cw = true;
     }
@@ -164,7 +251,10 @@ bool RotaryControl::buttonIsPressed(bool isDown, uint32_t* lastDownMillis, uint3
     
     return false;
   } else {
-    bool isPressed = *lastDownMillis != 0 && *lastDownMillis - checkTime > DEBOUNCE_IN_MS;
+    // With interrupt driven reads the timestamps are those of the press
+    // and release edges, so contact bounce shorter than the debounce time
+    // is rejected without polling the button while it is held.
+    bool isPressed = *lastDownMillis != 0 && (uint32_t)(checkTime - *lastDownMillis) > DEBOUNCE_IN_MS;
     // Reset our timestamp for this button.
     *lastDownMillis = 0;
 
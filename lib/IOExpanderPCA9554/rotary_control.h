@@ -33,6 +33,11 @@
 #define PCA9554_ADDR 0x3F
 #endif
 
+// Number of decoded input events that can wait for dispatch.
+#ifndef ROTARY_EVENT_QUEUE_SIZE
+#define ROTARY_EVENT_QUEUE_SIZE 16
+#endif
+
 namespace zuluide::control {
 
   enum rotary_direction_t {
@@ -53,6 +58,18 @@ namespace zuluide::control {
     ROTARY_CONT_CCW_110,
   };
 
+  enum input_event_type_t {
+    INPUT_EVENT_ROTATE,
+    INPUT_EVENT_ROTARY_BUTTON,
+    INPUT_EVENT_PRIMARY_BUTTON,
+    INPUT_EVENT_SECONDARY_BUTTON
+  };
+
+  struct InputEvent {
+    input_event_type_t type;
+    int offset;
+  };
+
   class RotaryControl : public InputInterface {
   public:
 
@@ -68,10 +85,28 @@ namespace zuluide::control {
     virtual void StopSendingEvents();
     virtual bool CheckForDevice() override;
     virtual bool GetDeviceExists() override;
+    /*
+      Allows reading the expander on its interrupt line. Disallowed when the
+      line is configured for something else, e.g. an eject button on the same pin.
+     */
+    void SetInterruptAllowed(bool allowed);
+    /*
+      Reads the expander if its interrupt line signaled a change (or on every
+      call when no interrupt line is available), decodes the inputs and
+      dispatches the queued events to the receiver.
+     */
     void Poll();
 
   private:
     uint8_t getValue();
+    void decode(uint8_t input_byte, uint32_t check_time);
+    void queueEvent(input_event_type_t type, int offset);
+    void dispatchEvents();
+    bool interruptAllowed;
+    bool interruptEnabled;
+    InputEvent eventQueue[ROTARY_EVENT_QUEUE_SIZE];
+    uint8_t eventHead;
+    uint8_t eventTail;
     InputReceiver* inputReceiver;
     int pcaAddr;
     bool deviceExists;
@@ -49,6 +49,8 @@ namespace zipparser
         position = 0;
         filename_match = false;
         crc = 0;
+        flags = 0;
+        method = METHOD_STORED;
     }
 
     void Parser::SetMatchingFilename(char const *filename, const size_t length, const size_t target_total_length)
@@ -115,6 +117,7 @@ namespace zipparser
                     }
                 break;
                 case parsing_target::flag:
+                    flags |= buf[idx] << (8 * position);
                     if (++position == 2)
                     {
                         position = 0;
@@ -124,11 +127,13 @@ namespace zipparser
                 case parsing_target::method:
                     if (++position == 1)
                     {
-                        // Currently only uncompresseed files in the zip package are supported
-                        if (!buf[idx] == ZIP_PARSER_METHOD_UNCOMPRESSED_BYTE)
+                        // Uncompressed and deflate compressed files in the zip package are supported
+                        if (buf[idx] != ZIP_PARSER_METHOD_UNCOMPRESSED_BYTE &&
+                            buf[idx] != ZIP_PARSER_METHOD_DEFLATE_BYTE)
                         {
                             return PARSE_UNSUPPORTED_COMPRESSION;
                         }
+                        method = buf[idx];
                     }
                     if (position == 2)
                     {
@@ -50,6 +50,16 @@ namespace zipparser
             int32_t Parse(uint8_t const *buf, const size_t size);
             bool FoundMatch();
             inline uint32_t GetCompressedSize() {return compressed_data_size;}
+            inline uint32_t GetUncompressedSize() {return uncompressed_data_size;}
+            inline uint32_t GetCrc() {return crc;}
+            // Compression method of the current entry, METHOD_STORED or METHOD_DEFLATE
+            inline uint8_t GetMethod() {return method;}
+            // True if the CRC and sizes were left out of the local header and
+            // follow the data in a data descriptor instead
+            inline bool HasDataDescriptor() {return (flags & FLAG_DATA_DESCRIPTOR) != 0;}
+            static const uint8_t METHOD_STORED = 0x00;
+            static const uint8_t METHOD_DEFLATE = 0x08;
+            static const uint16_t FLAG_DATA_DESCRIPTOR = 0x0008;
 
         protected:
             bool filename_match;
@@ -63,6 +73,8 @@ namespace zipparser
             parsing_target target;
             size_t position;
             uint32_t crc;
+            uint16_t flags;
+            uint8_t method;
 
     };
 }
\ No newline at end of file
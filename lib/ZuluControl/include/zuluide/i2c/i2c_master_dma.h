@@ -67,4 +67,17 @@ bool I2CMasterDmaSendChunk(uint8_t addr, uint8_t cmd, const uint8_t* payload,
                            uint16_t length, uint32_t* out_sent_crc,
                            absolute_time_t until);
 
+// Starts sending [prefix][payload...] to `addr` and returns without waiting
+// for the wire transfer. Used by the OLED display to push framebuffer updates
+// while the caller carries on with other work. The shared Wire instance must
+// not be used until I2CMasterDmaFinish() has been called. Returns false if the
+// DMA path is not initialized or another transfer is still in flight.
+bool I2CMasterDmaWriteAsync(uint8_t addr, uint8_t prefix, const uint8_t* payload,
+                            uint16_t length);
+
+// Waits for the transfer started by I2CMasterDmaWriteAsync() to complete and
+// releases the I2C peripheral back to Wire. Returns false on NACK/timeout.
+// Returns true immediately if there is nothing in flight.
+bool I2CMasterDmaFinish(absolute_time_t until);
+
 }  // namespace zuluide::i2c
@@ -35,7 +35,13 @@
 #include "i2c_server_src_type.h"
 #include <string>
 
-#define I2C_API_VERSION "5.0.0"
+#define I2C_API_VERSION "5.1.0"
+
+// Maximum length of one I2C_SERVER_IMAGES_PAGE_JSON message. A page always
+// carries at least one image, so it is longer if that image alone does not fit.
+#ifndef I2C_IMAGE_PAGE_MAX_BYTES
+#define I2C_IMAGE_PAGE_MAX_BYTES 1024
+#endif
 
 // Delay between reading the filenames off the SD card in milliseconds
 #ifndef I2C_FILENAME_TRANSFER_DELAY
@@ -57,6 +63,7 @@
 #define I2C_SERVER_STATIC_IP 0x10
 #define I2C_SERVER_IP_ADDRESS_ACK 0x11
 #define I2C_SERVER_SD_STATUS_CHANGE 0x13  // SD card presence changed; payload[0] = 0x00 not present, 0x01 present
+#define I2C_SERVER_IMAGES_PAGE_JSON 0x14  // {"more":bool,"images":[...]} answering I2C_CLIENT_FETCH_IMAGES_PAGE
 
 #define I2C_SERVER_SD_NOT_PRESENT 0x00
 #define I2C_SERVER_SD_PRESENT     0x01
@@ -83,6 +90,7 @@
 #define I2C_CLIENT_FETCH_ITR_IMAGE 0x10
 #define I2C_CLIENT_IP_ADDRESS 0x11
 #define I2C_CLIENT_LOG_MSG 0x12
+#define I2C_CLIENT_FETCH_IMAGES_PAGE 0x13  // payload[0] = max image count (0 = server default), rest = filename to start after
 
 #define CLIENT_ADDR 0x45
 
@@ -259,10 +267,11 @@ namespace zuluide::i2c {
     /**
      * Handles the different i2c_server_source_t types from HandleImageResponse
      */
-    void HandleFetchFilenames(const std::unique_ptr<ImageResponse<i2c_server_source_t>>&& response);
-    void HandleFetchImages(const std::unique_ptr<ImageResponse<i2c_server_source_t>>&& response);
-    void HandleFetchImage(const std::unique_ptr<ImageResponse<i2c_server_source_t>>&& response);
-    void HandleSetToCurrent(const std::unique_ptr<ImageResponse<i2c_server_source_t>>&& response);
+    void HandleFetchFilenames(const ImageResponse<i2c_server_source_t>& response);
+    void HandleFetchImages(const ImageResponse<i2c_server_source_t>& response);
+    void HandleFetchImage(const ImageResponse<i2c_server_source_t>& response);
+    void HandleSetToCurrent(const ImageResponse<i2c_server_source_t>& response);
+    void HandleFetchImagesPage(const ImageResponse<i2c_server_source_t>& response);
 
     /**
      * Sends WiFi connection request
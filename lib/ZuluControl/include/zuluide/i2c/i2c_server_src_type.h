@@ -23,5 +23,5 @@
 
 namespace zuluide::i2c
 {
-    enum class i2c_server_source_t {FetchFilenames, FetchImages, FetchImage, SetToCurrent, None};
+    enum class i2c_server_source_t {FetchFilenames, FetchImages, FetchImage, FetchImagesPage, SetToCurrent, None};
 }
\ No newline at end of file
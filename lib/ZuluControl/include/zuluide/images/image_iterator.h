@@ -28,11 +28,17 @@
 #include "image.h"
 #include <memory>
 #include <SdFat.h>
+#include <vector>
 #include <CUEParser.h>
 
 // Maximum path length for files on SD card
 #define MAX_FILE_PATH 256
 
+// Maximum number of images returned by ImageIterator::GetPage
+#ifndef IMAGE_PAGE_MAX_ENTRIES
+#define IMAGE_PAGE_MAX_ENTRIES 16
+#endif
+
 namespace zuluide::images {
 
   class ImageIterator
@@ -55,6 +61,11 @@ namespace zuluide::images {
     // Sets Interator to file
     // return true if successful
     bool MoveToFile(const char *filename);
+    // Collect up to maxCount images that sort after the name 'after', or from the
+    // first image if 'after' is empty, with a single pass over the directory.
+    // 'more' is set if there are images past the returned ones.
+    // return the number of images stored in 'images'
+    int GetPage(const char *after, int maxCount, std::vector<Image> &images, bool &more);
     bool IsEmpty();
     int GetFileCount();
     void Reset(bool warning = false);
@@ -26,15 +26,16 @@
 #pragma once
 
 #include <functional>
-#include <zuluide/queue/safe_queue.h>
+#include <zuluide/queue/slot_queue.h>
 
 
 namespace zuluide {
   /***
       Allows one to subscribe to updates via a thread-safe queue that can be read from any thread.
+      Updates are copied into the slots of the queue, a full queue drops the update.
    **/
   template <class T> class ObservableSafe {
   public:
-    virtual void AddObserver(zuluide::queue::SafeQueue* dest) = 0;
+    virtual void AddObserver(zuluide::queue::SlotQueue<T, CONTROL_QUEUE_SLOTS>* dest) = 0;
   };
 }
@@ -28,7 +28,7 @@
 #include <algorithm>
 #include <zuluide/observable_ui_safe.h>
 #include <zuluide/observable_safe.h>
-#include <zuluide/queue/safe_queue.h>
+#include <zuluide/queue/slot_queue.h>
 #include <ide_protocol.h>
 
 namespace zuluide {
@@ -42,7 +42,7 @@ namespace zuluide {
   {
     public:
     ObserverTransfer() : discardOldMessages(false) {
-      updateQueue.Reset(sizeof(T*), 5);
+      updateQueue.Reset();
     };
     
     virtual void AddObserver(std::function<void(const T& current)> callback) {
@@ -62,30 +62,28 @@ namespace zuluide {
     you want the updates to execute.
     **/
     bool ProcessUpdate() {
-      T* item;
-      
       // Throw away outdated messages to get to the latest.
-      while (discardOldMessages && updateQueue.GetLevel() > 1 && updateQueue.TryRemove(&item)) {
-        delete(item);
+      while (discardOldMessages && updateQueue.GetLevel() > 1 && updateQueue.TryRemove(item)) {
       }
       
-      if (updateQueue.TryRemove(&item)) {
+      if (updateQueue.TryRemove(item)) {
         
-        std::for_each(observers.begin(), observers.end(), [this, item](auto observer) {
-          observer(*item);
+        std::for_each(observers.begin(), observers.end(), [this](auto observer) {
+          observer(item);
 #ifndef CONTROL_CROSS_CORE_QUEUE
           ide_protocol_poll();
 #endif
         });
         
-        delete(item);
         return true;
       } else {
         return false;
       }
     };
     private:
-    zuluide::queue::SafeQueue updateQueue;
+    zuluide::queue::SlotQueue<T, CONTROL_QUEUE_SLOTS> updateQueue;
+    // Last received update, kept between calls so that its memory is reused
+    T item;
     std::vector<std::function<void(const T& current)>> observers;
     bool discardOldMessages;
   };
@@ -25,80 +25,62 @@
 #include <zuluide/observable_safe.h>
 #include "image_request_src_tag.h"
 
-#include <string>
-#include <functional>
-#include <memory>
-#include <vector>
+#include <string.h>
+#include <stdint.h>
+
+// Longest file name that an image request can carry
+#ifndef IMAGE_REQUEST_FILENAME_MAX
+#define IMAGE_REQUEST_FILENAME_MAX 256
+#endif
 
 namespace zuluide::pipe {
   
-enum class image_request_t {First, Next, Prev, Current, Last, Cleanup, Reset, WiFiConnect, Empty};
+enum class image_request_t {First, Next, Prev, Current, Last, Page, Cleanup, Reset, WiFiConnect, Empty};
+/**
+ * The file name is kept in a fixed size buffer, so requests can be copied
+ * into queue slots without heap allocation.
+ */
 template<typename SrcType>
 class ImageRequest{
   public:
   ImageRequest();
   ImageRequest(image_request_t request, SrcType source);
-  ImageRequest(const ImageRequest& src);
-  ImageRequest(ImageRequest&& src);
-  ImageRequest& operator= (ImageRequest&& src);
-  ImageRequest& operator= (const ImageRequest& src);
 
   void RequestFilenamesSafe(image_request_t action);
 
   void SetType(const image_request_t value);
   const image_request_t GetType() const;
-  void SetCurrentFilename(std::unique_ptr<std::string> fn);
-  const std::string GetCurrentFilename() const;
+  /**
+   * Copies the name, names longer than IMAGE_REQUEST_FILENAME_MAX are truncated
+   */
+  void SetCurrentFilename(const char *fn);
+  const char *GetCurrentFilename() const;
   inline SrcType GetSource() const {return source;}
   inline void SetSource(const SrcType value){source = value;}
+  /**
+   * Maximum number of images returned for a Page request, the page starts after
+   * the image named by the current filename (or at the first image if empty)
+   */
+  inline uint8_t GetPageCount() const {return pageCount;}
+  inline void SetPageCount(const uint8_t value){pageCount = value;}
 
 
   private:
   SrcType source;
   image_request_t type;
-  std::unique_ptr<std::string> currentFilename;
+  uint8_t pageCount;
+  char currentFilename[IMAGE_REQUEST_FILENAME_MAX + 1];
 };
 
 template <typename SrcType>
-ImageRequest<SrcType>::ImageRequest()
+ImageRequest<SrcType>::ImageRequest() : type(image_request_t::Empty), pageCount(0), currentFilename{}
 {
   
 }
 
 template <typename SrcType>
-ImageRequest<SrcType>::ImageRequest(image_request_t request, SrcType source) : source(source), type(request)
-{
-}
-
-template <typename SrcType>
-ImageRequest<SrcType>::ImageRequest(const ImageRequest<SrcType>& src)
-  : source(src.source), type(src.type)
-{
-  if (src.currentFilename)
-    currentFilename = std::make_unique<std::string>(*src.currentFilename);
-}
-
-template <typename SrcType>
-ImageRequest<SrcType>::ImageRequest(ImageRequest<SrcType>&& src)
-  : source(src.source), type(src.type)
+ImageRequest<SrcType>::ImageRequest(image_request_t request, SrcType source) : source(source), type(request), pageCount(0), currentFilename{}
 {
-  currentFilename = std::move(src.currentFilename); 
-}
-
-template <typename SrcType>
-ImageRequest<SrcType>& ImageRequest<SrcType>::operator= (ImageRequest<SrcType>&& src) {
-  type = src.type;
-  source = src.source;
-  currentFilename = std::move(src.currentFilename);
-  return *this;
-}
-
-template <typename SrcType>
-ImageRequest<SrcType>& ImageRequest<SrcType>::operator= (const ImageRequest<SrcType>& src) {
-  type = src.type;
-  source = src.source;
-  currentFilename = std::make_unique<std::string>(*currentFilename);
-  return *this;
 }
 
 template <typename SrcType>
@@ -113,17 +95,16 @@ const image_request_t ImageRequest<SrcType>::GetType() const
 }
 
 template <typename SrcType>
-void ImageRequest<SrcType>::SetCurrentFilename(std::unique_ptr<std::string> fn)
+void ImageRequest<SrcType>::SetCurrentFilename(const char *fn)
 {
-  currentFilename = std::move(fn);
+  strncpy(currentFilename, fn ? fn : "", IMAGE_REQUEST_FILENAME_MAX);
+  currentFilename[IMAGE_REQUEST_FILENAME_MAX] = '\0';
 }
 
 template <typename SrcType>
-const std::string ImageRequest<SrcType>::GetCurrentFilename() const
+const char *ImageRequest<SrcType>::GetCurrentFilename() const
 {
-  if (currentFilename)
-    return *currentFilename;
-  return std::string("");
+  return currentFilename;
 }
 
 }
@@ -22,11 +22,12 @@
 #pragma once
 
 #include <zuluide/observable.h>
-#include <zuluide/queue/safe_queue.h>
+#include <zuluide/queue/slot_queue.h>
 #include "zuluide/pipe/image_request.h"
 #include "zuluide/pipe/image_response_pipe.h"
 #include "ZuluIDE_log.h"
 #include <ide_protocol.h>
+#include <Arduino.h>
 
 #include <algorithm>
 #include <utility>
@@ -57,12 +58,13 @@ public:
    */
   void Reset();
   /**
-   * To be run on the core with SD access, attempt to remove requests from the other core
+   * To be run on the core with SD access, handles queued requests from the other core
+   * until the queue is empty or the time budget is used up
    */
   void ProcessUpdates();
 private:
   bool isUpdating;
-  std::unique_ptr<ImageRequest<SrcType>> imageRequest;
+  ImageRequest<SrcType> imageRequest;
   void notifyObservers();
 
   std::vector<std::function<void(const ImageRequest<SrcType>&)>> observers;
@@ -70,18 +72,7 @@ private:
   /***
       Stores updates that come from another thread. These are processed through class to ProcessUpdates.
     **/
-  zuluide::queue::SafeQueue updateQueue;
-
-  /***
-      Simple class for storing updates.
-    **/
-  class UpdateAction {
-  public:
-    /***
-        If the value is null, ignore.
-      **/
-    std::unique_ptr<ImageRequest<SrcType>> requestImage;
-  };
+  zuluide::queue::SlotQueue<ImageRequest<SrcType>, CONTROL_QUEUE_SLOTS> updateQueue;
 };
 
 template <typename SrcType>
@@ -110,11 +101,8 @@ template <typename SrcType>
 void ImageRequestPipe<SrcType>::notifyObservers() {
   if (!isUpdating) {
     std::for_each(observers.begin(), observers.end(), [this](auto observer) {
-      // Make a copy so observers cannot mutate system state.
-      // This may be overly conservative if we do not do multi-threaded work
-      // and we do not mutate system state in observers. This could be easily
-      // verified given this isn't a public API.
-      observer(ImageRequest<SrcType>(*imageRequest));
+      // Observers get a const reference, so they cannot change the message.
+      observer(imageRequest);
 #ifndef CONTROL_CROSS_CORE_QUEUE
           ide_protocol_poll();
 #endif
@@ -124,29 +112,26 @@ void ImageRequestPipe<SrcType>::notifyObservers() {
 
 template <typename SrcType>
 void ImageRequestPipe<SrcType>::Reset() {
-   updateQueue.Reset(sizeof(ImageRequest<SrcType>*), 5);
+   updateQueue.Reset();
 }
 
 template <typename SrcType>
 void ImageRequestPipe<SrcType>::RequestImageSafe(ImageRequest<SrcType> image_request) {
-  UpdateAction* actionToExecute = new UpdateAction();
-  actionToExecute->requestImage = std::make_unique<ImageRequest<SrcType>>(image_request);
-
-  if(!updateQueue.TryAdd(&actionToExecute)) {
+  if(!updateQueue.TryAdd(std::move(image_request))) {
     logmsg("Requesting image action failed to enqueue.");
   }
 }
 
 template <typename SrcType>
 void ImageRequestPipe<SrcType>::ProcessUpdates() {
-  UpdateAction* actionToExecute;
-  if (updateQueue.TryRemove(&actionToExecute)) {
+  uint32_t start = millis();
+  while (updateQueue.TryRemove(imageRequest)) {
     // An action was on the queue, execute it.
-    if (actionToExecute->requestImage) {
-      imageRequest = std::move(actionToExecute->requestImage);
-      notifyObservers();
+    notifyObservers();
+
+    if ((uint32_t)(millis() - start) >= CONTROL_QUEUE_PROCESS_BUDGET_MS) {
+      break;
     }
-    delete(actionToExecute);
   }
 }
   
@@ -30,7 +30,7 @@
 #include "zuluide/images/image.h"
 
 #include <functional>
-#include <memory>
+#include <utility>
 #include <vector>
 #include <string>
 #include <algorithm>
@@ -38,74 +38,53 @@
 namespace zuluide::pipe {
 
   enum class response_status_t {None, End, More};
+  /**
+   * The image and the request are stored by value, so that moving a response
+   * into a queue slot does not allocate.
+   */
   template <typename SrcType>
   class ImageResponse{
     public:
     ImageResponse();
-    ImageResponse(const ImageResponse& src);
-    ImageResponse(ImageResponse&& src);
-    ImageResponse& operator= (ImageResponse&& src);
-    ImageResponse& operator= (const ImageResponse& src);
 
-    void SetImage(std::unique_ptr<zuluide::images::Image>&& value);
+    void SetImage(zuluide::images::Image&& value);
     void SetStatus(const response_status_t value);
-    void SetRequest(std::unique_ptr<ImageRequest<SrcType>>&& value);
+    void SetRequest(const ImageRequest<SrcType>& value);
     void SetIsLast(const bool value);
     void SetIsFirst(const bool value);
+    void SetPage(std::vector<zuluide::images::Image>&& images, const bool hasMore);
     
-    const zuluide::images::Image GetImage() const;
+    const zuluide::images::Image& GetImage() const;
     const response_status_t GetStatus() const;
-    const ImageRequest<SrcType> GetRequest() const;
+    const ImageRequest<SrcType>& GetRequest() const;
     const bool IsLast() const;
     const bool IsFirst() const;
+    /**
+     * Images returned for a Page request, in alphabetical order
+     */
+    const std::vector<zuluide::images::Image>& GetPageImages() const;
+    /**
+     * True if there are more images after the last one in the page
+     */
+    const bool PageHasMore() const;
 
     private:
     response_status_t status;
-    std::unique_ptr<zuluide::images::Image> image;
-    std::unique_ptr<ImageRequest<SrcType>> request;
+    zuluide::images::Image image;
+    ImageRequest<SrcType> request;
     bool isFirst;
     bool isLast;
+    std::vector<zuluide::images::Image> pageImages;
+    bool pageHasMore;
 
   };
 
 template <typename SrcType>
-ImageResponse<SrcType>::ImageResponse () : status(response_status_t::None), image(nullptr), isFirst(false), isLast(false){
+ImageResponse<SrcType>::ImageResponse () : status(response_status_t::None), image(""), isFirst(false), isLast(false), pageHasMore(false){
 }
 
 template <typename SrcType>
-ImageResponse<SrcType>::ImageResponse(const ImageResponse& src) : status(src.status), isFirst(src.isFirst), isLast(src.isLast) {
-  image = std::make_unique<zuluide::images::Image>(*src.image);
-  request = std::make_unique<ImageRequest<SrcType>>(ImageRequest<SrcType>(*src.request));
-}
-
-template <typename SrcType>
-ImageResponse<SrcType>::ImageResponse(ImageResponse<SrcType>&& src) : status(src.status), isFirst(src.isFirst), isLast(src.isLast) {
-  image = std::move(src.image);
-  request = std::move(src.request);
-}
-
-template <typename SrcType>
-ImageResponse<SrcType>& ImageResponse<SrcType>::operator= (ImageResponse<SrcType>&& src)  {
-  status = src.status;
-  isFirst = src.isFirst;
-  isLast = src.isLast;
-  image = std::move(src.image);
-  request = std::move(src.request);
-  return *this;
-}
-
-template <typename SrcType>
-ImageResponse<SrcType>& ImageResponse<SrcType>::operator= (const ImageResponse<SrcType>& src) {
-  status = src.status;
-  isFirst = src.isFirst;
-  isLast = src.isLast;
-  image = std::make_unique<zuluide::images::Image>(*src.image);
-  request = std::make_unique<ImageRequest<SrcType>>(ImageRequest<SrcType>(*src.request));
-  return *this;
-}
-
-template <typename SrcType>
-void ImageResponse<SrcType>::SetImage(std::unique_ptr<zuluide::images::Image>&& value) {
+void ImageResponse<SrcType>::SetImage(zuluide::images::Image&& value) {
   image = std::move(value);
 }
 
@@ -116,9 +95,9 @@ void ImageResponse<SrcType>::SetStatus(response_status_t value)
 }
 
 template <typename SrcType>
-void ImageResponse<SrcType>::SetRequest(std::unique_ptr<ImageRequest<SrcType>>&& value)
+void ImageResponse<SrcType>::SetRequest(const ImageRequest<SrcType>& value)
 {
-  request = std::move(value);
+  request = value;
 }
 
 template <typename SrcType>
@@ -134,9 +113,16 @@ void ImageResponse<SrcType>::SetIsFirst(bool value)
 }
 
 template <typename SrcType>
-const zuluide::images::Image ImageResponse<SrcType>::GetImage() const
+void ImageResponse<SrcType>::SetPage(std::vector<zuluide::images::Image>&& images, const bool hasMore)
 {
-  return *image;
+  pageImages = std::move(images);
+  pageHasMore = hasMore;
+}
+
+template <typename SrcType>
+const zuluide::images::Image& ImageResponse<SrcType>::GetImage() const
+{
+  return image;
 }
 
 
@@ -147,14 +133,9 @@ const response_status_t ImageResponse<SrcType>::GetStatus() const
 }
 
 template <typename SrcType>
-const ImageRequest<SrcType> ImageResponse<SrcType>::GetRequest() const
+const ImageRequest<SrcType>& ImageResponse<SrcType>::GetRequest() const
 {
-  if (request)
-    return *request; 
-
-  ImageRequest<SrcType> empty_request;
-  empty_request.SetType(image_request_t::Empty);
-  return empty_request;
+  return request;
 }
 
 template <typename SrcType>
@@ -169,5 +150,17 @@ const bool ImageResponse<SrcType>::IsFirst() const
   return isFirst;
 }
 
+template <typename SrcType>
+const std::vector<zuluide::images::Image>& ImageResponse<SrcType>::GetPageImages() const
+{
+  return pageImages;
+}
+
+template <typename SrcType>
+const bool ImageResponse<SrcType>::PageHasMore() const
+{
+  return pageHasMore;
+}
+
 
 }
@@ -24,11 +24,12 @@
 #include <zuluide/pipe/image_response.h>
 #include <zuluide/pipe/image_request.h>
 #include <zuluide/observable.h>
-#include <zuluide/queue/safe_queue.h>
+#include <zuluide/queue/slot_queue.h>
 #include <zuluide/images/image_iterator.h>
 #include <zuluide/i2c/i2c_actions.h>
 #include "zuluide/pipe/image_response_pipe.h"
 #include <ide_protocol.h>
+#include <Arduino.h>
 #include <ZuluIDE_log.h>
 #include <algorithm>
 #include <functional>
@@ -58,7 +59,8 @@ class ImageResponsePipe : public Observable<ImageResponse<SrcType>>
      */
     void ResponseImageSafe(ImageResponse<SrcType> image_response);
     /**
-     * Attempts to remove the requested image sent from queue to send to observers on the core without SD access
+     * Removes queued responses and sends them to observers on the core without SD access,
+     * until the queue is empty or the time budget is used up
      */
     void ProcessUpdates();
 
@@ -66,12 +68,12 @@ class ImageResponsePipe : public Observable<ImageResponse<SrcType>>
     bool isUpdating;
     void notifyObservers();
     std::vector<std::function<void(const ImageResponse<SrcType>&)>> observers;
-    std::unique_ptr<ImageResponse<SrcType>> imageResponse;
+    ImageResponse<SrcType> imageResponse;
 
     /***
         Stores updates that come from another thread. These are processed through class to ProcessUpdates.
       **/
-    zuluide::queue::SafeQueue updateQueue;
+    zuluide::queue::SlotQueue<ImageResponse<SrcType>, CONTROL_QUEUE_SLOTS> updateQueue;
 
     /***
      * Image iterator
@@ -83,14 +85,6 @@ class ImageResponsePipe : public Observable<ImageResponse<SrcType>>
      */
     zuluide::i2c::I2CActions i2cActions;
 
-    /***
-        Simple class for storing updates.
-      **/
-    class UpdateAction {
-    public:
-      std::unique_ptr<ImageResponse<SrcType>> responseImage;
-    };
-
 };
 
 template <typename SrcType>
@@ -101,7 +95,7 @@ ImageResponsePipe<SrcType>::ImageResponsePipe() : isUpdating(false)
 template<typename SrcType>
 void ImageResponsePipe<SrcType>::HandleRequest(ImageRequest<SrcType>& current)
 {
-  std::unique_ptr<ImageResponse<SrcType>> response = std::make_unique<ImageResponse<SrcType>>();
+  ImageResponse<SrcType> response;
   image_request_t request = current.GetType();
 
   switch(request)
@@ -110,63 +104,63 @@ void ImageResponsePipe<SrcType>::HandleRequest(ImageRequest<SrcType>& current)
       imageIterator.MoveNext();
       if(imageIterator.IsEmpty())
       {
-        response->SetStatus(response_status_t::None);
+        response.SetStatus(response_status_t::None);
       }
       else
       {
-        response->SetStatus(imageIterator.IsLast()? response_status_t::End : response_status_t::More);
-        response->SetImage(std::move(std::make_unique<zuluide::images::Image>(imageIterator.Get())));
+        response.SetStatus(imageIterator.IsLast()? response_status_t::End : response_status_t::More);
+        response.SetImage(imageIterator.Get());
       }
       break;
     case image_request_t::Prev:
       imageIterator.MovePrevious();
       if(imageIterator.IsEmpty())
       {
-        response->SetStatus(response_status_t::None);
+        response.SetStatus(response_status_t::None);
       }
       else
       {
-        response->SetStatus(imageIterator.IsFirst() ? response_status_t::End : response_status_t::More);
-        response->SetImage(std::make_unique<zuluide::images::Image>(imageIterator.Get()));
+        response.SetStatus(imageIterator.IsFirst() ? response_status_t::End : response_status_t::More);
+        response.SetImage(imageIterator.Get());
       }
       break;
     case image_request_t::First:
       imageIterator.Reset();
       if(imageIterator.IsEmpty())
       {
-        response->SetStatus(response_status_t::None);
+        response.SetStatus(response_status_t::None);
       }
       else
       {
         imageIterator.MoveNext();
-        response->SetStatus(imageIterator.IsLast() ? response_status_t::End : response_status_t::More);
-        response->SetImage(std::make_unique<zuluide::images::Image>(imageIterator.Get()));
+        response.SetStatus(imageIterator.IsLast() ? response_status_t::End : response_status_t::More);
+        response.SetImage(imageIterator.Get());
       }
       break;
     case image_request_t::Last:
       imageIterator.MoveLast();
       if (imageIterator.IsEmpty())
       {
-        response->SetStatus(response_status_t::None);
+        response.SetStatus(response_status_t::None);
       }
       else
       {
-        response->SetStatus(imageIterator.IsFirst() ? response_status_t::End : response_status_t::More);
-        response->SetImage(std::make_unique<zuluide::images::Image>(imageIterator.Get()));
+        response.SetStatus(imageIterator.IsFirst() ? response_status_t::End : response_status_t::More);
+        response.SetImage(imageIterator.Get());
       }
       break;
    case image_request_t::Current:
-      if (!current.GetCurrentFilename().empty())
+      if (current.GetCurrentFilename()[0] != '\0')
       {
-        imageIterator.MoveToFile(current.GetCurrentFilename().c_str());
+        imageIterator.MoveToFile(current.GetCurrentFilename());
         if (imageIterator.IsEmpty())
         {
-          response->SetStatus(response_status_t::None);
+          response.SetStatus(response_status_t::None);
         }
         else
         {
-          response->SetStatus(imageIterator.IsLast() ? response_status_t::End : response_status_t::More);
-          response->SetImage(std::move(std::make_unique<zuluide::images::Image>(imageIterator.Get())));
+          response.SetStatus(imageIterator.IsLast() ? response_status_t::End : response_status_t::More);
+          response.SetImage(imageIterator.Get());
         }
       }
       else
@@ -175,15 +169,24 @@ void ImageResponsePipe<SrcType>::HandleRequest(ImageRequest<SrcType>& current)
         imageIterator.MoveFirst();
         if (imageIterator.IsEmpty())
         {
-          response->SetStatus(response_status_t::None);
+          response.SetStatus(response_status_t::None);
         }
         else
         {
-          response->SetStatus(imageIterator.IsLast() ? response_status_t::End : response_status_t::More);
-          response->SetImage(std::make_unique<zuluide::images::Image>(imageIterator.Get()));
+          response.SetStatus(imageIterator.IsLast() ? response_status_t::End : response_status_t::More);
+          response.SetImage(imageIterator.Get());
         }
       }
       break;
+    case image_request_t::Page:
+      {
+        std::vector<zuluide::images::Image> images;
+        bool more;
+        imageIterator.GetPage(current.GetCurrentFilename(), current.GetPageCount(), images, more);
+        response.SetStatus(images.empty() ? response_status_t::None : (more ? response_status_t::More : response_status_t::End));
+        response.SetPage(std::move(images), more);
+      }
+      break;
     // The following don't get queued for processing
     case image_request_t::Cleanup:
       dbgmsg("Image response pipe is cleaning up");
@@ -204,12 +207,10 @@ void ImageResponsePipe<SrcType>::HandleRequest(ImageRequest<SrcType>& current)
   
   // All request but clean up and reset get passed
 
-  response->SetIsFirst(imageIterator.IsFirst());
-  response->SetIsLast(imageIterator.IsLast());
-  response->SetRequest(std::move(std::make_unique<ImageRequest<SrcType>>(current)));
-  UpdateAction* actionToExecute = new UpdateAction();
-  actionToExecute->responseImage = std::move(response);
-  if(!updateQueue.TryAdd(&actionToExecute)) {
+  response.SetIsFirst(imageIterator.IsFirst());
+  response.SetIsLast(imageIterator.IsLast());
+  response.SetRequest(current);
+  if(!updateQueue.TryAdd(std::move(response))) {
     logmsg("Responding image action failed to enqueue.");
   }
 }
@@ -234,11 +235,9 @@ template<typename SrcType>
 void ImageResponsePipe<SrcType>::notifyObservers() {
   if (!isUpdating) {
     std::for_each(observers.begin(), observers.end(), [this](auto observer) {
-      // Make a copy so observers cannot mutate system state.
-      // This may be overly conservative if we do not do multi-threaded work
-      // and we do not mutate system state in observers. This could be easily
-      // verified given this isn't a public API.
-      observer(ImageResponse<SrcType>(*imageResponse));
+      // Observers get a const reference, copying the message would allocate
+      // for the image names it holds.
+      observer(imageResponse);
 #ifndef CONTROL_CROSS_CORE_QUEUE
           ide_protocol_poll();
 #endif
@@ -248,30 +247,27 @@ void ImageResponsePipe<SrcType>::notifyObservers() {
 
 template<typename SrcType>
 void ImageResponsePipe<SrcType>::Reset() {
-   updateQueue.Reset(sizeof(UpdateAction*), 5);
+   updateQueue.Reset();
    imageIterator.Reset();
 }
 
 template<typename SrcType>
 void ImageResponsePipe<SrcType>::ResponseImageSafe(ImageResponse<SrcType> image_response) {
-  UpdateAction* actionToExecute = new UpdateAction();
-  actionToExecute->responseImage = std::make_unique<ImageResponse<SrcType>>(image_response);
-  if(!updateQueue.TryAdd(&actionToExecute)) {
+  if(!updateQueue.TryAdd(std::move(image_response))) {
     logmsg("Responding image action failed to enqueue.");
   }
 }
 
 template<typename SrcType>
 void ImageResponsePipe<SrcType>::ProcessUpdates() {
-  UpdateAction* actionToExecute;
-  if (updateQueue.TryRemove(&actionToExecute)) {
+  uint32_t start = millis();
+  while (updateQueue.TryRemove(imageResponse)) {
     // An action was on the queue, execute it.
-    if (actionToExecute) {
-      imageResponse = std::move(actionToExecute->responseImage);
-      actionToExecute->responseImage = nullptr;
-      notifyObservers();
+    notifyObservers();
+
+    if ((uint32_t)(millis() - start) >= CONTROL_QUEUE_PROCESS_BUDGET_MS) {
+      break;
     }
-    delete(actionToExecute);
   }
 }
 }
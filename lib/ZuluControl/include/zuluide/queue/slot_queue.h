@@ -0,0 +1,117 @@
+/**
+ * ZuluIDE™ - Copyright (c) 2025 Rabbit Hole Computing™
+ *
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version. 
+ *
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version. 
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. 
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#pragma once
+
+#include <stdint.h>
+#include <utility>
+#include <zuluide/queue/safe_queue.h>
+
+// Number of messages that can be pending in each control queue
+#ifndef CONTROL_QUEUE_SLOTS
+#define CONTROL_QUEUE_SLOTS 8
+#endif
+
+// Maximum time ProcessUpdates() spends handling queued messages per call
+#ifndef CONTROL_QUEUE_PROCESS_BUDGET_MS
+#define CONTROL_QUEUE_PROCESS_BUDGET_MS 5
+#endif
+
+namespace zuluide::queue
+{
+    // Fixed capacity queue for passing messages of type T between cores.
+    // Messages are moved into statically allocated slots, only pointers to
+    // the slots go through the underlying SafeQueues. A slot is owned by
+    // either the free list, the producer, the pending list or the consumer,
+    // so no further locking is needed.
+    template <class T, uint32_t N> class SlotQueue {
+        public:
+            // Initialize the queue, all slots become free
+            void Reset()
+            {
+                freeQueue.Reset(sizeof(T*), N);
+                pendingQueue.Reset(sizeof(T*), N);
+                for (uint32_t i = 0; i < N; i++)
+                {
+                    T *slot = &slots[i];
+                    freeQueue.TryAdd(&slot);
+                }
+            }
+
+            // Move item into a free slot and queue it
+            // \returns false if all slots are in use, item is left unchanged
+            bool TryAdd(T &&item)
+            {
+                T *slot;
+                if (!freeQueue.TryRemove(&slot))
+                {
+                    return false;
+                }
+
+                *slot = std::move(item);
+                pendingQueue.TryAdd(&slot);
+                return true;
+            }
+
+            // Copy item into a free slot and queue it. Assigning over the previous
+            // contents of the slot lets T reuse the memory it already owns.
+            // \returns false if all slots are in use
+            bool TryAdd(const T &item)
+            {
+                T *slot;
+                if (!freeQueue.TryRemove(&slot))
+                {
+                    return false;
+                }
+
+                *slot = item;
+                pendingQueue.TryAdd(&slot);
+                return true;
+            }
+
+            // Move the oldest queued item out and free its slot. The previous
+            // contents of item go to the slot, where the next TryAdd() reuses them.
+            // \returns true if an item was removed
+            bool TryRemove(T &item)
+            {
+                T *slot;
+                if (!pendingQueue.TryRemove(&slot))
+                {
+                    return false;
+                }
+
+                std::swap(item, *slot);
+                freeQueue.TryAdd(&slot);
+                return true;
+            }
+
+            // Get the current number of queued items
+            uint32_t GetLevel()
+            {
+                return pendingQueue.GetLevel();
+            }
+
+        private:
+            T slots[N];
+            SafeQueue freeQueue;
+            SafeQueue pendingQueue;
+    };
+}
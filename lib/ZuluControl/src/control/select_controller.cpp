@@ -42,7 +42,7 @@ DisplayState SelectController::Reset() {
   ImageRequest<select_controller_source_t> request;
   if (currentStatus.HasLoadedImage()) {
     // Lets try to move the iterator to the currently selected image.
-    request.SetCurrentFilename(std::make_unique<std::string>(currentStatus.GetLoadedImage().GetFilename()));
+    request.SetCurrentFilename(currentStatus.GetLoadedImage().GetFilename().c_str());
     request.SetType(image_request_t::Current);
     imageRequestPipe->RequestImageSafe(request);
   }
@@ -36,12 +36,14 @@ i2c_inst_t* g_i2c = nullptr;
 int g_hdr_channel = -1;
 int g_data_channel = -1;
 bool g_initialized = false;
+bool g_async_active = false;
 
 // Referenced asynchronously by DMA hardware -- must have a stable address for the
 // duration of a transfer, so these are static/file-scope rather than stack-local.
 // Every entry is widened to 16 bits so the STOP control bit (bit 9 of
 // IC_DATA_CMD) can be embedded in the last payload word.
 uint16_t g_header_buf[3];
+uint16_t g_header_len = 0;
 uint16_t g_data_buf[I2C_UPGRADE_MAX_CHUNK];
 
 // Table-driven software CRC32:
@@ -109,6 +111,41 @@ bool WaitForChannelOrAbort(i2c_inst_t* i2c, uint channel, absolute_time_t until)
     return true;
 }
 
+// Configures the chained header/data channels for g_header_len header words
+// followed by `length` data words, retargets the I2C peripheral to `addr`
+// and starts the transfer.
+void StartTransfer(i2c_inst_t* i2c, uint8_t addr, uint16_t length) {
+    dma_channel_config hdr_cfg = dma_channel_get_default_config(g_hdr_channel);
+    channel_config_set_transfer_data_size(&hdr_cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&hdr_cfg, true);
+    channel_config_set_write_increment(&hdr_cfg, false);
+    channel_config_set_dreq(&hdr_cfg, i2c_get_dreq(i2c, true));
+    channel_config_set_chain_to(&hdr_cfg, g_data_channel);
+    dma_channel_configure(g_hdr_channel, &hdr_cfg, &i2c_get_hw(i2c)->data_cmd, g_header_buf, g_header_len, false);
+
+    dma_channel_config data_cfg = dma_channel_get_default_config(g_data_channel);
+    channel_config_set_transfer_data_size(&data_cfg, DMA_SIZE_16);
+    channel_config_set_read_increment(&data_cfg, true);
+    channel_config_set_write_increment(&data_cfg, false);
+    channel_config_set_dreq(&data_cfg, i2c_get_dreq(i2c, true));
+    channel_config_set_chain_to(&data_cfg, g_data_channel);  // no further chaining
+    dma_channel_configure(g_data_channel, &data_cfg, &i2c_get_hw(i2c)->data_cmd, g_data_buf, length, false);
+
+    i2c_get_hw(i2c)->enable = 0;
+    i2c_get_hw(i2c)->tar = addr;
+    i2c_get_hw(i2c)->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS;
+    i2c_get_hw(i2c)->enable = 1;
+
+    // Clear any stale STOP_DET/TX_ABRT left set by a prior transaction (e.g. a
+    // Wire-based control message) -- WaitForChannelOrAbort below treats these
+    // as proof *this* transaction completed, so a leftover bit would make it
+    // return success (or a false abort) instantly, before any real bytes go out.
+    i2c_get_hw(i2c)->clr_stop_det;
+    i2c_get_hw(i2c)->clr_tx_abrt;
+
+    dma_channel_start(g_hdr_channel);  // chains automatically into g_data_channel
+}
+
 }  // namespace
 
 // dma_claim_unused_channel() is NOT safe to use here: several DMA channels in
@@ -135,11 +172,17 @@ bool I2CMasterDmaSendChunk(uint8_t addr, uint8_t cmd, const uint8_t* payload,
         return false;
     }
 
+    // A display update may still be finishing on the wire.
+    if (!I2CMasterDmaFinish(until)) {
+        return false;
+    }
+
     i2c_inst_t* i2c = g_i2c;
 
     g_header_buf[0] = cmd;
     g_header_buf[1] = (length >> 8) & 0xFF;
     g_header_buf[2] = length & 0xFF;
+    g_header_len = 3;
     for (uint16_t i = 0; i < length; i++) {
         g_data_buf[i] = payload[i];
     }
@@ -149,35 +192,7 @@ bool I2CMasterDmaSendChunk(uint8_t addr, uint8_t cmd, const uint8_t* payload,
     // *out_sent_crc to decide whether to retry.
     g_data_buf[length - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
 
-    dma_channel_config hdr_cfg = dma_channel_get_default_config(g_hdr_channel);
-    channel_config_set_transfer_data_size(&hdr_cfg, DMA_SIZE_16);
-    channel_config_set_read_increment(&hdr_cfg, true);
-    channel_config_set_write_increment(&hdr_cfg, false);
-    channel_config_set_dreq(&hdr_cfg, i2c_get_dreq(i2c, true));
-    channel_config_set_chain_to(&hdr_cfg, g_data_channel);
-    dma_channel_configure(g_hdr_channel, &hdr_cfg, &i2c_get_hw(i2c)->data_cmd, g_header_buf, 3, false);
-
-    dma_channel_config data_cfg = dma_channel_get_default_config(g_data_channel);
-    channel_config_set_transfer_data_size(&data_cfg, DMA_SIZE_16);
-    channel_config_set_read_increment(&data_cfg, true);
-    channel_config_set_write_increment(&data_cfg, false);
-    channel_config_set_dreq(&data_cfg, i2c_get_dreq(i2c, true));
-    channel_config_set_chain_to(&data_cfg, g_data_channel);  // no further chaining
-    dma_channel_configure(g_data_channel, &data_cfg, &i2c_get_hw(i2c)->data_cmd, g_data_buf, length, false);
-
-    i2c_get_hw(i2c)->enable = 0;
-    i2c_get_hw(i2c)->tar = addr;
-    i2c_get_hw(i2c)->dma_cr = I2C_IC_DMA_CR_TDMAE_BITS;
-    i2c_get_hw(i2c)->enable = 1;
-
-    // Clear any stale STOP_DET/TX_ABRT left set by a prior transaction (e.g. a
-    // Wire-based control message) -- WaitForChannelOrAbort below treats these
-    // as proof *this* transaction completed, so a leftover bit would make it
-    // return success (or a false abort) instantly, before any real bytes go out.
-    i2c_get_hw(i2c)->clr_stop_det;
-    i2c_get_hw(i2c)->clr_tx_abrt;
-
-    dma_channel_start(g_hdr_channel);  // chains automatically into g_data_channel
+    StartTransfer(i2c, addr, length);
 
     // The DMA engine now streams the header+payload out over the wire
     // autonomously, paced by the I2C TX DREQ, with no further CPU
@@ -202,4 +217,33 @@ bool I2CMasterDmaSendChunk(uint8_t addr, uint8_t cmd, const uint8_t* payload,
     return true;
 }
 
+bool I2CMasterDmaWriteAsync(uint8_t addr, uint8_t prefix, const uint8_t* payload,
+                            uint16_t length) {
+    if (!g_initialized || g_async_active || length == 0 || length > I2C_UPGRADE_MAX_CHUNK) {
+        return false;
+    }
+
+    g_header_buf[0] = prefix;
+    g_header_len = 1;
+    for (uint16_t i = 0; i < length; i++) {
+        g_data_buf[i] = payload[i];
+    }
+    g_data_buf[length - 1] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    StartTransfer(g_i2c, addr, length);
+    g_async_active = true;
+    return true;
+}
+
+bool I2CMasterDmaFinish(absolute_time_t until) {
+    if (!g_async_active) {
+        return true;
+    }
+
+    bool ok = WaitForChannelOrAbort(g_i2c, g_data_channel, until);
+    i2c_get_hw(g_i2c)->dma_cr = 0;
+    g_async_active = false;
+    return ok;
+}
+
 }  // namespace zuluide::i2c
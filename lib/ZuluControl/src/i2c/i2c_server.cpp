@@ -248,21 +248,22 @@ bool I2CServer::UpgradeZuluControlFwReadAck(uint16_t* outLength, uint32_t* outCr
 
 void I2CServer::HandleImageResponse(const ImageResponse<i2c_server_source_t>& response)
 {
-
-  const std::unique_ptr<ImageResponse<i2c_server_source_t>> image_response  = std::make_unique<ImageResponse<i2c_server_source_t>>(response);
-  switch (image_response->GetRequest().GetSource())
+  switch (response.GetRequest().GetSource())
   {
     case i2c_server_source_t::FetchFilenames:
-      HandleFetchFilenames(std::move(image_response));
+      HandleFetchFilenames(response);
       break;
     case i2c_server_source_t::FetchImages:
-      HandleFetchImages(std::move(image_response));
+      HandleFetchImages(response);
       break;
     case i2c_server_source_t::FetchImage:
-      HandleFetchImage(std::move(image_response));
+      HandleFetchImage(response);
       break;
     case i2c_server_source_t::SetToCurrent:
-      HandleSetToCurrent(std::move(image_response));
+      HandleSetToCurrent(response);
+      break;
+    case i2c_server_source_t::FetchImagesPage:
+      HandleFetchImagesPage(response);
       break;
     case i2c_server_source_t::None:
       // do nothing
@@ -270,9 +271,9 @@ void I2CServer::HandleImageResponse(const ImageResponse<i2c_server_source_t>& re
   }
 }
 
-void I2CServer::HandleFetchFilenames(const std::unique_ptr<ImageResponse<i2c_server_source_t>>&& response)
+void I2CServer::HandleFetchFilenames(const ImageResponse<i2c_server_source_t>& response)
 {
-  response_status_t status = response->GetStatus();
+  response_status_t status = response.GetStatus();
   static bool hit_end = false;
   if (hit_end == true || status == response_status_t::None)
   {
@@ -289,7 +290,7 @@ void I2CServer::HandleFetchFilenames(const std::unique_ptr<ImageResponse<i2c_ser
   else 
   {
     filenameTransferState = FilenameTransferState::Received;
-    auto msgBuf = response->GetImage().GetFilename();
+    const auto &msgBuf = response.GetImage().GetFilename();
     writeLengthPrefacedString(wire, I2C_SERVER_IMAGE_FILENAME, msgBuf.size(), msgBuf.c_str());
     if (status == response_status_t::End)
     {
@@ -298,10 +299,10 @@ void I2CServer::HandleFetchFilenames(const std::unique_ptr<ImageResponse<i2c_ser
   }
 }
 
-void I2CServer::HandleFetchImages(const std::unique_ptr<ImageResponse<i2c_server_source_t>>&& response)
+void I2CServer::HandleFetchImages(const ImageResponse<i2c_server_source_t>& response)
 {
   static bool hit_end = false;
-  response_status_t status = response->GetStatus();
+  response_status_t status = response.GetStatus();
   if (status == response_status_t::None || hit_end)
   {  
     if (hit_end)
@@ -319,7 +320,7 @@ void I2CServer::HandleFetchImages(const std::unique_ptr<ImageResponse<i2c_server
   }
   else
   {
-    auto msgBuf = response->GetImage().ToJson();
+    auto msgBuf = response.GetImage().ToJson();
     writeLengthPrefacedString(wire, I2C_SERVER_IMAGE_JSON, msgBuf.size(), msgBuf.c_str());
 
     hit_end = status == response_status_t::End;
@@ -329,10 +330,10 @@ void I2CServer::HandleFetchImages(const std::unique_ptr<ImageResponse<i2c_server
   }
 }
 
-void I2CServer::HandleFetchImage(const std::unique_ptr<ImageResponse<i2c_server_source_t>>&& response)
+void I2CServer::HandleFetchImage(const ImageResponse<i2c_server_source_t>& response)
 {
     static bool hit_end = false;
-    response_status_t status = response->GetStatus();
+    response_status_t status = response.GetStatus();
   if (status == response_status_t::None || hit_end)
   {
     if (hit_end)
@@ -349,18 +350,53 @@ void I2CServer::HandleFetchImage(const std::unique_ptr<ImageResponse<i2c_server_
   }
   else
   {
-    auto msgBuf = response->GetImage().ToJson();
+    auto msgBuf = response.GetImage().ToJson();
     writeLengthPrefacedString(wire, I2C_SERVER_IMAGE_JSON, msgBuf.size(), msgBuf.c_str());
   }
 }
 
-void I2CServer::HandleSetToCurrent(const std::unique_ptr<ImageResponse<i2c_server_source_t>>&& response)
+void I2CServer::HandleSetToCurrent(const ImageResponse<i2c_server_source_t>& response)
 {
-  if (response->GetStatus() != response_status_t::None)
-    deviceControl->LoadImageSafe(response->GetImage());
+  if (response.GetStatus() != response_status_t::None)
+    deviceControl->LoadImageSafe(response.GetImage());
   RequestCleanup(i2c_server_source_t::SetToCurrent);
 }
 
+void I2CServer::HandleFetchImagesPage(const ImageResponse<i2c_server_source_t>& response)
+{
+  // Pack as many images as fit in one message, the client asks for the
+  // next page starting after the last filename it received. The first image
+  // is always sent so that the client cursor moves even if it does not fit.
+  bool more = response.PageHasMore();
+  std::string msgBuf = "{\"more\":";
+  const size_t tail = strlen("true,\"images\":[]}");
+  std::string images;
+  for (const auto& image : response.GetPageImages())
+  {
+    std::string json = image.ToJson();
+    if (!images.empty() && msgBuf.size() + tail + images.size() + json.size() + 1 > I2C_IMAGE_PAGE_MAX_BYTES)
+    {
+      more = true;
+      break;
+    }
+
+    if (!images.empty())
+      images.append(",");
+    images.append(json);
+  }
+
+  msgBuf.append(more ? "true" : "false");
+  msgBuf.append(",\"images\":[");
+  msgBuf.append(images);
+  msgBuf.append("]}");
+  writeLengthPrefacedString(wire, I2C_SERVER_IMAGES_PAGE_JSON, msgBuf.size(), msgBuf.c_str());
+
+  if (!more)
+  {
+    RequestCleanup(i2c_server_source_t::FetchImagesPage);
+  }
+}
+
 void I2CServer::RequestWiFiConnect(const i2c_server_source_t source)
 {
       ImageRequest<i2c_server_source_t> connect(image_request_t::WiFiConnect, source);
@@ -580,8 +616,8 @@ void I2CServer::Poll() {
 
         RequestReset(i2c_server_source_t::SetToCurrent);
         ImageRequest<i2c_server_source_t> current(image_request_t::Current, i2c_server_source_t::SetToCurrent);
-        current.SetCurrentFilename(std::make_unique<std::string>(buffer));
-        logmsg("I2C Client requested the current image be set to: ", current.GetCurrentFilename().c_str());
+        current.SetCurrentFilename(buffer);
+        logmsg("I2C Client requested the current image be set to: ", current.GetCurrentFilename());
         imageRequestPipe->RequestImageSafe(current);
         ExitLoggingSafe();
       }
@@ -629,6 +665,50 @@ void I2CServer::Poll() {
     break;
   }
 
+  case I2C_CLIENT_FETCH_IMAGES_PAGE: {
+    uint16_t length = ReadInLength(wire);
+
+    if (length > 0) {
+      char* buffer = new char[length + 1];
+      memset(buffer, 0, length + 1);
+
+      bool i2c_read_timeout = false;
+      for (int pos = 0; pos < length && !i2c_read_timeout;) {
+        int toRecv = pos + BUFFER_LENGTH < length ? BUFFER_LENGTH : length - pos;
+
+        wire->requestFrom(CLIENT_ADDR, toRecv);
+        while (toRecv > 0) {
+          if (!WireAvailableTimeout(wire)) {
+            i2c_read_timeout = true;
+            break;
+          }
+#ifndef CONTROL_CROSS_CORE_QUEUE
+          ide_protocol_poll();
+#endif
+          buffer[pos++] = wire->read();
+          toRecv--;
+        }
+      }
+
+      if (!i2c_read_timeout) {
+        uint8_t count = (uint8_t)buffer[0];
+        ImageRequest<i2c_server_source_t> page(image_request_t::Page, i2c_server_source_t::FetchImagesPage);
+        page.SetPageCount(count ? count : IMAGE_PAGE_MAX_ENTRIES);
+        page.SetCurrentFilename(buffer + 1);
+        imageRequestPipe->RequestImageSafe(page);
+      }
+
+      delete[] buffer;
+    }
+    else {
+      EnterLoggingSafe();
+      logmsg("Length was 0 for fetch images page request.");
+      ExitLoggingSafe();
+    }
+
+    break;
+  }
+
   case I2C_CLIENT_FETCH_ITR_IMAGE: {
     EnterLoggingSafe();
     if (ReadInLength(wire) != 0) {
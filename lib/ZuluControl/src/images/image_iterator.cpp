@@ -235,6 +235,62 @@ bool ImageIterator::MoveToFile(const char *filename)
   return false;
 }
 
+int ImageIterator::GetPage(const char *after, int maxCount, std::vector<Image> &images, bool &more)
+{
+  static char names[IMAGE_PAGE_MAX_ENTRIES][MAX_FILE_PATH + 1];
+  static char name[MAX_FILE_PATH + 1];
+
+  images.clear();
+  more = false;
+  if (maxCount > IMAGE_PAGE_MAX_ENTRIES) maxCount = IMAGE_PAGE_MAX_ENTRIES;
+  if (maxCount <= 0 || (!root.isOpen() && !root.open("/"))) {
+    return 0;
+  }
+
+  // Keep the alphabetically first maxCount names after 'after' in sorted order
+  int count = 0;
+  FsFile file;
+  root.rewindDirectory();
+  while (file.openNext(&root, O_RDONLY)) {
+    size_t len = file.getName(name, sizeof(name));
+    bool isValid = len < sizeof(name) - 1 && fileIsValidImage(file, name);
+    file.close();
+
+    if (!isValid || (after[0] && strcasecmp(name, after) <= 0)) {
+      continue;
+    }
+
+    int pos = count;
+    while (pos > 0 && strcasecmp(names[pos - 1], name) > 0) {
+      pos--;
+    }
+
+    if (pos >= maxCount) {
+      more = true;
+      continue;
+    }
+
+    if (count == maxCount) {
+      // Drop the last name to make room
+      more = true;
+      count--;
+    }
+
+    memmove(names[pos + 1], names[pos], (count - pos) * sizeof(names[0]));
+    memcpy(names[pos], name, sizeof(names[0]));
+    count++;
+  }
+
+  images.reserve(count);
+  for (int i = 0; i < count; i++) {
+    if (MoveToFile(names[i])) {
+      images.push_back(Get());
+    }
+  }
+
+  return images.size();
+}
+
 void ImageIterator::Cleanup() {
   if (currentFile.isOpen()) {
     currentFile.close();
@@ -26,6 +26,7 @@
 
 #include "ZuluIDE_log.h"
 #include <ide_protocol.h>
+#include <Arduino.h>
 
 #include <algorithm>
 #include <utility>
@@ -81,8 +82,7 @@ void StatusController::notifyObservers() {
     });
 
     std::for_each(observerQueues.begin(), observerQueues.end(), [this](auto observer) {
-      SystemStatus *update = new SystemStatus(status);
-      observer->TryAdd(&update);
+      observer->TryAdd(status);
     });
   }
 }
@@ -97,7 +97,7 @@ const SystemStatus& StatusController::GetStatus() {
 }
 
 void StatusController::Reset() {
-  updateQueue.Reset(sizeof(UpdateAction*), 5);
+  updateQueue.Reset();
 }
 
 void StatusController::LoadImage(zuluide::images::Image i) {
@@ -106,39 +106,35 @@ void StatusController::LoadImage(zuluide::images::Image i) {
 }
 
 void StatusController::LoadImageSafe(zuluide::images::Image i) {
-  UpdateAction* actionToExecute = new UpdateAction();
-  actionToExecute->ToLoad = std::make_unique<zuluide::images::Image>(i);
-  actionToExecute->IsEject = false;
-  if(!updateQueue.TryAdd(&actionToExecute)) {
+  if(!updateQueue.TryAdd(UpdateAction(false, std::move(i)))) {
     logmsg("Load image failed to enqueue.");
   }
 }
 
 void StatusController::EjectImageSafe() {
-  UpdateAction* actionToExecute = new UpdateAction();
-  actionToExecute->IsEject = true;
-  if(!updateQueue.TryAdd(&actionToExecute)) {
+  if(!updateQueue.TryAdd(UpdateAction(true, zuluide::images::Image("")))) {
     logmsg("Eject image failed to enqueue.");
   }
 }
 
 void StatusController::ProcessUpdates() {
-  UpdateAction* actionToExecute;
-  if (updateQueue.TryRemove(&actionToExecute)) {
+  uint32_t start = millis();
+  UpdateAction actionToExecute;
+  while (updateQueue.TryRemove(actionToExecute)) {
     // An action was on the queue, execute it.
-    if (actionToExecute->ToLoad) {
-      LoadImage(*actionToExecute->ToLoad);
+    if (actionToExecute.IsEject) {
+      EjectImage();
     } else {
-      if (actionToExecute->IsEject){
-        EjectImage();
-      }
+      LoadImage(actionToExecute.ToLoad);
+    }
+
+    if ((uint32_t)(millis() - start) >= CONTROL_QUEUE_PROCESS_BUDGET_MS) {
+      break;
     }
-   
-    delete(actionToExecute);
   }
 }
 
-void StatusController::AddObserver(zuluide::queue::SafeQueue* dest) {
+void StatusController::AddObserver(zuluide::queue::SlotQueue<SystemStatus, CONTROL_QUEUE_SLOTS>* dest) {
   observerQueues.push_back(dest);
 }
 
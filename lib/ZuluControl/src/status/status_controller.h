@@ -33,6 +33,7 @@
 #include <zuluide/observable_safe.h>
 #include <zuluide/status/device_control_safe.h>
 #include <zuluide/queue/safe_queue.h>
+#include <zuluide/queue/slot_queue.h>
 
 #include <functional>
 #include <memory>
@@ -45,7 +46,7 @@ namespace zuluide::status {
   public:
     StatusController();
     void AddObserver(std::function<void(const SystemStatus& current)> callback);
-    void AddObserver(zuluide::queue::SafeQueue* dest);
+    void AddObserver(zuluide::queue::SlotQueue<SystemStatus, CONTROL_QUEUE_SLOTS>* dest);
     void LoadImage(zuluide::images::Image i);
     void EjectImage();
     void BeginUpdate();
@@ -69,32 +70,34 @@ namespace zuluide::status {
     std::vector<std::function<void(const SystemStatus&)>> observers;
     SystemStatus status;
     /***
-        Stores queues where updated system status pointers are copied.
+        Stores queues where updated system status is copied.
      **/
-    std::vector<zuluide::queue::SafeQueue*> observerQueues;
-    /***
-        Stores updates that come from another thread. These are processed through class to ProcessUpdates.
-     **/
-    zuluide::queue::SafeQueue updateQueue;
-
-    /***
-        Receives updates that come from another thread in the opposite direction of the updateQueue 
-     */
-    zuluide::queue::SafeQueue receiveQueue;
-
+    std::vector<zuluide::queue::SlotQueue<SystemStatus, CONTROL_QUEUE_SLOTS>*> observerQueues;
     /***
         Simple class for storing updates. As we currently only have the load or eject image updates,
         this class is overly simple.
      **/
     class UpdateAction {
     public:
+      UpdateAction() : IsEject(false), ToLoad("") {}
+      UpdateAction(bool isEject, zuluide::images::Image toLoad) : IsEject(isEject), ToLoad(std::move(toLoad)) {}
       /***
-          If the value is null, this is an eject.
+          If true, this is an eject and ToLoad is ignored.
        **/
       bool IsEject;
-      std::unique_ptr<zuluide::images::Image> ToLoad;
+      zuluide::images::Image ToLoad;
     };
 
+    /***
+        Stores updates that come from another thread. These are processed through class to ProcessUpdates.
+     **/
+    zuluide::queue::SlotQueue<UpdateAction, CONTROL_QUEUE_SLOTS> updateQueue;
+
+    /***
+        Receives updates that come from another thread in the opposite direction of the updateQueue 
+     */
+    zuluide::queue::SafeQueue receiveQueue;
+
     /***
         Simple class for storing updates. As we currently only have the load or eject image updates,
         this class is overly simple.
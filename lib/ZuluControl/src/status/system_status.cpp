@@ -77,7 +77,11 @@ SystemStatus& SystemStatus::operator= (const SystemStatus& src) {
   }
 
   if (src.loadedImage) {
-    loadedImage = std::make_unique<zuluide::images::Image>(*src.loadedImage);
+    // Reuse the existing image, e.g. in a queue slot, so its name buffer is reused
+    if (loadedImage)
+      *loadedImage = *src.loadedImage;
+    else
+      loadedImage = std::make_unique<zuluide::images::Image>(*src.loadedImage);
   }
   else
   {
@@ -130,6 +130,38 @@ static void snd_process_b() {
     snd_encode((int16_t *)sample_buf_b, (int16_t*)(output_buf_b), AUDIO_BUFFER_SIZE/2);
 }
 
+// Ticket of the last buffer queued to the second core
+static uint32_t snd_process_ticket = 0;
+
+static void snd_process_job(void *param) {
+    volatile bufstate *state = (volatile bufstate*)param;
+    if (state == &sbufst_a)
+        snd_process_a();
+    else
+        snd_process_b();
+    *state = READY;
+}
+
+// Encode a filled buffer, on the second core if it is available
+static void snd_process(volatile bufstate *state) {
+    *state = PROCESSING;
+#ifdef PLATFORM_HAS_CORE1_WORKER
+    uint32_t ticket = platform_core1_submit(snd_process_job, (void*)state);
+    if (ticket != 0) {
+        snd_process_ticket = ticket;
+        return;
+    }
+#endif
+    snd_process_job((void*)state);
+}
+
+// Wait until the second core is no longer writing to the output buffers
+static void snd_process_wait() {
+#ifdef PLATFORM_HAS_CORE1_WORKER
+    platform_core1_wait(snd_process_ticket);
+#endif
+}
+
 
 
 /**********************************************************************************************
@@ -412,6 +444,7 @@ void audio_poll() {
     {
         if (set_pause_buf)
         {
+            snd_process_wait();
             memset(output_buf_a, 0, sizeof(output_buf_a));
             memset(output_buf_b, 0, sizeof(output_buf_b));
         }
@@ -502,18 +535,16 @@ void audio_poll() {
 
 
     if (sbufst_a == FILLING) {
-        sbufst_a = PROCESSING;
-        snd_process_a();
-        sbufst_a = READY;
+        snd_process(&sbufst_a);
     } else if (sbufst_b == FILLING) {
-        sbufst_b = PROCESSING;
-        snd_process_b();
-        sbufst_b = READY;
+        snd_process(&sbufst_b);
     }
 }
 
 static void audio_start_dma()
 {
+    snd_process_wait();
+
     // read in initial sample buffers
     if (within_gap)
     {
@@ -530,6 +561,7 @@ static void audio_start_dma()
         audio_poll();
         sbufsel = A;
         audio_poll();
+        snd_process_wait();
     }
     // setup the two DMA units to hand-off to each other
     // to maintain a stable bitstream these need to run without interruption
@@ -670,6 +702,7 @@ bool audio_set_paused(bool paused) {
 void audio_stop() {
     if (audio_idle) return;
 
+    snd_process_wait();
     memset(&current_track, 0, sizeof(current_track));
     memset(output_buf_a, 0, sizeof(output_buf_a));
     memset(output_buf_b, 0, sizeof(output_buf_b));
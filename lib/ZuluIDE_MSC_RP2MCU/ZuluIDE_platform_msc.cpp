@@ -30,6 +30,7 @@
 #include <SdFat.h>
 #include <device/usbd.h>
 #include <hardware/gpio.h>
+#include <hardware/sync.h>
 #include "ZuluIDE_platform.h"
 #include "ZuluIDE_log.h"
 #include "ZuluIDE_msc.h"
@@ -41,6 +42,19 @@
   #error "CFG_TUD_MSC_EP_BUFSIZE is too small! It needs to be at least 512 (SD_SECTOR_SIZE)"
 #endif
 
+// Size of each of the two read-ahead buffers, in sectors
+#ifndef MSC_READAHEAD_SECTORS
+#define MSC_READAHEAD_SECTORS 32
+#endif
+
+// Size of the write gathering buffer, in sectors
+#ifndef MSC_WRITE_GATHER_SECTORS
+#define MSC_WRITE_GATHER_SECTORS 32
+#endif
+
+// Gaps between transfers longer than this are not counted as transfer time
+#define MSC_STATS_IDLE_GAP_US 100000
+
 // external global SD variable
 extern SdFs SD;
 
@@ -53,9 +67,166 @@ static struct {
   uint8_t usbEpIn;
   uint8_t usbId;
   bool usbRegistered = false;
+  uint32_t sectorCount;
 
 } g_MSC;
 
+// Read-ahead buffer, holding sectors lba .. lba + count - 1.
+// count == 0 means the buffer is empty.
+typedef struct {
+  uint32_t lba;
+  uint32_t count;
+  uint32_t data[MSC_READAHEAD_SECTORS * SD_SECTOR_SIZE / 4];
+} msc_readbuf_t;
+
+static msc_readbuf_t g_msc_readbuf[2];
+static uint32_t g_msc_writebuf[MSC_WRITE_GATHER_SECTORS * SD_SECTOR_SIZE / 4];
+
+// The TinyUSB callbacks run from an interrupt on the same core as the MSC loop.
+// While the loop accesses the SD card it sets sdBusy, and the callbacks then
+// return 0 so that TinyUSB retries the command later.
+static struct {
+  volatile bool sdBusy;
+  volatile bool prefetchPending;
+  volatile bool flushPending;  // Write completed while sdBusy was set
+  uint32_t prefetchLba;
+  uint8_t active;        // Index of the read buffer that was last accessed
+  uint32_t nextReadLba;  // Sector following the previous READ10 chunk
+  uint32_t writeLba;     // First sector of gathered write data
+  uint32_t writeCount;   // Number of gathered sectors
+  bool writeError;       // Delayed write failed, report on the next command
+} g_msc_io;
+
+// Throughput statistics, reported when MSC mode exits
+typedef struct {
+  uint64_t bytes;
+  uint64_t activeUs;
+  uint32_t lastUs;
+} msc_stat_t;
+
+static msc_stat_t g_msc_readstat;
+static msc_stat_t g_msc_writestat;
+
+static void msc_stat_update(msc_stat_t *stat, uint32_t startUs, uint32_t bytes)
+{
+  uint32_t now = micros();
+  uint32_t gap = startUs - stat->lastUs;
+  if (stat->bytes != 0 && gap < MSC_STATS_IDLE_GAP_US)
+  {
+    // Count the whole interval since the previous chunk, including USB transfer time
+    stat->activeUs += now - stat->lastUs;
+  }
+  else
+  {
+    stat->activeUs += now - startUs;
+  }
+  stat->bytes += bytes;
+  stat->lastUs = now;
+}
+
+static void msc_stat_report(const char *name, const msc_stat_t *stat)
+{
+  if (stat->bytes == 0) return;
+
+  uint32_t kbytes = (uint32_t)(stat->bytes / 1024);
+  uint32_t ms = (uint32_t)(stat->activeUs / 1000);
+  if (ms == 0) ms = 1;
+  uint32_t kbps = (uint32_t)(stat->bytes * 1000 / 1024 / ms);
+  logmsg("USB MSC ", name, " ", (int)(kbytes / 1024), " MB in ", (int)ms, " ms: ",
+         (int)(kbps / 1024), ".", (int)((kbps % 1024) * 100 / 1024), " MB/s");
+}
+
+static msc_readbuf_t *msc_find_cached(uint32_t lba)
+{
+  for (int i = 0; i < 2; i++)
+  {
+    msc_readbuf_t *buf = &g_msc_readbuf[i];
+    if (buf->count > 0 && lba >= buf->lba && lba - buf->lba < buf->count)
+    {
+      return buf;
+    }
+  }
+  return NULL;
+}
+
+static bool msc_fill_readbuf(msc_readbuf_t *buf, uint32_t lba)
+{
+  buf->count = 0;
+  if (lba >= g_MSC.sectorCount) return false;
+
+  uint32_t count = MSC_READAHEAD_SECTORS;
+  if (count > g_MSC.sectorCount - lba) count = g_MSC.sectorCount - lba;
+
+  if (!SD.card()->readSectors(lba, (uint8_t*)buf->data, count))
+  {
+    return false;
+  }
+
+  buf->lba = lba;
+  buf->count = count;
+  return true;
+}
+
+static void msc_invalidate_readbufs(uint32_t lba, uint32_t count)
+{
+  for (int i = 0; i < 2; i++)
+  {
+    msc_readbuf_t *buf = &g_msc_readbuf[i];
+    if (buf->count > 0 && lba < buf->lba + buf->count && buf->lba < lba + count)
+    {
+      buf->count = 0;
+    }
+  }
+
+  if (g_msc_io.prefetchPending && lba < g_msc_io.prefetchLba + MSC_READAHEAD_SECTORS
+      && g_msc_io.prefetchLba < lba + count)
+  {
+    g_msc_io.prefetchPending = false;
+  }
+}
+
+static bool msc_flush_writes()
+{
+  g_msc_io.flushPending = false;
+  uint32_t count = g_msc_io.writeCount;
+  if (count == 0) return true;
+
+  bool rc = SD.card()->writeSectors(g_msc_io.writeLba, (const uint8_t*)g_msc_writebuf, count);
+  g_msc_io.writeCount = 0;
+
+  if (!rc)
+  {
+    logmsg("USB MSC: writing ", (int)count, " sectors at ", g_msc_io.writeLba, " failed");
+    g_msc_io.writeError = true;
+  }
+
+  return rc;
+}
+
+// Report a write failure that happened after the host already got status
+static bool msc_check_write_error(uint8_t lun)
+{
+  if (g_msc_io.writeError)
+  {
+    g_msc_io.writeError = false;
+    tud_msc_set_sense(lun, SCSI_SENSE_MEDIUM_ERROR, 0x03, 0x00);
+    return true;
+  }
+  return false;
+}
+
+
+// Reject accesses past the end of the card before any sector arithmetic
+static bool msc_check_range(uint8_t lun, uint32_t lba, uint32_t bufsize)
+{
+  uint32_t sectors = bufsize / SD_SECTOR_SIZE;
+  if (lba >= g_MSC.sectorCount || sectors > g_MSC.sectorCount - lba)
+  {
+    tud_msc_set_sense(lun, SCSI_SENSE_ILLEGAL_REQUEST, 0x21, 0x00);
+    return false;
+  }
+  return true;
+}
 
 /* return true if USB presence detected / eligble to enter CR mode */
 bool platform_sense_msc() {
@@ -88,6 +259,11 @@ void platform_enter_msc() {
     g_MSC.usbEpOut = USB.registerEndpointOut();
     static uint8_t msd_desc[] = { TUD_MSC_DESCRIPTOR(1 /* placeholder */, 0, g_MSC.usbEpOut, g_MSC.usbEpIn, USBD_MSC_EPSIZE) };
     g_MSC.usbId = USB.registerInterface(1, USBClass::simpleInterface, msd_desc, sizeof(msd_desc), 2, 0);
+    g_MSC.sectorCount = SD.card()->sectorCount();
+    memset(&g_msc_io, 0, sizeof(g_msc_io));
+    g_msc_readbuf[0].count = g_msc_readbuf[1].count = 0;
+    memset(&g_msc_readstat, 0, sizeof(g_msc_readstat));
+    memset(&g_msc_writestat, 0, sizeof(g_msc_writestat));
     g_MSC.unitReady = true;
     USB.connect();
     g_MSC.usbRegistered = true;
@@ -104,6 +280,32 @@ void platform_request_msc_exit() {
   g_MSC.unitReady = false;
 }
 
+/* perform background work for the MSC callbacks, called from the MSC loop */
+void platform_poll_msc() {
+  if (!g_msc_io.prefetchPending && !g_msc_io.flushPending) return;
+
+  // Block the callbacks before touching the buffers
+  g_msc_io.sdBusy = true;
+  __compiler_memory_barrier();
+
+  if (g_msc_io.flushPending) {
+    msc_flush_writes();
+  }
+
+  if (g_msc_io.prefetchPending) {
+    g_msc_io.prefetchPending = false;
+
+    uint32_t lba = g_msc_io.prefetchLba;
+    if (!msc_find_cached(lba)) {
+      // Fill the buffer that the host is not currently reading from
+      msc_fill_readbuf(&g_msc_readbuf[g_msc_io.active ^ 1], lba);
+    }
+  }
+
+  __compiler_memory_barrier();
+  g_msc_io.sdBusy = false;
+}
+
 /* perform any cleanup tasks for the MSC-specific functionality */
 void platform_exit_msc() {
   g_MSC.unitReady = false;
@@ -116,6 +318,14 @@ void platform_exit_msc() {
     USB.connect();
     g_MSC.usbRegistered = false;
   }
+
+  // The callbacks are no longer called, write out anything left over
+  msc_flush_writes();
+  g_msc_io.prefetchPending = false;
+  g_msc_readbuf[0].count = g_msc_readbuf[1].count = 0;
+
+  msc_stat_report("read", &g_msc_readstat);
+  msc_stat_report("write", &g_msc_writestat);
 }
 
 /* TinyUSB mass storage callbacks follow */
@@ -225,35 +435,125 @@ extern "C" int32_t tud_msc_scsi_cb(uint8_t lun, const uint8_t scsi_cmd[16], void
 extern "C" int32_t tud_msc_read10_cb(uint8_t lun, uint32_t lba, uint32_t offset, 
                             void* buffer, uint32_t bufsize)
 {
-  (void) lun;
+  (void) offset;
+
+  // MSC loop is accessing the card, TinyUSB will call again
+  if (g_msc_io.sdBusy) return 0;
+
+  if (!msc_check_range(lun, lba, bufsize)) return -1;
+  if (msc_check_write_error(lun)) return -1;
+  if (!msc_flush_writes()) return -1;
+
+  uint32_t start = micros();
+  uint32_t sectors = bufsize / SD_SECTOR_SIZE;
+  uint8_t *dst = (uint8_t*) buffer;
+  uint32_t pos = lba;
+  bool sequential = (lba == g_msc_io.nextReadLba);
+
+  while (sectors > 0) {
+    msc_readbuf_t *buf = msc_find_cached(pos);
+
+    if (!buf) {
+      if (!sequential) {
+        // Random access, read directly to avoid wasting time on read-ahead
+        if (!SD.card()->readSectors(pos, dst, sectors)) return -1;
+        pos += sectors;
+        break;
+      }
+
+      buf = &g_msc_readbuf[g_msc_io.active ^ 1];
+      if (!msc_fill_readbuf(buf, pos)) return -1;
+    }
+
+    uint32_t count = buf->lba + buf->count - pos;
+    if (count > sectors) count = sectors;
+    memcpy(dst, (uint8_t*)buf->data + (pos - buf->lba) * SD_SECTOR_SIZE, count * SD_SECTOR_SIZE);
+    dst += count * SD_SECTOR_SIZE;
+    pos += count;
+    sectors -= count;
+    g_msc_io.active = buf - g_msc_readbuf;
+  }
 
-  bool rc = SD.card()->readSectors(lba, (uint8_t*) buffer, bufsize/SD_SECTOR_SIZE);
+  g_msc_io.nextReadLba = pos;
+
+  if (sequential) {
+    // Let the MSC loop fetch the next window while this one goes out over USB
+    msc_readbuf_t *cur = &g_msc_readbuf[g_msc_io.active];
+    uint32_t next = cur->lba + cur->count;
+    if (cur->count > 0 && next < g_MSC.sectorCount && !msc_find_cached(next)) {
+      g_msc_io.prefetchLba = next;
+      g_msc_io.prefetchPending = true;
+    }
+  }
+
+  msc_stat_update(&g_msc_readstat, start, bufsize);
 
   // only blink fast on reads; writes will override this
   if (MSC_LEDMode == LED_SOLIDON)
     MSC_LEDMode = LED_BLINK_FAST;
   
-  return rc ? bufsize : -1;
+  return bufsize;
 }
 
 // Callback invoked when receive WRITE10 command.
 // Process data in buffer to disk's storage and return number of written bytes (must be multiple of block size)
 extern "C" int32_t tud_msc_write10_cb(uint8_t lun, uint32_t lba, uint32_t offset,
                            uint8_t *buffer, uint32_t bufsize) {
-  (void) lun;
+  (void) offset;
+
+  // MSC loop is accessing the card, TinyUSB will call again
+  if (g_msc_io.sdBusy) return 0;
 
-  bool rc = SD.card()->writeSectors(lba, buffer, bufsize/SD_SECTOR_SIZE);
+  if (!msc_check_range(lun, lba, bufsize)) return -1;
+  if (msc_check_write_error(lun)) return -1;
+
+  uint32_t start = micros();
+  uint32_t sectors = bufsize / SD_SECTOR_SIZE;
+  msc_invalidate_readbufs(lba, sectors);
+  g_msc_io.nextReadLba = 0;
+
+  // Start a new gathered write unless this continues the previous chunk
+  if (g_msc_io.writeCount > 0 &&
+      (lba != g_msc_io.writeLba + g_msc_io.writeCount ||
+       g_msc_io.writeCount + sectors > MSC_WRITE_GATHER_SECTORS)) {
+    if (!msc_flush_writes()) return -1;
+  }
+
+  if (sectors > MSC_WRITE_GATHER_SECTORS) {
+    if (!SD.card()->writeSectors(lba, buffer, sectors)) return -1;
+  } else {
+    if (g_msc_io.writeCount == 0) g_msc_io.writeLba = lba;
+    memcpy((uint8_t*)g_msc_writebuf + g_msc_io.writeCount * SD_SECTOR_SIZE, buffer, bufsize);
+    g_msc_io.writeCount += sectors;
+
+    if (g_msc_io.writeCount == MSC_WRITE_GATHER_SECTORS) {
+      if (!msc_flush_writes()) return -1;
+    }
+  }
+
+  msc_stat_update(&g_msc_writestat, start, bufsize);
 
   // always slow blink
   MSC_LEDMode = LED_BLINK_SLOW;
 
-  return rc ? bufsize : -1;
+  return bufsize;
 }
 
 // Callback invoked when WRITE10 command is completed (status received and accepted by host).
 // used to flush any pending cache to storage
 extern "C" void tud_msc_write10_complete_cb(uint8_t lun) {
   (void) lun;
+
+  if (g_msc_io.sdBusy) {
+    // MSC loop is accessing the card, let it do the flush
+    g_msc_io.flushPending = true;
+    return;
+  }
+
+  uint32_t start = micros();
+  uint32_t count = g_msc_io.writeCount;
+  msc_flush_writes();
+  if (count > 0) msc_stat_update(&g_msc_writestat, start, 0);
 }
 
 #endif
\ No newline at end of file
@@ -41,6 +41,9 @@ void platform_enter_msc();
 /* return true if we should remain in card reader mode. called in a loop. */
 bool platform_run_msc();
 
+/* perform read-ahead and delayed writes, called from the MSC loop while idle */
+void platform_poll_msc();
+
 /* perform any cleanup tasks for the MSC-specific functionality */
 void platform_exit_msc();
 
@@ -44,7 +44,9 @@
 #include <hardware/structs/iobank0.h>
 #include <hardware/flash.h>
 #include <pico/multicore.h>
+#include <pico/time.h>
 #include "rp2040_fpga.h"
+#include "rp2040_core1_worker.h"
 #include <strings.h>
 #include <USB.h>
 #include <SerialUSB.h>
@@ -765,10 +767,12 @@ bool install_license(char *buf)
     usb_log_poll();
 
     // Write to RP2040 flash
+    core1_worker_lockout_start();
     uint32_t saved_irq = save_and_disable_interrupts();
     flash_range_erase(PLATFORM_LICENSE_KEY_OFFSET, PLATFORM_FLASH_PAGE_SIZE);
     flash_range_program(PLATFORM_LICENSE_KEY_OFFSET, key, 256);
     restore_interrupts(saved_irq);
+    core1_worker_lockout_end();
 
     if (memcmp(key, PLATFORM_LICENSE_KEY_ADDR, 32) == 0)
     {
@@ -819,6 +823,8 @@ extern void platform_reboot_poll();
 // Can be left empty or used for platform-specific processing.
 void platform_poll(bool only_from_main)
 {
+    core1_worker_poll(only_from_main);
+
     static uint32_t prev_poll_time;
     static bool license_log_done = false;
     static bool license_from_sd_done = false;
@@ -910,6 +916,15 @@ void platform_poll(bool only_from_main)
 #endif // ENABLE_AUDIO_OUTPUT
 }
 
+// The FPGA has no interrupt line to the MCU, so the timeout bounds how late
+// a new IDE command is noticed. USB, audio DMA and core 1 job completion wake us earlier.
+void platform_wait_for_event(uint32_t max_us)
+{
+    uint32_t start = time_us_32();
+    best_effort_wfe_or_timeout(make_timeout_time_us(max_us));
+    core1_worker_core0_waited(time_us_32() - start);
+}
+
 /*****************************************/
 /* Flash reprogramming from bootloader   */
 /*****************************************/
@@ -920,6 +935,21 @@ extern uint32_t __real_vectors_start;
 extern uint32_t __StackTop;
 static volatile void *g_bootloader_exit_req;
 
+bool platform_flash_page_matches(uint32_t offset, const uint8_t buffer[PLATFORM_FLASH_PAGE_SIZE])
+{
+    // Read through the uncached alias so that a previous rewrite is always seen
+    const uint32_t *flash32 = (const uint32_t*)(XIP_NOCACHE_BASE + offset);
+    const uint32_t *buf32 = (const uint32_t*)buffer;
+    uint32_t num_words = PLATFORM_FLASH_PAGE_SIZE / 4;
+    for (int i = 0; i < num_words; i++)
+    {
+        if (flash32[i] != buf32[i])
+            return false;
+    }
+
+    return true;
+}
+
 __attribute__((section(".time_critical.platform_rewrite_flash_page")))
 bool platform_rewrite_flash_page(uint32_t offset, uint8_t buffer[PLATFORM_FLASH_PAGE_SIZE])
 {
@@ -1013,12 +1043,26 @@ const void * btldr_vectors[2] = {&__StackTop, (void*)&btldr_reset_handler};
 /* 2nd core code                */
 /********************************/
 void zuluide_setup(void)
+{
+    // Runs before the first IDE poll, so the controller probe is left to
+    // platform_init_second_core() to keep the drive from reporting busy.
+}
+
+void platform_init_second_core()
 {
    if (!platform_check_for_controller())
    {
      rp2040.idleOtherCore();
      multicore_reset_core1();
-     dbgmsg("No Zulu Control board or I2C server found, disabling 2nd core");
+     if (ini_getbool("IDE", "core1_worker", true, CONFIGFILE))
+     {
+       core1_worker_start();
+       dbgmsg("No Zulu Control board or I2C server found, using 2nd core for CD sector formatting and audio");
+     }
+     else
+     {
+       dbgmsg("No Zulu Control board or I2C server found, disabling 2nd core");
+     }
    }
 }
 
@@ -1042,6 +1086,7 @@ void zuluide_main_loop1(void)
             display.Refresh();
         }
         g_controllerImageResponsePipe->ProcessUpdates();
+        display.FinishTransfer();
         g_I2cServer.Poll();
     }
 }
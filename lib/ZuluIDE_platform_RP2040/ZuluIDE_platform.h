@@ -69,6 +69,9 @@ void platform_minimal_init();
 // Initialization for main application, not used for bootloader
 void platform_late_init();
 
+// Set up the second core once the controller probe is done, called from the main loop
+void platform_init_second_core();
+
 // Write the status LED through the mux
 void platform_write_led(bool state);
 #define LED_ON()  platform_write_led(true)
@@ -115,11 +118,31 @@ void platform_request_msc_exit();
 // few milliseconds shouldn't disturb SCSI communication.
 void platform_poll(bool only_from_main = false);
 
+// Sleep until an interrupt or the other core signals an event, but at most max_us.
+// Called from the main loop when the IDE bus has been idle for a while.
+void platform_wait_for_event(uint32_t max_us);
+
 // Set callback that will be called during data transfer to/from SD card.
 // This can be used to implement simultaneous transfer to SCSI bus.
 typedef void (*sd_callback_t)(uint32_t bytes_complete);
 void platform_set_sd_callback(sd_callback_t func, const uint8_t *buffer);
 
+// When there is no ZuluControl board, the second core runs a worker
+// that core 0 can hand CPU heavy jobs to.
+#define PLATFORM_HAS_CORE1_WORKER 1
+typedef void (*platform_core1_job_t)(void *param);
+
+// True if jobs can be queued to the second core
+bool platform_core1_is_running();
+
+// Queue a job to run on the second core. Returns a ticket for waiting the result,
+// or 0 if the worker is not running or the queue is full and the caller should run the job itself.
+uint32_t platform_core1_submit(platform_core1_job_t func, void *param);
+
+// Check or wait for completion of a queued job, ticket 0 is always done
+bool platform_core1_is_done(uint32_t ticket);
+void platform_core1_wait(uint32_t ticket);
+
 /**
    This mutex is used to prevent saving the log file to the SD card while reading the file system.
    A more robust file access method is needed, but this is fixing the problem for now, even though
@@ -154,6 +177,8 @@ bool platform_usb_log_is_flushed();
 #ifndef RP2040_DISABLE_BOOTLOADER
 #define PLATFORM_BOOTLOADER_SIZE (128 * 1024)
 bool platform_rewrite_flash_page(uint32_t offset, uint8_t buffer[PLATFORM_FLASH_PAGE_SIZE]);
+// Returns true if the flash page at offset already holds exactly this data
+bool platform_flash_page_matches(uint32_t offset, const uint8_t buffer[PLATFORM_FLASH_PAGE_SIZE]);
 void platform_boot_to_main_firmware();
 #endif
 
@@ -0,0 +1,188 @@
+/**
+ * ZuluIDE™ - Copyright (c) 2026 Rabbit Hole Computing™
+ *
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version.
+ *
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional
+ * permissions described in the ZuluIDE Hardware Support Library Exception
+ * (GPL-3.0_HSL_Exception.md), as published by Rabbit Hole Computing™.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "rp2040_core1_worker.h"
+#include "ZuluIDE_platform.h"
+#include "ZuluIDE_log.h"
+#include "ZuluIDE_config.h"
+#include <hardware/sync.h>
+#include <hardware/timer.h>
+#include <pico/multicore.h>
+
+// Must be a power of 2
+#define CORE1_WORKER_QUEUE_SIZE 8
+#define CORE1_WORKER_QUEUE_MASK (CORE1_WORKER_QUEUE_SIZE - 1)
+
+static struct {
+    struct {
+        platform_core1_job_t func;
+        void *param;
+    } jobs[CORE1_WORKER_QUEUE_SIZE];
+
+    volatile uint32_t head; // Number of jobs queued, written only by core 0
+    volatile uint32_t tail; // Number of jobs completed, written only by core 1
+    volatile uint32_t busy_us; // Time spent running jobs, written only by core 1
+    bool running;
+    bool locked_out;
+    uint32_t core0_wait_us; // Sleep time of core 0 since last poll
+} g_core1_worker;
+
+static void __not_in_flash_func(core1_worker_main)()
+{
+    multicore_lockout_victim_init();
+
+    while (true)
+    {
+        uint32_t tail = g_core1_worker.tail;
+        if (tail == g_core1_worker.head)
+        {
+            // Core 0 sends an event after queuing a job
+            __wfe();
+            continue;
+        }
+
+        __dmb();
+        platform_core1_job_t func = g_core1_worker.jobs[tail & CORE1_WORKER_QUEUE_MASK].func;
+        void *param = g_core1_worker.jobs[tail & CORE1_WORKER_QUEUE_MASK].param;
+
+        uint32_t start = time_us_32();
+        func(param);
+        g_core1_worker.busy_us += time_us_32() - start;
+
+        // Results written by the job must be visible before the tail update
+        __dmb();
+        g_core1_worker.tail = tail + 1;
+        __sev();
+    }
+}
+
+void core1_worker_start()
+{
+    g_core1_worker.head = 0;
+    g_core1_worker.tail = 0;
+    g_core1_worker.busy_us = 0;
+    multicore_launch_core1(core1_worker_main);
+    g_core1_worker.running = true;
+}
+
+bool platform_core1_is_running()
+{
+    return g_core1_worker.running && !g_core1_worker.locked_out;
+}
+
+uint32_t platform_core1_submit(platform_core1_job_t func, void *param)
+{
+    uint32_t head = g_core1_worker.head;
+    if (!platform_core1_is_running() || head - g_core1_worker.tail >= CORE1_WORKER_QUEUE_SIZE)
+    {
+        // Caller runs the job itself
+        return 0;
+    }
+
+    g_core1_worker.jobs[head & CORE1_WORKER_QUEUE_MASK].func = func;
+    g_core1_worker.jobs[head & CORE1_WORKER_QUEUE_MASK].param = param;
+    __dmb();
+    g_core1_worker.head = head + 1;
+    __sev();
+    return head + 1;
+}
+
+bool platform_core1_is_done(uint32_t ticket)
+{
+    return (int32_t)(g_core1_worker.tail - ticket) >= 0;
+}
+
+void platform_core1_wait(uint32_t ticket)
+{
+    while (!platform_core1_is_done(ticket))
+    {
+        tight_loop_contents();
+    }
+    __dmb();
+}
+
+void core1_worker_lockout_start()
+{
+    if (!g_core1_worker.running) return;
+
+    // Let queued jobs finish so that they don't stall on the lockout
+    platform_core1_wait(g_core1_worker.head);
+    g_core1_worker.locked_out = true;
+    multicore_lockout_start_blocking();
+}
+
+void core1_worker_lockout_end()
+{
+    if (!g_core1_worker.locked_out) return;
+
+    multicore_lockout_end_blocking();
+    g_core1_worker.locked_out = false;
+}
+
+void core1_worker_core0_waited(uint32_t us)
+{
+    g_core1_worker.core0_wait_us += us;
+}
+
+// Main loop iterations that take longer than CORE_UTILIZATION_IDLE_LOOP_US
+// are counted as time core 0 was busy, shorter ones are just polling.
+void core1_worker_poll(bool only_from_main)
+{
+    static uint32_t prev_loop_us;
+    static uint32_t interval_start_us;
+    static uint32_t core0_busy_us;
+    static uint32_t core1_busy_start_us;
+    static uint32_t jobs_start;
+
+    if (!only_from_main) return;
+
+    uint32_t now = time_us_32();
+    uint32_t loop_us = now - prev_loop_us;
+    prev_loop_us = now;
+    loop_us -= (g_core1_worker.core0_wait_us < loop_us) ? g_core1_worker.core0_wait_us : loop_us;
+    g_core1_worker.core0_wait_us = 0;
+    if (loop_us > CORE_UTILIZATION_IDLE_LOOP_US)
+    {
+        core0_busy_us += loop_us;
+    }
+
+    uint32_t interval_us = now - interval_start_us;
+    if (interval_us >= CORE_UTILIZATION_LOG_INTERVAL_MS * 1000)
+    {
+        uint32_t core1_busy_us = g_core1_worker.busy_us - core1_busy_start_us;
+        uint32_t jobs = g_core1_worker.tail - jobs_start;
+        if (core0_busy_us > 0 || jobs > 0)
+        {
+            dbgmsg("Core utilization: core0 ", (int)((uint64_t)core0_busy_us * 100 / interval_us), "%",
+                   ", core1 ", (int)((uint64_t)core1_busy_us * 100 / interval_us), "%",
+                   " (", (int)jobs, " jobs", g_core1_worker.running ? "" : ", worker not running", ")");
+        }
+
+        interval_start_us = now;
+        core0_busy_us = 0;
+        core1_busy_start_us = g_core1_worker.busy_us;
+        jobs_start = g_core1_worker.tail;
+    }
+}
@@ -0,0 +1,46 @@
+/**
+ * ZuluIDE™ - Copyright (c) 2026 Rabbit Hole Computing™
+ *
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version.
+ *
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional
+ * permissions described in the ZuluIDE Hardware Support Library Exception
+ * (GPL-3.0_HSL_Exception.md), as published by Rabbit Hole Computing™.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+// Worker that runs on the second RP2040 core when it is not needed for
+// the ZuluControl user interface. Core 0 queues jobs to it through a
+// single-producer single-consumer ring, so no locks are needed.
+
+#pragma once
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Launch the worker on core 1. The core must have been reset first.
+void core1_worker_start();
+
+// Called from platform_poll() to collect and log core utilization.
+void core1_worker_poll(bool only_from_main);
+
+// Time core 0 spent sleeping in platform_wait_for_event(), not counted as busy.
+void core1_worker_core0_waited(uint32_t us);
+
+// Keep core 1 executing from RAM while flash is being written.
+void core1_worker_lockout_start();
+void core1_worker_lockout_end();
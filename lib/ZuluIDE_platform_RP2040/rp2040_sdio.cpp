@@ -34,10 +34,12 @@
 // "SDIO Physical Layer Simplified Specification Version 8.00"
 
 #include "rp2040_sdio.h"
+#include "rp2040_sdio_crc16.h"
 #include "rp2040_sdio.pio.h"
 #include <hardware/pio.h>
 #include <hardware/dma.h>
 #include <hardware/gpio.h>
+#include <hardware/clocks.h>
 #include <ZuluIDE_platform.h>
 #include <ZuluIDE_log.h>
 
@@ -115,42 +117,39 @@ static const uint8_t crc7_table[256] = {
 	0x1c, 0x0e, 0x38, 0x2a, 0x54, 0x46, 0x70, 0x62,	0x8c, 0x9e, 0xa8, 0xba, 0xc4, 0xd6, 0xe0, 0xf2
 };
 
-// Calculate the CRC16 checksum for parallel 4 bit lines separately.
-// When the SDIO bus operates in 4-bit mode, the CRC16 algorithm
-// is applied to each line separately and generates total of
-// 4 x 16 = 64 bits of checksum.
-__attribute__((optimize("O3")))
-uint64_t sdio_crc16_4bit_checksum(uint32_t *data, uint32_t num_words)
+// Checksum used for data blocks, replaced by the reference if the self test fails
+static uint64_t (*g_sdio_crc16)(uint32_t *data, uint32_t num_words) = sdio_crc16_4bit_checksum;
+
+// Compare the checksum against the reference and log the time per block
+static void sdio_crc16_self_test()
 {
-    uint64_t crc = 0;
-    uint32_t *end = data + num_words;
-    while (data < end)
+    uint32_t block[SDIO_WORDS_PER_BLOCK];
+    uint32_t x = 0x12345678;
+    for (int i = 0; i < SDIO_WORDS_PER_BLOCK; i++)
     {
-        for (int unroll = 0; unroll < 4; unroll++)
-        {
-            // Each 32-bit word contains 8 bits per line.
-            // Reverse the bytes because SDIO protocol is big-endian.
-            uint32_t data_in = __builtin_bswap32(*data++);
-
-            // Shift out 8 bits for each line
-            uint32_t data_out = crc >> 32;
-            crc <<= 32;
-
-            // XOR outgoing data to itself with 4 bit delay
-            data_out ^= (data_out >> 16);
-
-            // XOR incoming data to outgoing data with 4 bit delay
-            data_out ^= (data_in >> 16);
+        x = x * 1664525 + 1013904223;
+        block[i] = x;
+    }
 
-            // XOR outgoing and incoming data to accumulator at each tap
-            uint64_t xorred = data_out ^ data_in;
-            crc ^= xorred;
-            crc ^= xorred << (5 * 4);
-            crc ^= xorred << (12 * 4);
-        }
+    const int rounds = 16;
+    uint64_t crc = 0;
+    uint64_t crc_ref = 0;
+    uint32_t start = time_us_32();
+    for (int i = 0; i < rounds; i++) crc = sdio_crc16_4bit_checksum(block, SDIO_WORDS_PER_BLOCK);
+    uint32_t fast_us = time_us_32() - start;
+    start = time_us_32();
+    for (int i = 0; i < rounds; i++) crc_ref = sdio_crc16_4bit_checksum_ref(block, SDIO_WORDS_PER_BLOCK);
+    uint32_t ref_us = time_us_32() - start;
+
+    if (crc != crc_ref)
+    {
+        logmsg("SDIO CRC16 self test failed: ", crc, " expected ", crc_ref, ", using reference implementation");
+        g_sdio_crc16 = sdio_crc16_4bit_checksum_ref;
     }
 
-    return crc;
+    uint32_t mhz = clock_get_hz(clk_sys) / 1000000;
+    dbgmsg("SDIO CRC16: ", (int)(fast_us * mhz / rounds), " cycles per block, reference ",
+           (int)(ref_us * mhz / rounds), " cycles");
 }
 
 /*******************************************************
@@ -444,8 +443,8 @@ static void sdio_verify_rx_checksums(uint32_t maxcount)
     {
         // Calculate checksum from received data
         int blockidx = g_sdio.blocks_checksumed++;
-        uint64_t checksum = sdio_crc16_4bit_checksum(g_sdio.data_buf + blockidx * SDIO_WORDS_PER_BLOCK,
-                                                     SDIO_WORDS_PER_BLOCK);
+        uint64_t checksum = g_sdio_crc16(g_sdio.data_buf + blockidx * SDIO_WORDS_PER_BLOCK,
+                                         SDIO_WORDS_PER_BLOCK);
 
         // Convert received checksum to little-endian format
         uint32_t top = __builtin_bswap32(g_sdio.received_checksums[blockidx].top);
@@ -576,8 +575,8 @@ static void sdio_compute_next_tx_checksum()
 {
     assert (g_sdio.blocks_done < g_sdio.total_blocks && g_sdio.blocks_checksumed < g_sdio.total_blocks);
     int blockidx = g_sdio.blocks_checksumed++;
-    g_sdio.next_wr_block_checksum = sdio_crc16_4bit_checksum(g_sdio.data_buf + blockidx * SDIO_WORDS_PER_BLOCK,
-                                                             SDIO_WORDS_PER_BLOCK);
+    g_sdio.next_wr_block_checksum = g_sdio_crc16(g_sdio.data_buf + blockidx * SDIO_WORDS_PER_BLOCK,
+                                                 SDIO_WORDS_PER_BLOCK);
 }
 
 // Start transferring data from memory to SD card
@@ -768,6 +767,7 @@ void rp2040_sdio_init(int clock_divider)
         dma_channel_claim(SDIO_DMA_CH);
         dma_channel_claim(SDIO_DMA_CHB);
         resources_claimed = true;
+        sdio_crc16_self_test();
     }
 
     memset(&g_sdio, 0, sizeof(g_sdio));
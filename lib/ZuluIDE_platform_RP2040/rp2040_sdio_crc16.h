@@ -0,0 +1,36 @@
+/**
+ * ZuluIDE™ - Copyright (c) 2023 Rabbit Hole Computing™
+ *
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version. 
+ *
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version. 
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. 
+ *
+ * Under Section 7 of GPL version 3, you are granted additional
+ * permissions described in the ZuluIDE Hardware Support Library Exception
+ * (GPL-3.0_HSL_Exception.md), as published by Rabbit Hole Computing™.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+// CRC16 of the 4-bit SDIO data lines, kept apart from the PIO and DMA code
+// so that utils/sdio_crc16_test.cpp can check and benchmark it on a PC.
+
+#pragma once
+#include <stdint.h>
+
+// Calculate the 4 x 16 bit checksum of a data block, one CRC16 per line
+uint64_t sdio_crc16_4bit_checksum(uint32_t *data, uint32_t num_words);
+
+// Original implementation with a 64-bit state, used as a reference
+uint64_t sdio_crc16_4bit_checksum_ref(uint32_t *data, uint32_t num_words);
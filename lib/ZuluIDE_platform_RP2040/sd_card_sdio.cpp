@@ -326,8 +326,30 @@ bool SdioCard::writeStop()
 
 bool SdioCard::erase(uint32_t firstSector, uint32_t lastSector)
 {
-    logmsg("SdioCard::erase() not implemented");
-    return false;
+    // Cards up to 2GB use byte addressing, SDHC cards use sector addressing
+    uint32_t first = (type() == SD_CARD_TYPE_SDHC) ? firstSector : (firstSector * 512);
+    uint32_t last = (type() == SD_CARD_TYPE_SDHC) ? lastSector : (lastSector * 512);
+
+    uint32_t reply;
+    if (!checkReturnOk(rp2040_sdio_command_R1(CMD32, first, &reply)) || // ERASE_WR_BLK_START
+        !checkReturnOk(rp2040_sdio_command_R1(CMD33, last, &reply)) || // ERASE_WR_BLK_END
+        !checkReturnOk(rp2040_sdio_command_R1(CMD38, 0, &reply))) // ERASE
+    {
+        return false;
+    }
+
+    // Card signals busy on D0 until the erase completes
+    uint32_t start = millis();
+    while (isBusy())
+    {
+        if ((uint32_t)(millis() - start) > 10000)
+        {
+            logmsg("SdioCard::erase(", firstSector, ",", lastSector, ") timeout");
+            return false;
+        }
+    }
+
+    return true;
 }
 
 bool SdioCard::cardCMD6(uint32_t arg, uint8_t* status) {
@@ -403,6 +425,8 @@ bool SdioCard::writeSectors(uint32_t sector, const uint8_t* src, size_t n)
     // Cards up to 2GB use byte addressing, SDHC cards use sector addressing
     uint32_t address = (type() == SD_CARD_TYPE_SDHC) ? sector : (sector * 512);
 
+    // Pre-erase only the sectors of this CMD25. Erasing further ahead would lose
+    // image data that a later write of an aborted host command never replaces.
     uint32_t reply;
     if (!checkReturnOk(rp2040_sdio_command_R1(16, 512, &reply)) || // SET_BLOCKLEN
         !checkReturnOk(rp2040_sdio_command_R1(CMD55, g_sdio_rca, &reply)) || // APP_CMD
@@ -46,6 +46,7 @@
 #include <hardware/structs/iobank0.h>
 #include <hardware/flash.h>
 #include <pico/multicore.h>
+#include <pico/time.h>
 #include <strings.h>
 #include <USB.h>
 #include <SerialUSB.h>
@@ -329,6 +330,10 @@ void platform_init_eject_button(uint8_t eject_button)
 
     if (eject_button & 2)
     {
+#if defined(GPIO_EXT_INTERRUPT) && GPIO_EXT_INTERRUPT == GPIO_EJECT_BTN_2_PIN
+        // Button 2 shares the pin with the expansion interrupt line
+        g_rotary_input.SetInterruptAllowed(false);
+#endif
         gpio_conf(GPIO_EJECT_BTN_2_PIN, GPIO_FUNC_SIO, true, false, false, true, false);
         g_eject_buttons |= 2;
     }
@@ -846,20 +851,27 @@ void core1_log_poll()
 }
 
 void platform_poll_input() {
+    // The display update started on the previous pass has been going out
+    // over DMA meanwhile, release the bus before the other I2C users.
+    display.FinishTransfer();
     g_rotary_input.Poll();
 
+    if (uiStatusController)
+    {
+        g_controllerImageResponsePipe->ProcessUpdates();
+        g_I2cServer.Poll();
+    }
+    g_I2CServerImageRequestPipe.ProcessUpdates();
+
     if (uiStatusController)
     {
         // Process status update, if any exist.
+        // Done last so that the display transfer overlaps with IDE handling.
         if (!uiStatusController->ProcessUpdate()) {
             // If no updates happened, refresh the display (enables animation)
             display.Refresh();
         }
-
-        g_controllerImageResponsePipe->ProcessUpdates();
-        g_I2cServer.Poll();
     }
-    g_I2CServerImageRequestPipe.ProcessUpdates();
 }
 
 // Poll function that is called every few milliseconds.
@@ -911,6 +923,18 @@ void platform_poll(bool only_from_main)
 #endif // ENABLE_AUDIO_OUTPUT
 }
 
+// Core 1 reports IDE bus events through g_idecomm.events. It does not signal
+// core 0 when setting them, so the timeout bounds how late a new command is noticed.
+void platform_wait_for_event(uint32_t max_us)
+{
+    if (g_idecomm.events & (CORE1_EVT_CMD_RECEIVED | CORE1_EVT_HWRST | CORE1_EVT_SWRST))
+    {
+        return;
+    }
+
+    best_effort_wfe_or_timeout(make_timeout_time_us(max_us));
+}
+
 
 /*****************************************/
 /* Flash reprogramming from bootloader   */
@@ -962,6 +986,33 @@ static void reboot_to_secure()
 #define BOOTLOADER_OFFSET (128 * 1024)
 #define MAINAPP_OFFSET (256 * 1024)
 
+bool platform_flash_page_matches(uint32_t offset, const uint8_t buffer[PLATFORM_FLASH_PAGE_SIZE])
+{
+    // Bootloader area is never programmed, treat it as up to date
+    if (offset >= BOOTLOADER_OFFSET && offset < MAINAPP_OFFSET)
+        return true;
+
+#ifdef ARM_NONSECURE_MODE
+    // The encrypted HSL area below the bootloader may not be readable from
+    // non-secure state. Report a mismatch so that the page goes through
+    // platform_rewrite_flash_page(), which switches to secure mode first.
+    if (offset < BOOTLOADER_OFFSET && !is_secure_mode())
+        return false;
+#endif
+
+    // Read through the uncached alias so that a previous rewrite is always seen
+    const uint32_t *flash32 = (const uint32_t*)(XIP_NOCACHE_NOALLOC_BASE + offset);
+    const uint32_t *buf32 = (const uint32_t*)buffer;
+    uint32_t num_words = PLATFORM_FLASH_PAGE_SIZE / 4;
+    for (int i = 0; i < num_words; i++)
+    {
+        if (flash32[i] != buf32[i])
+            return false;
+    }
+
+    return true;
+}
+
 __attribute__((section(".time_critical.platform_rewrite_flash_page")))
 bool platform_rewrite_flash_page(uint32_t offset, uint8_t buffer[PLATFORM_FLASH_PAGE_SIZE])
 {
@@ -1098,6 +1149,11 @@ void zuluide_setup(void)
 {
 }
 
+void platform_init_second_core()
+{
+    // Second core runs the prebuilt IDE PHY library
+}
+
 mutex_t* platform_get_log_mutex() {
   return &logMutex;
 }
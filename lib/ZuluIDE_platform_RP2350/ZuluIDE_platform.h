@@ -75,6 +75,9 @@ void platform_minimal_init();
 // Initialization for main application, not used for bootloader
 void platform_late_init();
 
+// Set up the second core once the controller probe is done, called from the main loop
+void platform_init_second_core();
+
 // Write the status LED through the mux
 void platform_write_led(bool state);
 #define LED_ON()  platform_write_led(true)
@@ -121,6 +124,10 @@ void platform_request_msc_exit();
 // few milliseconds shouldn't disturb SCSI communication.
 void platform_poll(bool only_from_main = false);
 
+// Sleep until an interrupt or the other core signals an event, but at most max_us.
+// Called from the main loop when the IDE bus has been idle for a while.
+void platform_wait_for_event(uint32_t max_us);
+
 // Output log of USB serial console
 void usb_log_poll();
 
@@ -168,6 +175,8 @@ bool platform_usb_log_is_flushed();
 #ifndef RP2040_DISABLE_BOOTLOADER
 #define PLATFORM_BOOTLOADER_SIZE 0
 bool platform_rewrite_flash_page(uint32_t offset, uint8_t buffer[PLATFORM_FLASH_PAGE_SIZE]);
+// Returns true if the flash page at offset already holds exactly this data
+bool platform_flash_page_matches(uint32_t offset, const uint8_t buffer[PLATFORM_FLASH_PAGE_SIZE]);
 void platform_boot_to_main_firmware();
 #endif
 
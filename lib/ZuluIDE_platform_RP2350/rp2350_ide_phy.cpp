@@ -39,6 +39,8 @@
 #include "ide_phy.h"
 #include "rp2350_sniffer.h"
 #include "rp2350_iocs16.pio.h"
+#include "rp2350_pack16.pio.h"
+#include "sdio_rp2350_config.h"
 
 #include <zuluide_rp2350b_core1.h>
 
@@ -61,6 +63,55 @@
 #define IOCS16_PIO_PROG_OFFSET 0
 #endif
 
+// PIO state machine and DMA channels used for formatting PIO mode data blocks.
+// The program is placed right after the IOCS16 program for the same reason,
+// pio_add_program() used by SDIO allocates from the top of instruction memory.
+// Set PACK16_ENABLE to 0 to format the data with CPU only.
+//
+// DMA channels are fixed instead of dma_claim_unused_channel(): the core1
+// library does not mark channels 2-4 claimed, and audio and the sniffer
+// call dma_channel_claim() with fixed numbers, which panics if a dynamically
+// claimed channel took the number first. Channels in use on RP2350:
+// 0-1 SDIO, 2-4 core1, 5 IOCS16, 7-8 audio or sniffer, 9-10 ZuluControl I2C,
+// 11-12 PIO data formatting. State machines in pio1: 0 SDIO, 2 formatting, 3 IOCS16.
+#ifndef PACK16_ENABLE
+#define PACK16_ENABLE 1
+#endif
+#ifndef PACK16_PIO
+#define PACK16_PIO pio1
+#endif
+#ifndef PACK16_PIO_SM
+#define PACK16_PIO_SM 2
+#endif
+#ifndef PACK16_PIO_PROG_OFFSET
+#define PACK16_PIO_PROG_OFFSET 4
+#endif
+#ifndef PACK16_DMA_CH_TX
+#define PACK16_DMA_CH_TX 11
+#endif
+#ifndef PACK16_DMA_CH_RX
+#define PACK16_DMA_CH_RX 12
+#endif
+
+// Shorter blocks are formatted by CPU only
+#define PACK16_DMA_MIN_BYTES 128
+
+#define PACK16_DMA_CH_IS_FREE(ch) ((ch) != SDIO_DMACH_A && (ch) != SDIO_DMACH_B && \
+    (ch) != IDE_PHY_DMACH_A && (ch) != IDE_PHY_DMACH_B && (ch) != IDE_PHY_DMACH_C && \
+    (ch) != IOCS16_DMA_CH)
+static_assert(PACK16_DMA_CH_IS_FREE(PACK16_DMA_CH_TX) && PACK16_DMA_CH_IS_FREE(PACK16_DMA_CH_RX),
+              "PIO data formatting DMA channel is used by SDIO, core1 or IOCS16");
+#ifdef SOUND_DMA_CHA
+static_assert(PACK16_DMA_CH_TX != SOUND_DMA_CHA && PACK16_DMA_CH_TX != SOUND_DMA_CHB &&
+              PACK16_DMA_CH_RX != SOUND_DMA_CHA && PACK16_DMA_CH_RX != SOUND_DMA_CHB,
+              "PIO data formatting DMA channel is used by audio");
+#endif
+static_assert(PACK16_PIO_SM != SDIO_SM && PACK16_PIO_SM != IOCS16_PIO_SM,
+              "PIO data formatting state machine is used by SDIO or IOCS16");
+static_assert(PACK16_PIO_PROG_OFFSET >= IOCS16_PIO_PROG_OFFSET + rp2350_iocs16_wrap + 1 ||
+              PACK16_PIO_PROG_OFFSET + rp2350_pack16_wrap < IOCS16_PIO_PROG_OFFSET,
+              "PIO data formatting program overlaps the IOCS16 program");
+
 static struct {
     ide_phy_config_t config;
     bool transfer_running; // Purely for debugging
@@ -75,6 +126,12 @@ static struct {
     // PIO address for iocs16 program
     bool pio_iocs16_claimed;
 
+    // PIO data formatting helper and statistics for the current transfer
+    bool pack16_claimed;
+    bool pack16_available;
+    uint32_t pack_bytes;
+    uint32_t pack_us;
+
     uint32_t bufferidx; // Index of next buffer in g_idebuffers to use
 } g_ide_phy;
 
@@ -109,6 +166,54 @@ static bool ide_phy_check_pending_request(uint32_t request)
 
 void core1_log_poll();
 
+// Set up the state machine that expands 16 bit data words to the 32 bit
+// format used by core1. If the resources are taken, CPU does the formatting.
+static void pack16_init()
+{
+    g_ide_phy.pack16_claimed = true;
+
+    if (!PACK16_ENABLE ||
+        pio_sm_is_claimed(PACK16_PIO, PACK16_PIO_SM) ||
+        !pio_can_add_program_at_offset(PACK16_PIO, &rp2350_pack16_program, PACK16_PIO_PROG_OFFSET) ||
+        dma_channel_is_claimed(PACK16_DMA_CH_TX) ||
+        dma_channel_is_claimed(PACK16_DMA_CH_RX))
+    {
+        dbgmsg("PIO mode data is formatted by CPU");
+        return;
+    }
+
+    pio_sm_claim(PACK16_PIO, PACK16_PIO_SM);
+    pio_add_program_at_offset(PACK16_PIO, &rp2350_pack16_program, PACK16_PIO_PROG_OFFSET);
+    dma_channel_claim(PACK16_DMA_CH_TX);
+    dma_channel_claim(PACK16_DMA_CH_RX);
+
+    pio_sm_config cfg = rp2350_pack16_program_get_default_config(PACK16_PIO_PROG_OFFSET);
+    pio_sm_init(PACK16_PIO, PACK16_PIO_SM, PACK16_PIO_PROG_OFFSET, &cfg);
+    pio_sm_put(PACK16_PIO, PACK16_PIO_SM, IDECOMM_DATA_PATTERN >> 16);
+    pio_sm_exec(PACK16_PIO, PACK16_PIO_SM, pio_encode_pull(false, false));
+    pio_sm_exec(PACK16_PIO, PACK16_PIO_SM, pio_encode_out(pio_y, 32));
+    pio_sm_set_enabled(PACK16_PIO, PACK16_PIO_SM, true);
+
+    // Addresses and counts are set for each block
+    dma_channel_config txcfg = dma_channel_get_default_config(PACK16_DMA_CH_TX);
+    channel_config_set_transfer_data_size(&txcfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&txcfg, true);
+    channel_config_set_write_increment(&txcfg, false);
+    channel_config_set_dreq(&txcfg, pio_get_dreq(PACK16_PIO, PACK16_PIO_SM, true));
+    dma_channel_configure(PACK16_DMA_CH_TX, &txcfg, &PACK16_PIO->txf[PACK16_PIO_SM], NULL, 0, false);
+
+    dma_channel_config rxcfg = dma_channel_get_default_config(PACK16_DMA_CH_RX);
+    channel_config_set_transfer_data_size(&rxcfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&rxcfg, false);
+    channel_config_set_write_increment(&rxcfg, true);
+    channel_config_set_dreq(&rxcfg, pio_get_dreq(PACK16_PIO, PACK16_PIO_SM, false));
+    dma_channel_configure(PACK16_DMA_CH_RX, &rxcfg, NULL, &PACK16_PIO->rxf[PACK16_PIO_SM], 0, false);
+
+    g_ide_phy.pack16_available = true;
+    dbgmsg("PIO mode data is formatted by DMA channels ", (int)PACK16_DMA_CH_TX, "/", (int)PACK16_DMA_CH_RX,
+           " and PIO state machine ", (int)PACK16_PIO_SM);
+}
+
 void ide_phy_config(const ide_phy_config_t* config)
 {
     if (g_rp2350_passive_sniffer) return;
@@ -126,6 +231,11 @@ void ide_phy_config(const ide_phy_config_t* config)
         g_ide_phy.pio_iocs16_claimed = true;
     }
 
+    if (!g_ide_phy.pack16_claimed)
+    {
+        pack16_init();
+    }
+
     // Configure the PIO block that is used for IOCS16 signal handling
     if (config->disable_iocs16)
     {
@@ -417,6 +527,50 @@ static uint8_t *get_block_pointer()
     return block;
 }
 
+// Expand count 16 bit words to the 32 bit format used by core1.
+// When the helper state machine is available, DMA formats the first
+// half of the block while the CPU does the second half.
+static void format_pio_block(uint32_t *dst, const uint16_t *src, uint32_t count)
+{
+    uint32_t dma_count = 0;
+    if (g_ide_phy.pack16_available && count * 2 >= PACK16_DMA_MIN_BYTES && ((uint32_t)src & 3) == 0)
+    {
+        // Each 32 bit read from source gives two words
+        dma_count = (count / 2) & ~1;
+        dma_channel_set_write_addr(PACK16_DMA_CH_RX, dst, false);
+        dma_channel_set_trans_count(PACK16_DMA_CH_RX, dma_count, false);
+        dma_channel_set_read_addr(PACK16_DMA_CH_TX, src, false);
+        dma_channel_set_trans_count(PACK16_DMA_CH_TX, dma_count / 2, false);
+        dma_start_channel_mask((1 << PACK16_DMA_CH_RX) | (1 << PACK16_DMA_CH_TX));
+
+        src += dma_count;
+        dst += dma_count;
+        count -= dma_count;
+    }
+
+    while (count >= 4)
+    {
+        *dst++ = IDECOMM_DATAFORMAT_PIO(*src++);
+        *dst++ = IDECOMM_DATAFORMAT_PIO(*src++);
+        *dst++ = IDECOMM_DATAFORMAT_PIO(*src++);
+        *dst++ = IDECOMM_DATAFORMAT_PIO(*src++);
+        count -= 4;
+    }
+    while (count > 0)
+    {
+        *dst++ = IDECOMM_DATAFORMAT_PIO(*src++);
+        count--;
+    }
+
+    if (dma_count > 0)
+    {
+        while (dma_channel_is_busy(PACK16_DMA_CH_RX))
+        {
+            tight_loop_contents();
+        }
+    }
+}
+
 void ide_phy_write_block(const uint8_t *buf, uint32_t blocklen)
 {
     if (blocklen & 1) blocklen++;
@@ -430,22 +584,10 @@ void ide_phy_write_block(const uint8_t *buf, uint32_t blocklen)
     if (g_idecomm.udma_mode < 0)
     {
         // PIO data requires special formatting
-        const uint16_t *src = (const uint16_t*)buf;
-        uint32_t *dst = (uint32_t*)block;
-        uint32_t count = blocklen / 2;
-        while (count >= 4)
-        {
-            *dst++ = IDECOMM_DATAFORMAT_PIO(*src++);
-            *dst++ = IDECOMM_DATAFORMAT_PIO(*src++);
-            *dst++ = IDECOMM_DATAFORMAT_PIO(*src++);
-            *dst++ = IDECOMM_DATAFORMAT_PIO(*src++);
-            count -= 4;
-        }
-        while (count > 0)
-        {
-            *dst++ = IDECOMM_DATAFORMAT_PIO(*src++);
-            count--;
-        }
+        uint32_t start = time_us_32();
+        format_pio_block((uint32_t*)block, (const uint16_t*)buf, blocklen / 2);
+        g_ide_phy.pack_us += time_us_32() - start;
+        g_ide_phy.pack_bytes += blocklen;
     }
     else
     {
@@ -593,6 +735,15 @@ void ide_phy_stop_transfers(int *crc_errors)
     }
 
     if (crc_errors) *crc_errors = g_idecomm.udma_checksum_errors;
+
+    if (g_ide_phy.pack_bytes > 0 && g_ide_phy.pack_us > 0)
+    {
+        uint32_t cycles_per_kb = (uint64_t)g_ide_phy.pack_us * (g_idecomm.cpu_freq_hz / 1000000) * 1024 / g_ide_phy.pack_bytes;
+        dbgmsg("PIO data formatting: ", (int)g_ide_phy.pack_bytes, " bytes, ",
+               (int)cycles_per_kb, " cycles/KB by ", g_ide_phy.pack16_available ? "DMA and CPU" : "CPU");
+    }
+    g_ide_phy.pack_bytes = 0;
+    g_ide_phy.pack_us = 0;
 }
 
 void ide_phy_assert_irq(uint8_t ide_status)
@@ -0,0 +1,48 @@
+// -------------------------------------------------- //
+// This file is autogenerated by pioasm; do not edit! //
+// -------------------------------------------------- //
+
+#pragma once
+
+#if !PICO_NO_HARDWARE
+#include "hardware/pio.h"
+#endif
+
+// ------------- //
+// rp2350_pack16 //
+// ------------- //
+
+#define rp2350_pack16_wrap_target 0
+#define rp2350_pack16_wrap 2
+#define rp2350_pack16_pio_version 1
+
+static const uint16_t rp2350_pack16_program_instructions[] = {
+            //     .wrap_target
+    0x6030, //  0: out    x, 16                      
+    0x4050, //  1: in     y, 16                      
+    0x4030, //  2: in     x, 16                      
+            //     .wrap
+};
+
+#if !PICO_NO_HARDWARE
+static const struct pio_program rp2350_pack16_program = {
+    .instructions = rp2350_pack16_program_instructions,
+    .length = 3,
+    .origin = -1,
+    .pio_version = rp2350_pack16_pio_version,
+#if PICO_PIO_VERSION > 0
+    .used_gpio_ranges = 0x0
+#endif
+};
+
+static inline pio_sm_config rp2350_pack16_program_get_default_config(uint offset) {
+    pio_sm_config c = pio_get_default_sm_config();
+    sm_config_set_wrap(&c, offset + rp2350_pack16_wrap_target, offset + rp2350_pack16_wrap);
+    sm_config_set_in_pin_count(&c, 0);
+    sm_config_set_out_pin_count(&c, 0);
+    sm_config_set_out_shift(&c, 1, 1, 32);
+    sm_config_set_in_shift(&c, 0, 1, 32);
+    return c;
+}
+#endif
+
@@ -125,6 +125,9 @@ extern struct idecomm_t {
 #define IDE_PHY_DMAIRQ      3
 
 // Data buffers are transferred as pointers over the inter-core FIFO.
+// The buffers, this structure and the FIFO handoff are part of the interface
+// to the prebuilt core1 library. Core0 can have at most one block per FIFO
+// entry queued, and the buffer count must not be changed without rebuilding it.
 // The data needs to be padded to 32 bit words, of which 16 bits are the payload.
 // Top bits must be set to IDECOMM_DATA_PATTERN
 #define IDECOMM_MAX_BLOCKSIZE 8192
@@ -63,6 +63,7 @@ extern template void logmsg(const char*, const char*);
 static void processStatusUpdate(const zuluide::status::SystemStatus &currentStatus) {
     // Notify the hardware UI of updates.
     display.HandleUpdate(currentStatus);
+    display.FinishTransfer();
 
     // Notify the I2C server of updates.
      g_I2cServer.HandleUpdate(currentStatus);
@@ -233,6 +234,8 @@ void platform_set_device_control(zuluide::status::DeviceControlSafe* deviceContr
 
 void platform_close_i2c()
 {
+    display.FinishTransfer();
+
     // Release any clock-stretching slave and issue a STOP before closing,
     // so the slave is not left mid-transaction after the MCU reboots.
     recover_i2c_bus();
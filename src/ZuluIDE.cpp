@@ -53,10 +53,12 @@
 #include "control/std_display_controller.h"
 #include "control/control_interface.h"
 #include "ZuluIDE_create_image.h"
+#include "ZuluIDE_benchmark.h"
 #include "USB.h"
 #include "SerialUSB.h"
 
 #include <zip_parser.h>
+#include "ZuluIDE_firmware_zip.h"
 
 bool g_sdcard_present;
 extern SdFs SD;
@@ -174,6 +176,48 @@ void blinkStatus(uint8_t times, uint32_t delay = 500, uint32_t end_delay = 1250)
     }
 }
 
+/*****************/
+/* Boot timeline */
+/*****************/
+
+// Time spent in each startup phase, printed to the log once
+// the lazily initialized phases have also finished.
+static struct {
+    bool printed;
+    int count;
+    uint32_t prev_us;
+    struct {
+        const char *name;
+        uint32_t us;
+    } phases[BOOT_TIMELINE_MAX_PHASES];
+} g_boot_timeline;
+
+static void boot_phase_done(const char *name)
+{
+    uint32_t now = micros();
+    if (!g_boot_timeline.printed && g_boot_timeline.count < BOOT_TIMELINE_MAX_PHASES)
+    {
+        g_boot_timeline.phases[g_boot_timeline.count].name = name;
+        g_boot_timeline.phases[g_boot_timeline.count].us = now - g_boot_timeline.prev_us;
+        g_boot_timeline.count++;
+    }
+    g_boot_timeline.prev_us = now;
+}
+
+static void boot_timeline_print()
+{
+    if (g_boot_timeline.printed) return;
+    g_boot_timeline.printed = true;
+
+    // First phase is measured from reset
+    logmsg("Boot timeline:");
+    for (int i = 0; i < g_boot_timeline.count; i++)
+    {
+        logmsg("-- ", g_boot_timeline.phases[i].name, ": ", (int)g_boot_timeline.phases[i].us, " us");
+    }
+    logmsg("-- Total: ", (int)g_boot_timeline.prev_us, " us since reset");
+}
+
 /*********************************/
 /* SD card mounting              */
 /*********************************/
@@ -294,8 +338,21 @@ static void check_for_unused_update_files()
   }
 }
 
+static bool firmware_write_cb(void *param, const uint8_t *data, size_t len)
+{
+  FsFile *target = (FsFile*)param;
+  if (target->write(data, len) != len)
+  {
+    logmsg("Error writing extracted firmware to SD card");
+    return false;
+  }
+  return true;
+}
+
 // When given a .zip file for firmware update, extract the file
 // that matches this platform.
+// Normally the bootloader already flashed the package directly,
+// this handles it when that is disabled.
 static void firmware_update()
 {
   const char firmware_prefix[] = FIRMWARE_PREFIX;
@@ -324,63 +381,22 @@ static void firmware_update()
 
   logmsg("Found firmware package ", name);
 
-  const uint32_t target_filename_length = sizeof(FIRMWARE_NAME_PREFIX "_2025-02-21_e4be9ed.bin") - 1;
-  zipparser::Parser parser = zipparser::Parser(FIRMWARE_NAME_PREFIX, sizeof(FIRMWARE_NAME_PREFIX) - 1, target_filename_length);
-  uint8_t buf[512];
-  int32_t parsed_length;
-  int bytes_read = 0;
-  while ((bytes_read = file.read(buf, sizeof(buf))) > 0)
+  zipparser::Parser parser;
+  if (fwzip_find_entry(file, parser))
   {
-    parsed_length = parser.Parse(buf, bytes_read);
-    if (parsed_length == sizeof(buf))
-       continue;
-    if (parsed_length >= 0)
-    {
-      if (!parser.FoundMatch())
-      {
-        parser.Reset();
-        file.seekSet(file.position() - (sizeof(buf) - parsed_length) + parser.GetCompressedSize());
-      }
-      else
-      {
-        // seek to start of compressed data in matching file
-        file.seekSet(file.position() - (sizeof(buf) - parsed_length));
-        break;
-      }
-    }
-    if (parsed_length < 0)
-    {
-      logmsg("Filename character length of ", (int)target_filename_length , " with a prefix of ", FIRMWARE_NAME_PREFIX, " not found in ", name);
-      file.close();
-      root.close();
-      return;
-    }
-  }
-
-
-  if (parser.FoundMatch())
-  {
-    logmsg("Unzipping matching firmware with prefix: ", FIRMWARE_NAME_PREFIX);
+    logmsg("Unzipping matching firmware with prefix: ", FIRMWARE_NAME_PREFIX,
+           parser.GetMethod() == zipparser::Parser::METHOD_DEFLATE ? " (deflate)" : " (stored)");
     FsFile target_firmware;
     target_firmware.open(&root, FIRMWARE_NAME_PREFIX ".bin", O_BINARY | O_WRONLY | O_CREAT | O_TRUNC);
-    uint32_t position = 0;
-    while ((bytes_read = file.read(buf, sizeof(buf))) > 0)
-    {
-      if (bytes_read > parser.GetCompressedSize() - position)
-        bytes_read =  parser.GetCompressedSize() - position;
-      target_firmware.write(buf, bytes_read);
-      position += bytes_read;
-      if (position >= parser.GetCompressedSize())
-      {
-        break;
-      }
-    }
-    // zip file has a central directory at the end of the file,
-    // so the compressed data should never hit the end of the file
-    // so bytes read should always be greater than 0 for a valid datastream
-    if (bytes_read > 0)
+
+    // The IDE buffer is not in use yet, decompress through it in
+    // flash page sized pieces.
+    bool success = fwzip_extract(file, parser, (uint8_t*)g_ide_buffer, sizeof(g_ide_buffer),
+                                 PLATFORM_FLASH_PAGE_SIZE, firmware_write_cb, &target_firmware);
+    target_firmware.close();
+
+    if (success)
     {
-      target_firmware.close();
       file.close();
       root.remove(name);
       root.close();
@@ -389,8 +405,7 @@ static void firmware_update()
     }
     else
     {
-      target_firmware.close();
-      logmsg("Error reading firmware package file");
+      logmsg("Error extracting firmware package file");
       root.remove(FIRMWARE_NAME_PREFIX ".bin");
     }
   }
@@ -402,43 +417,342 @@ static void firmware_update()
 /* Log saving */
 /**************/
 
+// The log file is written in whole 512 byte sectors. The last partial
+// sector is padded with zeros and rewritten on the next save, and the
+// padding is trimmed off when the log file is opened again.
+// When the file was preallocated as a contiguous extent, the sectors
+// are written to the SD card directly without filesystem updates.
+// The extent is erased in LOG_ERASE_SECTORS chunks, always at least one sector
+// ahead of the log, so that the log text is followed by zeros up to a chunk boundary.
+static struct {
+    bool direct;             // Write sectors directly to the preallocated extent
+    uint32_t first_sector;   // First SD card sector of the extent
+    uint32_t extent_sectors; // Number of sectors in the extent
+    uint32_t erased_sectors; // Number of sectors at the start of the extent that are erased
+    uint32_t file_pos;       // File position where the next sector is written
+    uint32_t log_pos;        // Log buffer position that corresponds to file_pos
+    uint32_t tail_len;       // Bytes written after file_pos by the last save
+    uint32_t idle_ms;        // Bus idle time required before saving
+    uint32_t max_delay_ms;   // Maximum time log data is left unsaved
+    uint32_t sector[512 / 4];
+} g_log_writer = {false, 0, 0, 0, 0, 0, 0, LOG_IDLE_SAVE_MS, LOG_MAX_DELAY_MS};
+
+// Erase the next chunk of the preallocated extent
+static bool erase_log_chunk()
+{
+    uint32_t start = g_log_writer.erased_sectors;
+    uint32_t count = g_log_writer.extent_sectors - start;
+    if (count > LOG_ERASE_SECTORS) count = LOG_ERASE_SECTORS;
+    if (count == 0 || !SD.card()->erase(g_log_writer.first_sector + start, g_log_writer.first_sector + start + count - 1))
+    {
+        return false;
+    }
+
+    g_log_writer.erased_sectors += count;
+    return true;
+}
+
+static bool write_log_sector(const uint8_t *data)
+{
+    uint32_t sector = g_log_writer.file_pos / 512;
+    if (g_log_writer.direct && sector < g_log_writer.extent_sectors)
+    {
+        while (sector + 1 >= g_log_writer.erased_sectors &&
+               g_log_writer.erased_sectors < g_log_writer.extent_sectors)
+        {
+            if (!erase_log_chunk())
+            {
+                // Rest of the extent has unknown contents, release it and use normal appends
+                logmsg("Log file erase failed, continuing without preallocation");
+                g_log_writer.direct = false;
+                g_logfile.truncate(g_log_writer.file_pos);
+                break;
+            }
+        }
+
+        if (g_log_writer.direct)
+        {
+            return SD.card()->writeSectors(g_log_writer.first_sector + sector, data, 1);
+        }
+    }
+
+    return g_logfile.seekSet(g_log_writer.file_pos) && g_logfile.write(data, 512) == 512;
+}
+
+static void write_log_buffer()
+{
+    uint8_t *sector = (uint8_t*)g_log_writer.sector;
+    uint32_t pos = g_log_writer.log_pos;
+    uint32_t fill = 0;
+
+    while (true)
+    {
+        uint32_t available;
+        const char *data = log_get_buffer(&pos, &available);
+        uint32_t len = sizeof(g_log_writer.sector) - fill;
+        if (len > available) len = available;
+        pos -= available - len;
+        if (len == 0) break;
+
+        memcpy(sector + fill, data, len);
+        fill += len;
+
+        if (fill == sizeof(g_log_writer.sector))
+        {
+            if (!write_log_sector(sector)) break;
+            g_log_writer.file_pos += fill;
+            g_log_writer.log_pos = pos;
+            fill = 0;
+        }
+    }
+
+    g_log_writer.tail_len = fill;
+    if (fill > 0)
+    {
+        memset(sector + fill, 0, sizeof(g_log_writer.sector) - fill);
+        write_log_sector(sector);
+    }
+
+    g_logfile.flush();
+}
+
 void save_logfile(bool always = false)
 {
     if(!mutex_try_enter(platform_get_log_mutex(), 0)) {
       return;
     }
 
-    static uint32_t prev_log_pos = 0;
     static uint32_t prev_log_len = 0;
     static uint32_t prev_log_save = 0;
+    static uint32_t unsaved_since = 0;
+    static bool unsaved = false;
     uint32_t loglen = log_get_buffer_len();
 
-    if (loglen != prev_log_len && g_sdcard_present)
+    if (loglen != prev_log_len && g_sdcard_present && g_logfile.isOpen())
     {
-        // Save log at most every LOG_SAVE_INTERVAL_MS
-        if (always || (LOG_SAVE_INTERVAL_MS > 0 && (uint32_t)(millis() - prev_log_save) > LOG_SAVE_INTERVAL_MS))
+        uint32_t now = millis();
+        if (!unsaved)
         {
-            g_logfile.write(log_get_buffer(&prev_log_pos));
-            g_logfile.flush();
+            unsaved = true;
+            unsaved_since = now;
+        }
+
+        // Save log when the IDE bus has been idle for a while, at most every
+        // LOG_SAVE_INTERVAL_MS, unless the oldest message has waited too long.
+        bool idle = ide_protocol_idle_time() >= g_log_writer.idle_ms &&
+                    (uint32_t)(now - prev_log_save) > LOG_SAVE_INTERVAL_MS;
+        bool stale = (uint32_t)(now - unsaved_since) >= g_log_writer.max_delay_ms;
+        if (always || (LOG_SAVE_INTERVAL_MS > 0 && (idle || stale)))
+        {
+            write_log_buffer();
 
             prev_log_len = loglen;
             prev_log_save = millis();
+            unsaved = false;
         }
     }
 
     mutex_exit(platform_get_log_mutex());
 }
 
+// Remove the zero padding that the sector writer leaves after the last log line,
+// and release any preallocated space beyond it.
+static void trim_logfile(const char *path)
+{
+    FsFile file = SD.open(path, O_RDWR);
+    if (!file.isOpen())
+    {
+        return;
+    }
+
+    // Log text contains no zeros. After it there are zeros up to the end of the file,
+    // or in a partly erased extent up to a chunk boundary followed by old card contents.
+    // Find the first chunk that ends with a zero, then binary search the end of the text in it.
+    uint32_t len = file.fileSize();
+    const uint32_t chunk = LOG_ERASE_SECTORS * 512;
+    for (uint32_t pos = 0; pos < len; pos += chunk)
+    {
+        uint32_t last = (len - pos > chunk) ? pos + chunk - 1 : len - 1;
+        if (file.seekSet(last) && file.read() == 0)
+        {
+            uint32_t first = pos;
+            while (first < last)
+            {
+                uint32_t mid = (first + last) / 2;
+                if (file.seekSet(mid) && file.read() == 0)
+                    last = mid;
+                else
+                    first = mid + 1;
+            }
+
+            len = first;
+            break;
+        }
+    }
+
+    file.truncate(len);
+    file.close();
+}
+
+// Reserve a contiguous extent for the new log file.
+// On FAT the file size covers the whole extent, so it is cleared with SD card erase
+// and written sector by sector. Only the first chunk is erased here to keep boot fast,
+// write_log_sector() erases the rest as the log grows.
+// exFAT keeps track of the valid length by itself.
+static void preallocate_logfile()
+{
+    uint32_t begin = 0, end = 0;
+    if (LOG_PREALLOCATE_SIZE == 0 || !g_logfile.preAllocate(LOG_PREALLOCATE_SIZE))
+    {
+        return;
+    }
+
+    if (g_logfile.fileSize() == 0)
+    {
+        dbgmsg("-- Preallocated ", (int)(LOG_PREALLOCATE_SIZE / 1024), " kB for log file");
+        return;
+    }
+
+    uint8_t *sector = (uint8_t*)g_log_writer.sector;
+    bool contiguous = g_logfile.contiguousRange(&begin, &end) && g_logfile.sync();
+    g_log_writer.first_sector = begin;
+    g_log_writer.extent_sectors = contiguous ? end - begin + 1 : 0;
+    g_log_writer.erased_sectors = 0;
+    if (contiguous && erase_log_chunk() && SD.card()->readSectors(begin, sector, 1) &&
+        sector[0] == 0 && memcmp(sector, sector + 1, 511) == 0)
+    {
+        g_log_writer.direct = true;
+        dbgmsg("-- Preallocated ", (int)(LOG_PREALLOCATE_SIZE / 1024), " kB for log file at sector ", (int)begin);
+    }
+    else
+    {
+        // Contents of the extent are unknown, use normal appends instead
+        dbgmsg("-- Log file preallocation not usable");
+        g_logfile.truncate(0);
+    }
+}
+
+// Find the first free rotated log index with a single pass over the directory.
+// Returns LOG_ROTATE_MAX_FILES if all indexes are in use.
+static uint32_t find_next_rotate_index(FsFile *log_dir)
+{
+    uint8_t used[(LOG_ROTATE_MAX_FILES + 7) / 8] = {0};
+    char name[MAX_FILE_PATH + 1];
+    size_t prefix_len = strlen(LOGFILEROTATE);
+    FsFile entry;
+    log_dir->rewind();
+    while (entry.openNext(log_dir, O_RDONLY))
+    {
+        size_t len = entry.getName(name, sizeof(name));
+        entry.close();
+        if (len > prefix_len + 1 && strncasecmp(name, LOGFILEROTATE, prefix_len) == 0 && name[prefix_len] == '(')
+        {
+            uint32_t index = strtoul(name + prefix_len + 1, nullptr, 10);
+            if (index < LOG_ROTATE_MAX_FILES) used[index / 8] |= 1 << (index % 8);
+        }
+    }
+
+    uint32_t next = 0;
+    while (next < LOG_ROTATE_MAX_FILES && (used[next / 8] & (1 << (next % 8))))
+    {
+        next++;
+    }
+    return next;
+}
+
+// Move LOGFILEPREV into LOGFILEDIR as the next numbered file.
+// The next index is kept in a state file so that rotation does not need to
+// search the directory or copy data, regardless of the number and size of logs.
+static void rotate_prev_logfile()
+{
+    if (!SD.exists(LOGFILEPREV)) return;
+
+    // Attempt to open or create the log rotation directory
+    FsFile log_dir = SD.open(LOGFILEDIR, O_RDONLY);
+    if (!log_dir.isOpen())
+    {
+        SD.mkdir(LOGFILEDIR);
+        log_dir = SD.open(LOGFILEDIR, O_RDONLY);
+    }
+
+    if (!log_dir.isOpen() || !log_dir.isDir())
+    {
+        logmsg("Log rotation could not open ", LOGFILEDIR, " as a directory");
+        return;
+    }
+
+    char filename[32] = {0};
+    uint32_t next = 0;
+    bool have_state = false;
+    FsFile state;
+    if (state.open(&log_dir, LOGFILEROTATESTATE, O_RDONLY))
+    {
+        int len = state.read(filename, sizeof(filename) - 1);
+        state.close();
+        if (len > 0)
+        {
+            filename[len] = '\0';
+            next = strtoul(filename, nullptr, 10);
+            have_state = true;
+        }
+    }
+
+    // format file as LOGFILEROTATE(nnn).txt
+    snprintf(filename, sizeof(filename), "%s(%03lu).txt", LOGFILEROTATE, (unsigned long)next);
+    if (!have_state || next >= LOG_ROTATE_MAX_FILES || log_dir.exists(filename))
+    {
+        // State file missing, out of date or past the last index.
+        // Reuse indexes freed by deleting old logs.
+        next = find_next_rotate_index(&log_dir);
+        snprintf(filename, sizeof(filename), "%s(%03lu).txt", LOGFILEROTATE, (unsigned long)next);
+    }
+
+    if (next >= LOG_ROTATE_MAX_FILES)
+    {
+        logmsg("Rotation maximum reached, please delete files in the ", LOGFILEDIR, " directory");
+        log_dir.close();
+        return;
+    }
+
+    char path[sizeof(LOGFILEDIR) + sizeof(filename) + 1];
+    snprintf(path, sizeof(path), "%s/%s", LOGFILEDIR, filename);
+    if (!SD.rename(LOGFILEPREV, path))
+    {
+        logmsg("Log rotation could not move ", LOGFILEPREV, " to ", path);
+        log_dir.close();
+        return;
+    }
+
+    if (state.open(&log_dir, LOGFILEROTATESTATE, O_WRONLY | O_CREAT | O_TRUNC))
+    {
+        int len = snprintf(filename, sizeof(filename), "%lu\n", (unsigned long)(next + 1));
+        state.write(filename, len);
+        state.close();
+    }
+    log_dir.close();
+}
+
 void init_logfile()
 {
     static bool first_open_after_boot = true;
 
     if (first_open_after_boot)
     {
-        // Rotate file to LOGFILEPREV
         int log_rotate = ini_getl("IDE", "log_rotate", 1, CONFIGFILE);
+        g_log_writer.idle_ms = ini_getl("IDE", "log_idle_save_ms", LOG_IDLE_SAVE_MS, CONFIGFILE);
+        g_log_writer.max_delay_ms = ini_getl("IDE", "log_max_delay_ms", LOG_MAX_DELAY_MS, CONFIGFILE);
+
+        // Move the log of the boot before the previous one to LOGFILEDIR.
+        // The previous log stays in LOGFILEPREV until next boot.
+        if (log_rotate == 2)
+        {
+            rotate_prev_logfile();
+        }
+
+        // Rotate file to LOGFILEPREV
         if (log_rotate == 1 || log_rotate == 2)
         {
+            trim_logfile(LOGFILE);
             FsFile prev_log_file = SD.open(LOGFILE, O_RDONLY);
             if (prev_log_file.isOpen())
             {
@@ -450,98 +764,43 @@ void init_logfile()
                 prev_log_file.close();
             }
         }
-
-        // Copy LOGFILEPREV to a numbered file in the LOGFILEDIR directory
-        if (log_rotate == 2)
-        {
-            // Attempt to open or create the log rotation directory
-            FsFile prev_log_file = SD.open(LOGFILEPREV, O_RDONLY);
-            if (prev_log_file.isOpen())
-            {
-                FsFile log_dir = SD.open(LOGFILEDIR, O_RDWR);
-                if (!log_dir.isOpen())
-                {
-                    SD.mkdir(LOGFILEDIR);
-                    log_dir = SD.open(LOGFILEDIR);
-                }
-
-                if (log_dir.isOpen() && log_dir.isDir())
-                {
-                    char filename[32] = {0};
-                    for (uint32_t i = 0; i <= 1000; i++)
-                    {
-                        if (i >= 1000)
-                        {
-                            logmsg("Rotation maximum reached, please delete files in the ", LOGFILEDIR, " directory");
-                            break;
-                        }
-                        else
-                        {
-                            // format file as LOGFILEROTATE(nnn).txt
-                            snprintf(filename, sizeof(filename), "%s(%03lu).txt", LOGFILEROTATE, i);
-                            if (log_dir.exists(filename))
-                                continue;
-
-                            // Create and copy the file
-                            FsFile destination;
-                            if (destination.open(&log_dir, filename, O_CREAT | O_WRONLY))
-                            {
-                                // Write a copy of the LOGFILEPREV in the LOGFILEDIR directory
-                                while (true)
-                                {
-                                    int bytes_read = prev_log_file.read(g_ide_buffer, sizeof(g_ide_buffer));
-                                    if (bytes_read < 0)
-                                    {
-                                        logmsg("Log rotation error reading ", LOGFILEPREV, " to buffer");
-                                        break;
-                                    }
-                                    if (bytes_read > 0)
-                                    {
-                                        size_t bytes_written = destination.write((void *)g_ide_buffer, bytes_read);
-                                        if (bytes_written != bytes_read)
-                                        {
-                                            logmsg("Log rotation error writing ", LOGFILEPREV, " to ", filename);
-                                            break;
-                                        }
-                                    }
-                                    if (bytes_read != sizeof(g_ide_buffer))
-                                    {
-                                        break;
-                                    }
-                                }
-                                destination.close();
-                                break;
-                            }
-                            else
-                            {
-                                logmsg("Log rotation could not create ", filename, " in ", LOGFILEDIR);
-                                break;
-                            }
-                        }
-                    }
-                }
-                else
-                {
-                    logmsg("Log rotation could not open ", LOGFILEDIR, " as a directory");
-                }
-                log_dir.close();
-            }
-            prev_log_file.close();
-        }
+    }
+    else
+    {
+        // Continue after the data that was written before SD card removal
+        trim_logfile(LOGFILE);
+        g_log_writer.log_pos += g_log_writer.tail_len;
+        g_log_writer.tail_len = 0;
     }
 
     bool truncate = first_open_after_boot;
-    int flags = O_WRONLY | O_CREAT | (truncate ? O_TRUNC : O_APPEND);
+    int flags = O_WRONLY | O_CREAT | (truncate ? O_TRUNC : 0);
     g_logfile = SD.open(LOGFILE, flags);
+    g_log_writer.direct = false;
+    g_log_writer.file_pos = g_logfile.fileSize();
     if (!g_logfile.isOpen())
     {
         logmsg("Failed to open log file: ", SD.sdErrorCode());
     }
+    else if (truncate)
+    {
+        preallocate_logfile();
+    }
     save_logfile(true);
 
     first_open_after_boot = false;
 }
 
+// Save and close the log so that it can be read over USB mass storage.
+// On FAT this removes the zero padding of the preallocated extent.
+static void close_logfile()
+{
+    save_logfile(true);
+    g_logfile.close();
+    g_log_writer.direct = false;
+    trim_logfile(LOGFILE);
+}
+
 /**
  * Prefixes (hddr, zipd, etc) take priority over inferring (.iso extension) and normal files
  */
@@ -751,14 +1010,21 @@ static bool hasDualDriveImagesOnly()
 */
 void setupStatusController()
 {
+  // Also run again after an image has been created in the background,
+  // the observers must only be added once.
+  static bool observers_added = false;
+
   g_ControllerImageRequestPipe.Reset();
   g_ControllerImageResponsePipe.Reset();
-  g_ControllerImageRequestPipe.AddObserver(
-    [](zuluide::pipe::ImageRequest<zuluide::control::select_controller_source_t> t)
-    {
-      g_ControllerImageResponsePipe.HandleRequest(t);
-    }
-  );
+  if (!observers_added)
+  {
+    g_ControllerImageRequestPipe.AddObserver(
+      [](zuluide::pipe::ImageRequest<zuluide::control::select_controller_source_t> t)
+      {
+        g_ControllerImageResponsePipe.HandleRequest(t);
+      }
+    );
+  }
   platform_set_controller_image_response_pipe(&g_ControllerImageResponsePipe);
   g_StatusController.Reset();
   g_StatusController.SetFirmwareVersion(std::string(g_log_firmwareversion));
@@ -856,8 +1122,34 @@ void setupStatusController()
     g_StatusController.UpdateDeviceStatus(std::move(device));
   }
 
-  g_StatusController.AddObserver(status_observer);
+  if (!observers_added)
+  {
+    g_StatusController.AddObserver(status_observer);
+    observers_added = true;
+  }
+
+  // Controller and display are set up later by setupController()
+  g_StatusController.EndUpdate();
+  boot_phase_done("device setup");
 
+  if (g_ide_device->is_removable() && ini_getbool("IDE", "no_media_on_init", 0, CONFIGFILE))
+  {
+    g_ide_device->set_image(nullptr);
+    g_ide_device->set_loaded_without_media(true);
+    g_ide_device->set_load_first_image_cb(loadFirstImage);
+  }
+  else
+  {
+    g_ide_device->set_loaded_without_media(false);
+    loadFirstImage();
+  }
+  boot_phase_done("first image");
+}
+
+// Probing for the controller over I2C and initializing the display are slow,
+// so they are done from the main loop after the IDE bus is already served.
+static void setupController()
+{
   if (platform_check_for_controller())
   {
     platform_set_device_control(&g_StatusController);
@@ -880,22 +1172,8 @@ void setupStatusController()
     // This enables system updates to start flowing to the UI from this point forward.
     uiSafeStatusUpdater.Initialize(g_StatusController, true);
   }
-  else
-  {
-    g_StatusController.EndUpdate();
-  }
-
-  if (g_ide_device->is_removable() && ini_getbool("IDE", "no_media_on_init", 0, CONFIGFILE))
-  {
-    g_ide_device->set_image(nullptr);
-    g_ide_device->set_loaded_without_media(true);
-    g_ide_device->set_load_first_image_cb(loadFirstImage);
-  }
-  else
-  {
-    g_ide_device->set_loaded_without_media(false);
-    loadFirstImage();
-  }
+  platform_init_second_core();
+  boot_phase_done("controller");
 }
 
 void loadFirstImage() {
@@ -1133,6 +1411,9 @@ void load_image(const zuluide::images::Image& toLoad, bool insert)
 }
 
 
+// Maximum sleep per main loop iteration while the IDE bus is idle, 0 to never sleep
+static uint32_t g_main_loop_idle_wait_us = MAIN_LOOP_IDLE_WAIT_US;
+
 static void zuluide_reload_config()
 {
   if (ini_haskey("IDE", "debug", CONFIGFILE))
@@ -1171,11 +1452,35 @@ static void zuluide_reload_config()
 
   uint8_t eject_button = ini_getl("IDE", "eject_button", 1, CONFIGFILE);
   platform_init_eject_button(eject_button);
+
+  g_main_loop_idle_wait_us = ini_getl("IDE", "idle_wait_us", MAIN_LOOP_IDLE_WAIT_US, CONFIGFILE);
+}
+
+// Let the host see a busy drive while the rest of initialization runs.
+// Needs the SD card only for checking the configuration.
+static void zuluide_early_phy_init()
+{
+    static bool done = false;
+    if (done) return;
+    done = true;
+
+    // Passive sniffer must not drive the bus
+    if (ini_getl("IDE", "sniffer", 0, CONFIGFILE) == SNIFFER_PASSIVE ||
+        !ini_getbool("IDE", "early_phy_init", true, CONFIGFILE))
+    {
+        return;
+    }
+
+    ide_protocol_early_init(platform_get_device_id());
+    boot_phase_done("early IDE PHY");
 }
 
 static void zuluide_setup_sd_card()
 {
     g_sdcard_present = mountSDCard();
+    boot_phase_done("SD card mount");
+    zuluide_early_phy_init();
+
     if(!g_sdcard_present)
     {
         g_StatusController.SetIsCardPresent(false);
@@ -1198,19 +1503,32 @@ static void zuluide_setup_sd_card()
 
         check_for_unused_update_files();
         firmware_update();
-        searchAndCreateImage((uint8_t*) g_ide_buffer, sizeof(g_ide_buffer));
+        searchAndRunBenchmark((uint8_t*) g_ide_buffer, sizeof(g_ide_buffer));
+        if (searchAndCreateImage((uint8_t*) g_ide_buffer, sizeof(g_ide_buffer)))
+        {
+            // Small or fast to clear images are ready before the first image is loaded,
+            // larger ones continue from the main loop.
+            if (createImagePoll((uint8_t*) g_ide_buffer, sizeof(g_ide_buffer), CREATEFILE_BOOT_WAIT_MS))
+            {
+                logmsg("-- Image creation continues in background");
+            }
+        }
     }
+    boot_phase_done("SD card setup");
 }
 
 
 void zuluide_init(void)
 {
   platform_init();
+  boot_phase_done("platform init");
   platform_late_init();
+  boot_phase_done("platform late init");
   zuluide_setup_sd_card();
   zuluide_reload_config();
   USB.begin();
   Serial.begin(115200);
+  boot_phase_done("config and USB");
 
 #ifdef PLATFORM_MASS_STORAGE
   static bool check_mass_storage = true;
@@ -1225,7 +1543,9 @@ void zuluide_init(void)
         // Enter MSC mode if forced by menu reboot or USB host is detected.
         if (forced_msc || platform_sense_msc())
         {
+          close_logfile();
           zuluide_msc_loop();
+          boot_phase_done("USB mass storage");
           logmsg("Re-processing filenames and zuluide.ini config parameters");
           zuluide_setup_sd_card();
         }
@@ -1259,64 +1579,136 @@ void zuluide_init(void)
   }
 #endif
 
+  boot_phase_done("startup");
   blinkStatus(BLINK_STATUS_OK);
   logmsg("Initialization complete!");
 }
 
-void zuluide_main_loop(void)
+/*********************************/
+/* Main loop task scheduling     */
+/*********************************/
+
+// The main loop runs each task to completion in priority order. IDE events
+// are polled again before every lower priority task, so a new command waits
+// for at most one task instead of a full loop iteration.
+typedef struct {
+    const char *name;
+    void (*func)();
+    uint32_t max_us; // Longest single run since stats were last logged
+} main_task_t;
+
+static uint32_t g_sd_card_check_time;
+static uint32_t g_splash_check_time;
+static bool g_splash_over;
+
+static void task_ide()
 {
-    static uint32_t sd_card_check_time;
-    static uint32_t splash_check_time;
-    static bool splash_over = false;
-    static bool first_loop = true;
+    if (g_sniffer_mode != SNIFFER_PASSIVE)
+    {
+        ide_protocol_poll();
+    }
 
-    if (first_loop)
+#ifdef PLATFORM_HAS_SNIFFER
+    if (g_sniffer_mode != SNIFFER_OFF)
     {
-        // Give time for basic initialization to run
-        // before checking SD card
-        sd_card_check_time = millis() + 1000;
-        splash_check_time = millis();
-        first_loop = false;
+        platform_sniffer_poll();
     }
-    platform_reset_watchdog();
+#endif
+}
+
+// Audio buffer refill, USB and voltage monitoring
+static void task_platform()
+{
     platform_poll(true);
+}
+
+static void task_log()
+{
+    save_logfile();
+}
+
+static void task_ui()
+{
     g_ide_device->eject_button_poll(true);
     blink_poll();
 
     g_StatusController.ProcessUpdates();
     g_ControllerImageRequestPipe.ProcessUpdates();
-    
+
     // Checks after 3 seconds if we are still on the Splash screen ( for example if there is no SD card)
-    if (!splash_over && (uint32_t)(millis() - splash_check_time) > 3000)
+    if (!g_splash_over && (uint32_t)(millis() - g_splash_check_time) > 3000)
     {
-      if (g_DisplayController.GetMode() == zuluide::control::Mode::Splash)
-      {
-        // Need to force a status controller update to move beyond the Splash screen
-        g_StatusController.SetFirmwareVersion(std::string(g_log_firmwareversion));
-      }
-      splash_over = true;
+        if (g_DisplayController.GetMode() == zuluide::control::Mode::Splash)
+        {
+            // Need to force a status controller update to move beyond the Splash screen
+            g_StatusController.SetFirmwareVersion(std::string(g_log_firmwareversion));
+        }
+        g_splash_over = true;
     }
+}
 
-    save_logfile();
+// Drive type and first image were selected at boot while the image was still
+// being created under a temporary name. If nothing got loaded, select them again
+// now that the image exists, e.g. "Create_1024M_HD40.txt" becomes a hard drive.
+static void reselect_device_after_create()
+{
+    if (!g_ide_device || g_ide_device->has_image() || g_ide_device->is_loaded_without_media())
+    {
+        return;
+    }
 
-    if (g_sniffer_mode != SNIFFER_PASSIVE)
+    logmsg("Image creation finished with no image loaded, selecting device again");
+    clear_image();
+    g_ide_imagefile.close();
+    g_ide_imagefile = IDEImageFile((uint8_t*)g_ide_buffer, sizeof(g_ide_buffer));
+    g_loadedFirstImage = false;
+    setupStatusController();
+
+    if (!g_ide_device->is_medium_present())
     {
-      ide_protocol_poll();
+        g_ide_device->eject_media();
     }
+}
 
-#ifdef PLATFORM_HAS_SNIFFER
-    if (g_sniffer_mode != SNIFFER_OFF)
+static void task_create_image()
+{
+    if (g_sdcard_present && createImageInProgress())
     {
-      platform_sniffer_poll();
+        if (!createImagePoll((uint8_t*) g_ide_buffer, sizeof(g_ide_buffer), CREATEFILE_STEP_MS) &&
+            createImageCompleted())
+        {
+            reselect_device_after_create();
+        }
     }
-#endif
+}
+
+// Set from the USB console, which can be polled in the middle of an IDE transfer
+static bool g_benchmark_requested = false;
 
+static void task_benchmark()
+{
+    if (g_benchmark_requested)
+    {
+        g_benchmark_requested = false;
+        if (g_sdcard_present && !createImageInProgress())
+        {
+            runBenchmark((uint8_t*) g_ide_buffer, sizeof(g_ide_buffer));
+        }
+        else
+        {
+            logmsg("SD card benchmark needs an SD card and no image creation in progress");
+        }
+    }
+}
+
+static void task_sd_card()
+{
     if (g_sdcard_present)
     {
         // Check SD card status for hotplug
-        if ((uint32_t)(millis() - sd_card_check_time) > 5000)
+        if ((uint32_t)(millis() - g_sd_card_check_time) > 5000)
         {
-            sd_card_check_time = millis();
+            g_sd_card_check_time = millis();
             if (!poll_sd_card())
             {
                 if (!poll_sd_card())
@@ -1324,6 +1716,7 @@ void zuluide_main_loop(void)
                     g_sdcard_present = false;
                     g_StatusController.SetIsCardPresent(false);
                     logmsg("SD card removed, trying to reinit");
+                    createImageAbort();
                     if (g_ide_device->is_removable())
                     {
                         g_ide_device->eject_media();
@@ -1343,7 +1736,7 @@ void zuluide_main_loop(void)
         }
     }
 
-    if (!g_sdcard_present && (uint32_t)(millis() - sd_card_check_time) > 1000)
+    if (!g_sdcard_present && (uint32_t)(millis() - g_sd_card_check_time) > 1000)
     {
         // Try to remount SD card
         g_sdcard_present = mountSDCard();
@@ -1355,6 +1748,7 @@ void zuluide_main_loop(void)
 
             init_logfile();
             zuluide_reload_config();
+            searchAndRunBenchmark((uint8_t*) g_ide_buffer, sizeof(g_ide_buffer));
             searchAndCreateImage((uint8_t*) g_ide_buffer, sizeof(g_ide_buffer));
 
             g_StatusController.SetIsCardPresent(true);
@@ -1376,7 +1770,94 @@ void zuluide_main_loop(void)
             blinkStatus(BLINK_ERROR_NO_SD_CARD);
         }
 
-        sd_card_check_time = millis();
+        g_sd_card_check_time = millis();
+    }
+}
+
+static main_task_t g_ide_task = {"IDE", task_ide, 0};
+
+// Lower priority tasks, highest priority first
+static main_task_t g_main_tasks[] = {
+    {"audio/USB", task_platform, 0},
+    {"log", task_log, 0},
+    {"UI/I2C", task_ui, 0},
+    {"image create", task_create_image, 0},
+    {"benchmark", task_benchmark, 0},
+    {"SD card", task_sd_card, 0},
+};
+
+static void run_task(main_task_t *task)
+{
+    uint32_t start = micros();
+    task->func();
+    uint32_t elapsed = micros() - start;
+    if (elapsed > task->max_us)
+    {
+        task->max_us = elapsed;
+    }
+}
+
+// Log the longest run of each task, to find sources of IDE command latency
+static void task_stats_poll()
+{
+    static uint32_t prev_log_time;
+    if ((uint32_t)(millis() - prev_log_time) < MAIN_LOOP_TASK_STATS_INTERVAL_MS)
+    {
+        return;
+    }
+    prev_log_time = millis();
+
+    dbgmsg("Main loop task max runtime:");
+    dbgmsg("-- ", g_ide_task.name, ": ", (int)g_ide_task.max_us, " us");
+    g_ide_task.max_us = 0;
+    for (size_t i = 0; i < sizeof(g_main_tasks) / sizeof(g_main_tasks[0]); i++)
+    {
+        dbgmsg("-- ", g_main_tasks[i].name, ": ", (int)g_main_tasks[i].max_us, " us");
+        g_main_tasks[i].max_us = 0;
+    }
+}
+
+void zuluide_main_loop(void)
+{
+    static bool first_loop = true;
+    static bool controller_setup_done = false;
+
+    if (first_loop)
+    {
+        // Give time for basic initialization to run
+        // before checking SD card
+        g_sd_card_check_time = millis() + 1000;
+        g_splash_check_time = millis();
+        first_loop = false;
+    }
+    platform_reset_watchdog();
+
+    for (size_t i = 0; i < sizeof(g_main_tasks) / sizeof(g_main_tasks[0]); i++)
+    {
+        run_task(&g_ide_task);
+        run_task(&g_main_tasks[i]);
+    }
+
+    if (!controller_setup_done)
+    {
+        // The first poll has handled the reset event and the drive is no longer
+        // busy, so the host can continue while the I2C bus is probed.
+        boot_phase_done("first IDE poll");
+        setupController();
+        boot_timeline_print();
+        controller_setup_done = true;
+    }
+
+    task_stats_poll();
+
+    // Nothing is expected to happen soon, sleep until the next interrupt.
+    // The sniffer and image creation keep the loop running at full speed.
+    if (g_main_loop_idle_wait_us > 0 &&
+        g_sniffer_mode == SNIFFER_OFF &&
+        !createImageInProgress() &&
+        ide_protocol_idle_time() >= MAIN_LOOP_IDLE_WAIT_AFTER_MS)
+    {
+        platform_wait_for_event(g_main_loop_idle_wait_us);
     }
 }
 
@@ -1408,6 +1889,12 @@ static IDEImageFile *console_get_imgfile(int idx)
     return nullptr;
 }
 
+// Run the SD card benchmark from the main loop when the IDE bus is between commands
+void zuluide_console_run_benchmark()
+{
+    g_benchmark_requested = true;
+}
+
 int zuluide_console_device_count()
 {
     int n = (g_ide_device != nullptr) ? 1 : 0;
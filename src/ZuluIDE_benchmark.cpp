@@ -0,0 +1,325 @@
+/**
+ * ZuluIDE™ - Copyright (c) 2026 Rabbit Hole Computing™
+ *
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version.
+ *
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional
+ * permissions described in the ZuluIDE Hardware Support Library Exception
+ * (GPL-3.0_HSL_Exception.md), as published by Rabbit Hole Computing™.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include <SdFat.h>
+#include <cstring>
+#include <ZuluIDE_platform.h>
+#include "ZuluIDE_config.h"
+#include "ZuluIDE_log.h"
+#include "ZuluIDE_benchmark.h"
+#include "ide_imagefile.h"
+
+extern "C" unsigned long micros();
+extern SdFs SD;
+
+enum bench_layer_t { BENCH_RAW, BENCH_FILE, BENCH_IMAGE };
+
+static const char *const g_bench_layer_names[] = {"raw", "file", "image"};
+
+static const uint32_t g_bench_sizes[] = {512, 4096, 65536};
+
+// State shared by all tests of one benchmark run
+static struct {
+    FsFile file;
+    IDEImageFile *image;
+    uint32_t first_sector; // Start of the test file on the SD card, 0 if not contiguous
+    uint32_t file_size;
+    uint8_t *buf;
+} g_bench;
+
+// Image layer results are consumed without copying and write data is available
+// at once, so that only the cost of the image file code and the SD card is measured.
+class BenchmarkNullCallback: public IDEImage::Callback
+{
+public:
+    virtual ssize_t read_callback(const uint8_t *data, size_t blocksize, size_t num_blocks) override
+    {
+        return num_blocks;
+    }
+
+    virtual ssize_t write_callback(uint8_t *data, size_t blocksize, size_t num_blocks, bool first_xfer, bool last_xfer) override
+    {
+        return num_blocks;
+    }
+};
+
+// Run a single access of 'size' bytes at 'offset' in the test file
+static bool bench_access(bench_layer_t layer, bool write, uint32_t offset, uint32_t size)
+{
+    if (layer == BENCH_RAW)
+    {
+        uint32_t sector = g_bench.first_sector + offset / 512;
+        if (write)
+            return SD.card()->writeSectors(sector, g_bench.buf, size / 512);
+        else
+            return SD.card()->readSectors(sector, g_bench.buf, size / 512);
+    }
+    else if (layer == BENCH_FILE)
+    {
+        if (!g_bench.file.seekSet(offset))
+            return false;
+        if (write)
+            return g_bench.file.write(g_bench.buf, size) == size;
+        else
+            return g_bench.file.read(g_bench.buf, size) == (int)size;
+    }
+    else
+    {
+        BenchmarkNullCallback callback;
+        if (write)
+            return g_bench.image->write(offset, 512, size / 512, &callback);
+        else
+            return g_bench.image->read(offset, 512, size / 512, &callback);
+    }
+}
+
+// Repeat accesses for BENCHMARK_TEST_MS and log the result line
+static void bench_run_test(bench_layer_t layer, bool write, bool random, uint32_t size)
+{
+    // Random offsets are aligned to the access size and repeatable between runs
+    uint32_t seed = size;
+    uint32_t slots = g_bench.file_size / size;
+    uint32_t ops = 0;
+    uint32_t max_us = 0;
+    bool ok = true;
+
+    uint32_t start_ms = millis();
+    uint32_t start_us = micros();
+    while ((uint32_t)(millis() - start_ms) < BENCHMARK_TEST_MS)
+    {
+        uint32_t slot;
+        if (random)
+        {
+            seed = seed * 1103515245 + 12345;
+            slot = (seed >> 8) % slots;
+        }
+        else if (ops < slots)
+        {
+            slot = ops;
+        }
+        else
+        {
+            // Whole file has been accessed sequentially
+            break;
+        }
+
+        uint32_t op_start = micros();
+        if (!bench_access(layer, write, slot * size, size))
+        {
+            ok = false;
+            break;
+        }
+        uint32_t op_us = micros() - op_start;
+        if (op_us > max_us) max_us = op_us;
+
+        ops++;
+        platform_reset_watchdog();
+    }
+
+    if (ok && write && layer == BENCH_FILE)
+    {
+        // Data buffered in the filesystem cache is part of the write cost
+        ok = g_bench.file.sync();
+    }
+
+    uint32_t us = micros() - start_us;
+    uint64_t bytes = (uint64_t)ops * size;
+    uint32_t kbps = (us > 0) ? (uint32_t)(bytes * 1000 / us) : 0;
+    uint32_t iops = (us > 0) ? (uint32_t)((uint64_t)ops * 1000000 / us) : 0;
+    uint32_t avg_us = (ops > 0) ? us / ops : 0;
+
+    logmsg("BENCH layer=", g_bench_layer_names[layer],
+           " op=", write ? "write" : "read",
+           " pattern=", random ? "random" : "seq",
+           " size=", (int)size,
+           " ops=", (int)ops,
+           " bytes=", (int)bytes,
+           " us=", (int)us,
+           " kBps=", (int)kbps,
+           " iops=", (int)iops,
+           " avg_us=", (int)avg_us,
+           " max_us=", (int)max_us,
+           " status=", ok ? "ok" : "error");
+
+    platform_poll();
+}
+
+// Run all sizes and access patterns for one layer
+static void bench_run_layer(bench_layer_t layer, bool write, size_t buf_len)
+{
+    for (int random = 0; random < 2; random++)
+    {
+        for (size_t i = 0; i < sizeof(g_bench_sizes) / sizeof(g_bench_sizes[0]); i++)
+        {
+            uint32_t size = g_bench_sizes[i];
+            if (size > buf_len || size > g_bench.file_size)
+            {
+                logmsg("BENCH layer=", g_bench_layer_names[layer],
+                       " op=", write ? "write" : "read",
+                       " pattern=", random ? "random" : "seq",
+                       " size=", (int)size,
+                       " status=skipped");
+                continue;
+            }
+
+            bench_run_test(layer, write, random, size);
+        }
+    }
+}
+
+// Create the test file and write it full once, so that reads return real data
+// and later writes do not extend the file.
+static bool bench_create_file(size_t buf_len)
+{
+    SD.remove(BENCHMARK_TMP_FILE);
+    g_bench.file = SD.open(BENCHMARK_TMP_FILE, O_RDWR | O_CREAT | O_TRUNC);
+    if (!g_bench.file.isOpen())
+    {
+        logmsg("BENCH error: could not create '", BENCHMARK_TMP_FILE, "'");
+        return false;
+    }
+
+    if (!g_bench.file.preAllocate(g_bench.file_size))
+    {
+        logmsg("BENCH note: preallocation failed, file may be fragmented");
+    }
+
+    uint32_t chunk = (buf_len < 65536) ? (buf_len & ~511) : 65536;
+    memset(g_bench.buf, 0xAA, chunk);
+
+    uint32_t start_us = micros();
+    for (uint32_t pos = 0; pos < g_bench.file_size; pos += chunk)
+    {
+        if (g_bench.file.write(g_bench.buf, chunk) != chunk)
+        {
+            logmsg("BENCH error: writing '", BENCHMARK_TMP_FILE, "' failed at ", (int)pos);
+            return false;
+        }
+        platform_reset_watchdog();
+    }
+
+    if (!g_bench.file.sync())
+    {
+        logmsg("BENCH error: sync of '", BENCHMARK_TMP_FILE, "' failed");
+        return false;
+    }
+
+    uint32_t us = micros() - start_us;
+    logmsg("BENCH layer=file op=write pattern=fill size=", (int)chunk,
+           " ops=", (int)(g_bench.file_size / chunk),
+           " bytes=", (int)g_bench.file_size,
+           " us=", (int)us,
+           " kBps=", (int)((uint64_t)g_bench.file_size * 1000 / us),
+           " status=ok");
+
+    uint32_t begin, end;
+    if (g_bench.file.contiguousRange(&begin, &end))
+    {
+        g_bench.first_sector = begin;
+    }
+    else
+    {
+        g_bench.first_sector = 0;
+    }
+
+    return true;
+}
+
+bool runBenchmark(uint8_t *buf, size_t buf_len)
+{
+    g_bench.image = nullptr;
+    g_bench.first_sector = 0;
+    g_bench.buf = buf;
+    g_bench.file_size = BENCHMARK_FILE_SIZE;
+
+    cid_t sd_cid = {};
+    SD.card()->readCID(&sd_cid);
+    char sdname[6] = {sd_cid.pnm[0], sd_cid.pnm[1], sd_cid.pnm[2], sd_cid.pnm[3], sd_cid.pnm[4], 0};
+    logmsg("BENCH start version=", g_log_firmwareversion,
+           " sd_mid=", (uint8_t)sd_cid.mid,
+           " sd_name=", sdname,
+           " sd_serial=", sd_cid.psn(),
+           " file_size=", (int)g_bench.file_size,
+           " test_ms=", (int)BENCHMARK_TEST_MS);
+
+    LED_ON();
+    bool ok = bench_create_file(buf_len);
+
+    if (ok)
+    {
+        if (g_bench.first_sector != 0)
+        {
+            bench_run_layer(BENCH_RAW, true, buf_len);
+            bench_run_layer(BENCH_RAW, false, buf_len);
+        }
+        else
+        {
+            logmsg("BENCH layer=raw status=skipped reason=not_contiguous");
+        }
+
+        bench_run_layer(BENCH_FILE, true, buf_len);
+        bench_run_layer(BENCH_FILE, false, buf_len);
+    }
+
+    g_bench.file.close();
+
+    if (ok)
+    {
+        // The image file uses the same buffer for its transfers
+        IDEImageFile image(buf, buf_len);
+        if (image.open_file(BENCHMARK_TMP_FILE, false))
+        {
+            g_bench.image = &image;
+            bench_run_layer(BENCH_IMAGE, true, buf_len);
+            bench_run_layer(BENCH_IMAGE, false, buf_len);
+            image.close();
+        }
+        else
+        {
+            logmsg("BENCH layer=image status=error reason=open_failed");
+        }
+        g_bench.image = nullptr;
+    }
+
+    SD.remove(BENCHMARK_TMP_FILE);
+    LED_OFF();
+
+    logmsg("BENCH done status=", ok ? "ok" : "error");
+    return ok;
+}
+
+bool searchAndRunBenchmark(uint8_t *buf, size_t buf_len)
+{
+    if (!SD.exists(BENCHMARKFILE))
+    {
+        return false;
+    }
+
+    // Removed before starting so that a crash during the run doesn't repeat it on every boot
+    logmsg("Found '", BENCHMARKFILE, "', running SD card benchmark");
+    SD.remove(BENCHMARKFILE);
+    runBenchmark(buf, buf_len);
+    return true;
+}
@@ -0,0 +1,43 @@
+/**
+ * ZuluIDE™ - Copyright (c) 2026 Rabbit Hole Computing™
+ *
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version.
+ *
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional
+ * permissions described in the ZuluIDE Hardware Support Library Exception
+ * (GPL-3.0_HSL_Exception.md), as published by Rabbit Hole Computing™.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#pragma once
+
+// Built-in SD card benchmark.
+// Measures sequential and random access through the raw SD card sectors,
+// the filesystem and the image file layer, and reports the results in the log.
+// Each result is one line starting with "BENCH" with key=value fields.
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Run the benchmark if the command file BENCHMARKFILE exists on the SD card.
+// The command file is removed afterwards so that the benchmark runs only once.
+// Returns true if the benchmark was run.
+bool searchAndRunBenchmark(uint8_t *buf, size_t buf_len);
+
+// Run the benchmark using buf as the transfer buffer.
+// Blocks until done, which takes roughly 45 seconds.
+bool runBenchmark(uint8_t *buf, size_t buf_len);
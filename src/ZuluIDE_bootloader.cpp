@@ -28,6 +28,7 @@
 #include <ZuluIDE_platform.h>
 #include "ZuluIDE_config.h"
 #include "ZuluIDE_log.h"
+#include "ZuluIDE_firmware_zip.h"
 #include <SdFat.h>
 #include <string.h>
 
@@ -64,6 +65,54 @@ bool find_firmware_image(FsFile &file, char name[MAX_FILE_PATH + 1])
     return false;
 }
 
+// Pages are read from SD card in batches, one multi-sector read is much
+// faster than separate page sized reads.
+#define BOOTLOADER_READ_BATCH_PAGES 8
+
+// Typical erase + program time of one page, used for the time saved estimate
+// when no page needed programming.
+#define BOOTLOADER_PAGE_PROGRAM_MS_ESTIMATE 50
+
+struct flash_stats_t
+{
+    uint32_t start_time;
+    uint32_t program_time;
+    uint32_t programmed;
+    uint32_t unchanged;
+};
+
+// Program one page unless flash already holds the same data
+static bool flash_page_if_changed(uint32_t offset, uint8_t *buffer, flash_stats_t &stats)
+{
+    if (platform_flash_page_matches(offset, buffer))
+    {
+        stats.unchanged++;
+        return true;
+    }
+
+    uint32_t start = millis();
+    if (!platform_rewrite_flash_page(offset, buffer))
+    {
+        return false;
+    }
+
+    stats.program_time += (uint32_t)(millis() - start);
+    stats.programmed++;
+    return true;
+}
+
+static void log_flash_stats(const flash_stats_t &stats)
+{
+    uint32_t per_page = BOOTLOADER_PAGE_PROGRAM_MS_ESTIMATE;
+    if (stats.programmed > 0)
+        per_page = stats.program_time / stats.programmed;
+
+    logmsg("Firmware flashed in ", (int)(millis() - stats.start_time), " ms: ",
+           (int)stats.programmed, " pages programmed, ",
+           (int)stats.unchanged, " unchanged pages skipped, saving about ",
+           (int)(stats.unchanged * per_page), " ms");
+}
+
 bool program_firmware(FsFile &file)
 {
     uint32_t filesize = file.size();
@@ -71,7 +120,7 @@ bool program_firmware(FsFile &file)
     uint32_t num_pages = (fwsize + PLATFORM_FLASH_PAGE_SIZE - 1) / PLATFORM_FLASH_PAGE_SIZE;
 
     // Make sure the buffer is aligned to word boundary
-    static uint32_t buffer32[PLATFORM_FLASH_PAGE_SIZE / 4];
+    static uint32_t buffer32[BOOTLOADER_READ_BATCH_PAGES * PLATFORM_FLASH_PAGE_SIZE / 4];
     uint8_t *buffer = (uint8_t*)buffer32;
 
     if (filesize > PLATFORM_FLASH_TOTAL_SIZE)
@@ -86,29 +135,157 @@ bool program_firmware(FsFile &file)
         return false;
     }
 
-    for (int i = 0; i < num_pages; i++)
+    flash_stats_t stats = {};
+    stats.start_time = millis();
+
+    for (int i = 0; i < num_pages; i += BOOTLOADER_READ_BATCH_PAGES)
     {
-        if (i % 2)
+        if ((i / BOOTLOADER_READ_BATCH_PAGES) % 2)
             LED_ON();
         else
             LED_OFF();
-        
-        if (file.read(buffer, PLATFORM_FLASH_PAGE_SIZE) <= 0)
+
+        int batch = num_pages - i;
+        if (batch > BOOTLOADER_READ_BATCH_PAGES)
+            batch = BOOTLOADER_READ_BATCH_PAGES;
+
+        int bytes_read = file.read(buffer, batch * PLATFORM_FLASH_PAGE_SIZE);
+        if (bytes_read <= 0)
         {
             logmsg("Firmware file read failed on page ", i);
             return false;
         }
 
-        if (!platform_rewrite_flash_page(PLATFORM_BOOTLOADER_SIZE + i * PLATFORM_FLASH_PAGE_SIZE, buffer))
+        // Fill the end of a partial last page so that it compares consistently
+        if (bytes_read < batch * PLATFORM_FLASH_PAGE_SIZE)
+            memset(buffer + bytes_read, 0xFF, batch * PLATFORM_FLASH_PAGE_SIZE - bytes_read);
+
+        for (int j = 0; j < batch; j++)
         {
-            logmsg("Flash programming failed on page ", i);
-            return false;
+            uint32_t offset = PLATFORM_BOOTLOADER_SIZE + (i + j) * PLATFORM_FLASH_PAGE_SIZE;
+            if (!flash_page_if_changed(offset, buffer + j * PLATFORM_FLASH_PAGE_SIZE, stats))
+            {
+                logmsg("Flash programming failed on page ", i + j);
+                return false;
+            }
         }
     }
 
+    log_flash_stats(stats);
+    return true;
+}
+
+#if FIRMWARE_ZIP_DIRECT_FLASH
+
+bool find_firmware_package(FsFile &file, char name[MAX_FILE_PATH + 1])
+{
+    FsFile root;
+    root.open("/");
+
+    while (file.openNext(&root, O_READ))
+    {
+        if (file.isDir()) continue;
+
+        int namelen = file.getName(name, MAX_FILE_PATH);
+
+        if (namelen >= sizeof(FIRMWARE_PREFIX) + 3 &&
+            strncasecmp(name, FIRMWARE_PREFIX, sizeof(FIRMWARE_PREFIX) - 1) == 0 &&
+            strncasecmp(name + namelen - 3, "zip", 3) == 0)
+        {
+            root.close();
+            logmsg("Found firmware package: ", name);
+            return true;
+        }
+
+        file.close();
+    }
+
+    root.close();
+    return false;
+}
+
+struct zip_flash_state_t
+{
+    uint32_t offset;
+    uint32_t page;
+    flash_stats_t stats;
+};
+
+static bool zip_flash_page_cb(void *param, const uint8_t *data, size_t len)
+{
+    zip_flash_state_t *state = (zip_flash_state_t*)param;
+    uint32_t offset = state->offset;
+    state->offset += len;
+
+    // The bootloader part of the image is never reprogrammed
+    if (offset < PLATFORM_BOOTLOADER_SIZE)
+        return true;
+
+    if (state->page++ % 2)
+        LED_ON();
+    else
+        LED_OFF();
+
+    // Last page may be partial, extraction chunks are page aligned
+    uint8_t *buffer = (uint8_t*)data;
+    if (len < PLATFORM_FLASH_PAGE_SIZE)
+        memset(buffer + len, 0xFF, PLATFORM_FLASH_PAGE_SIZE - len);
+
+    if (!flash_page_if_changed(offset, buffer, state->stats))
+    {
+        logmsg("Flash programming failed at offset ", offset);
+        return false;
+    }
+
     return true;
 }
 
+// Flash the firmware straight from the zip package.
+// The entry is decompressed twice: first pass only checks the CRC32
+// so that a damaged package never gets partially programmed.
+bool program_firmware_zip(FsFile &file)
+{
+    static uint32_t work32[FWZIP_WORK_SIZE(PLATFORM_FLASH_PAGE_SIZE) / 4];
+    uint8_t *work = (uint8_t*)work32;
+
+    zipparser::Parser parser;
+    if (!fwzip_find_entry(file, parser))
+        return false;
+
+    uint32_t data_start = file.position();
+    if (parser.GetUncompressedSize() > PLATFORM_FLASH_TOTAL_SIZE ||
+        parser.GetUncompressedSize() <= PLATFORM_BOOTLOADER_SIZE)
+    {
+        logmsg("Firmware size invalid: ", (int)parser.GetUncompressedSize(), " flash size ", (int)PLATFORM_FLASH_TOTAL_SIZE);
+        return false;
+    }
+
+    if (!fwzip_extract(file, parser, work, sizeof(work32), PLATFORM_FLASH_PAGE_SIZE, NULL, NULL))
+    {
+        logmsg("Firmware package verification failed, not programming");
+        return false;
+    }
+
+    if (!file.seekSet(data_start))
+    {
+        logmsg("Seek failed");
+        return false;
+    }
+
+    zip_flash_state_t state = {};
+    state.stats.start_time = millis();
+    if (!fwzip_extract(file, parser, work, sizeof(work32), PLATFORM_FLASH_PAGE_SIZE, zip_flash_page_cb, &state))
+    {
+        platform_emergency_log_save();
+        return false;
+    }
+
+    log_flash_stats(state.stats);
+    return true;
+}
+
+#endif
+
 static bool mountSDCard()
 {
   // Check for the common case, FAT filesystem as first partition
@@ -157,6 +334,25 @@ int bootloader_main(void)
             }
             
         }
+#if FIRMWARE_ZIP_DIRECT_FLASH
+        else if (find_firmware_package(fwfile, name))
+        {
+            if (program_firmware_zip(fwfile))
+            {
+                fwfile.close();
+                if (!SD.remove(name))
+                {
+                    logmsg("Failed to remove firmware package");
+                }
+            }
+            else
+            {
+                // Main firmware will retry the package and report the problem
+                fwfile.close();
+                logmsg("Firmware update from package failed!");
+            }
+        }
+#endif
     }
 
     // logmsg("Bootloader continuing to main firmware");
@@ -46,6 +46,8 @@
 #define LOGFILEPREV   "zululog_prev.txt"
 #define LOGFILEDIR    "zuluide_log"
 #define LOGFILEROTATE "zululog_rotate"
+#define LOGFILEROTATESTATE "zululog_rotate_next.txt"
+#define LOG_ROTATE_MAX_FILES 1000
 #define CRASHFILE     "zuluerr.txt"
 #define LICENSEFILE   "zuluide.lic"
 #define LASTFILE      "zululast.txt"
@@ -58,6 +60,12 @@
 #define FIRMWARE_NAME_PREFIX DEF_STRINGFY(BUILD_ENV)
 #define FIRMWARE_PREFIX "ZuluIDE-FW"
 
+// Let the bootloader flash the matching firmware straight out of the
+// FIRMWARE_PREFIX*.zip package instead of extracting it to a .bin file first.
+#ifndef FIRMWARE_ZIP_DIRECT_FLASH
+#define FIRMWARE_ZIP_DIRECT_FLASH 1
+#endif
+
 // Filename prefix for image when in dual device mode
 // File extension can be anything
 #define DUALDRIVE_IMAGE_PRIMARY   "HD0"
@@ -71,12 +79,54 @@
 #define IDE_BUFFER_SIZE 65536
 #endif
 
+// RAM used for caching decompressed blocks of compressed images
+#ifndef IDE_COMPRESSED_CACHE_SIZE
+#define IDE_COMPRESSED_CACHE_SIZE 32768
+#endif
+
 // Log buffer size in bytes, must be a power of 2
 #ifndef LOGBUFSIZE
 #define LOGBUFSIZE 16384
 #endif
 #define LOG_SAVE_INTERVAL_MS 1000
 
+// Log is saved when the IDE bus has been idle for LOG_IDLE_SAVE_MS,
+// but data is never left unsaved for longer than LOG_MAX_DELAY_MS.
+#ifndef LOG_IDLE_SAVE_MS
+#define LOG_IDLE_SAVE_MS 50
+#endif
+#ifndef LOG_MAX_DELAY_MS
+#define LOG_MAX_DELAY_MS 5000
+#endif
+
+// Contiguous space reserved for the log file at boot, 0 to disable
+#ifndef LOG_PREALLOCATE_SIZE
+#define LOG_PREALLOCATE_SIZE (1024 * 1024)
+#endif
+
+// The preallocated log extent is erased this many sectors at a time as the log grows
+#ifndef LOG_ERASE_SECTORS
+#define LOG_ERASE_SECTORS 128
+#endif
+
+// Core utilization is logged at this interval when debug log is enabled.
+// Main loop iterations longer than CORE_UTILIZATION_IDLE_LOOP_US count as busy time.
+#define CORE_UTILIZATION_LOG_INTERVAL_MS 10000
+#define CORE_UTILIZATION_IDLE_LOOP_US 100
+
+// Maximum number of startup phases recorded in the boot timeline
+#define BOOT_TIMELINE_MAX_PHASES 16
+
+// Main loop sleeps up to MAIN_LOOP_IDLE_WAIT_US per iteration once the IDE bus
+// has been idle for MAIN_LOOP_IDLE_WAIT_AFTER_MS.
+#ifndef MAIN_LOOP_IDLE_WAIT_US
+#define MAIN_LOOP_IDLE_WAIT_US 200
+#endif
+#define MAIN_LOOP_IDLE_WAIT_AFTER_MS 20
+
+// Maximum runtime of each main loop task is logged at this interval when debug log is enabled.
+#define MAIN_LOOP_TASK_STATS_INTERVAL_MS 60000
+
 // Watchdog timeout
 // Watchdog will first issue a bus reset and if that does not help, crashdump.
 #define WATCHDOG_BUS_RESET_TIMEOUT 15000
@@ -95,5 +145,81 @@
 // Prefix for command file to create new image (case-insensitive)
 #define CREATEFILE "create"
 
+// Prefix for image file while it is being created, hides it from the image list
+#define CREATEFILE_TMP_PREFIX "_creating_"
+
+// Prefix added to a command file when the image could not be finished, so it is not run again
+#define CREATEFILE_FAILED_PREFIX "_failed_"
+
+// Image creation runs in the background, this long per main loop iteration
+#ifndef CREATEFILE_STEP_MS
+#define CREATEFILE_STEP_MS 20
+#endif
+
+// At boot, wait this long for image creation before continuing in background
+#ifndef CREATEFILE_BOOT_WAIT_MS
+#define CREATEFILE_BOOT_WAIT_MS 2000
+#endif
+
+// Number of sectors to erase at a time when the image is contiguous on the SD card.
+// The card is busy until the erase completes, so this bounds the time IDE commands wait.
+#ifndef CREATEFILE_ERASE_SECTORS
+#define CREATEFILE_ERASE_SECTORS 8192
+#endif
+
+// File size is synced this often during file writes, so interrupted creation can resume
+#ifndef CREATEFILE_SYNC_BYTES
+#define CREATEFILE_SYNC_BYTES (16 * 1024 * 1024)
+#endif
+
+// Keyword in the create command file name for a sparse image, e.g. "Create_32G_sparse_HD40.txt"
+#define CREATEFILE_SPARSE "sparse"
+
+// Allocation unit of sparse images
+#ifndef CREATEFILE_SPARSE_BLOCK_SIZE
+#define CREATEFILE_SPARSE_BLOCK_SIZE (128 * 1024)
+#endif
+
+// Command file to run the SD card benchmark at startup, removed when the benchmark starts
+#define BENCHMARKFILE "benchmark.txt"
+
+// Temporary file used by the benchmark, deleted afterwards
+#define BENCHMARK_TMP_FILE "zulubench.tmp"
+
+// Size of the benchmark test file, random accesses are spread over the whole file
+#ifndef BENCHMARK_FILE_SIZE
+#define BENCHMARK_FILE_SIZE (16 * 1024 * 1024)
+#endif
+
+// Duration of each benchmark test
+#ifndef BENCHMARK_TEST_MS
+#define BENCHMARK_TEST_MS 1000
+#endif
+
+// Copy-on-write overlay of a hard drive image is stored in the root folder
+// as e.g. "zuluovl_1a2b3c4d_HD00.img", where the hex number is a hash of the image
+// path. The "zulu" prefix hides it from the image list.
+#define OVERLAY_PREFIX "zuluovl_"
+
+// Allocation unit of overlays, partially written blocks are copied from the base image
+#ifndef OVERLAY_BLOCK_SIZE
+#define OVERLAY_BLOCK_SIZE (64 * 1024)
+#endif
+
+// Log overlay write statistics after this many blocks copied from the base image
+#ifndef OVERLAY_STATS_INTERVAL
+#define OVERLAY_STATS_INTERVAL 64
+#endif
+
+// Log image write throughput with debug log after this much data has been written
+#ifndef WRITE_STATS_INTERVAL_KB
+#define WRITE_STATS_INTERVAL_KB 4096
+#endif
+
+// Interval for logging statistics of ATAPI status polling commands in debug mode
+#ifndef ATAPI_POLL_STATS_INTERVAL_MS
+#define ATAPI_POLL_STATS_INTERVAL_MS 60000
+#endif
+
 // Name of startup sound file
 #define STARTUPSOUND "startup.wav"
@@ -29,11 +29,12 @@
 #include <ZuluIDE_platform.h>
 #include "ZuluIDE_config.h"
 #include "ZuluIDE_create_image.h"
+#include "ide_imagefile.h"
 
 
 extern SdFs SD;
 
-static bool parseCreateCommand(const char *cmd_filename, uint64_t &size, char imgname[MAX_FILE_PATH + 1])
+static bool parseCreateCommand(const char *cmd_filename, uint64_t &size, bool &sparse, char imgname[MAX_FILE_PATH + 1])
 {
   if (strncasecmp(cmd_filename, CREATEFILE, strlen(CREATEFILE)) != 0)
   {
@@ -90,6 +91,20 @@ static bool parseCreateCommand(const char *cmd_filename, uint64_t &size, char im
     p++;
   }
 
+  // Optional sparse keyword
+  sparse = false;
+  size_t sparse_len = strlen(CREATEFILE_SPARSE);
+  if (strncasecmp(p, CREATEFILE_SPARSE, sparse_len) == 0 &&
+      (isspace(p[sparse_len]) || p[sparse_len] == '-' || p[sparse_len] == '_'))
+  {
+    sparse = true;
+    p += sparse_len;
+    while (isspace(*p) || *p == '-' || *p == '_')
+    {
+      p++;
+    }
+  }
+
   // Copy target filename to new buffer
   strncpy(imgname, p, MAX_FILE_PATH);
   imgname[MAX_FILE_PATH] = '\0';
@@ -114,7 +129,77 @@ static bool parseCreateCommand(const char *cmd_filename, uint64_t &size, char im
 
 
 
-bool createImageFile(const char *imgname, uint64_t size, uint8_t *write_buf, size_t write_buf_len)
+typedef enum {
+  CREATE_IDLE,
+  CREATE_ERASE,       // Card-level erase of the contiguous sector range
+  CREATE_RAW_WRITE,   // Zeros written directly to the contiguous sector range
+  CREATE_FILE_WRITE   // Zeros written through the filesystem
+} create_method_t;
+
+// State of the image creation running in the background
+static struct {
+  create_method_t method;
+  FsFile file;
+  char cmd_filename[MAX_FILE_PATH + 1];
+  char imgname[MAX_FILE_PATH + 1];
+  char tmpname[MAX_FILE_PATH + 1];
+  uint64_t size;
+  uint64_t done;
+  uint64_t start_done;
+  uint32_t first_sector;
+  uint32_t start_time;
+  int progress_step;
+  bool completed;
+
+  bool writing_serial_out;
+  char serial_string[128];
+  char *string_marker;
+  uint32_t seconds;
+  uint32_t serial_time;
+} g_create;
+
+// Continue from a file left over by an interrupted creation.
+// File size is only updated on sync, so writes after the last sync are done again.
+static bool resumeCreateImage(uint64_t size)
+{
+  uint64_t existing = g_create.file.fileSize();
+  uint32_t begin, end;
+
+  if (existing < size)
+  {
+    // File writes were interrupted, on exFAT this is the valid length of the preallocated file
+    existing -= existing % 512;
+    if (!g_create.file.seekSet(existing))
+    {
+      return false;
+    }
+
+    g_create.method = CREATE_FILE_WRITE;
+    g_create.done = existing;
+  }
+  else if (existing == size && size % 512 == 0 && g_create.file.contiguousRange(&begin, &end))
+  {
+    // Erase progress is not recorded, but erasing again is fast
+    g_create.method = CREATE_ERASE;
+    g_create.first_sector = begin;
+    g_create.done = 0;
+  }
+  else if (existing == size)
+  {
+    // All file writes were done, only the rename is missing
+    g_create.method = CREATE_FILE_WRITE;
+    g_create.done = size;
+  }
+  else
+  {
+    return false;
+  }
+
+  g_create.size = size;
+  return true;
+}
+
+static bool startCreateImage(const char *cmd_filename, const char *imgname, uint64_t size, bool sparse)
 {
   int namelen = strlen(imgname);
 
@@ -125,142 +210,393 @@ bool createImageFile(const char *imgname, uint64_t size, uint8_t *write_buf, siz
     return false;
   }
 
-  // Create file, try to preallocate contiguous sectors
+  // Image is created under a temporary name so that it is not loaded before it is complete.
+  // Leftover file from an interrupted creation is continued, sparse images are started over.
+  strncpy(g_create.cmd_filename, cmd_filename ? cmd_filename : "", MAX_FILE_PATH);
+  g_create.cmd_filename[MAX_FILE_PATH] = '\0';
+  strncpy(g_create.imgname, imgname, MAX_FILE_PATH);
+  g_create.imgname[MAX_FILE_PATH] = '\0';
+  snprintf(g_create.tmpname, sizeof(g_create.tmpname), "%s%s", CREATEFILE_TMP_PREFIX, imgname);
+
+  g_create.start_time = millis();
+  g_create.progress_step = 0;
+  g_create.writing_serial_out = false;
+  g_create.string_marker = g_create.serial_string;
+  g_create.seconds = 0;
+  g_create.serial_time = 0;
+
   LED_ON();
-  FsFile file = SD.open(imgname, O_WRONLY | O_CREAT);
+  if (SD.exists(g_create.tmpname))
+  {
+    g_create.file = SD.open(g_create.tmpname, O_WRONLY);
+    if (!sparse && g_create.file.isOpen() && resumeCreateImage(size))
+    {
+      g_create.start_done = g_create.done;
+      g_create.progress_step = (int)(g_create.done * 10 / size);
+      logmsg("-- Resuming creation of ", (int)(size / 1048576), " MB image '", imgname, "' at ",
+          (int)(g_create.done / 1048576), " MB using ",
+          (g_create.method == CREATE_ERASE) ? "SD card erase" : "file writes");
+      return true;
+    }
+
+    logmsg("-- Removing incomplete image '", g_create.tmpname, "'");
+    g_create.file.close();
+    SD.remove(g_create.tmpname);
+  }
+
+  // Create file, try to preallocate contiguous sectors
+  g_create.file = SD.open(g_create.tmpname, O_WRONLY | O_CREAT);
+  if (!g_create.file.isOpen())
+  {
+    logmsg("-- Could not create file '", g_create.tmpname, "'");
+    LED_OFF();
+    return false;
+  }
+
+  g_create.method = CREATE_FILE_WRITE;
+  g_create.size = size;
+  g_create.done = 0;
+
+  uint32_t begin, end;
+  if (sparse)
+  {
+    // Only the header and an empty block table are written,
+    // data blocks are added when the host writes to them.
+    ide_sparse_header_t header;
+    IDESparseImage::init_header(&header, size, CREATEFILE_SPARSE_BLOCK_SIZE);
+    uint8_t sector[512] = {};
+    memcpy(sector, &header, sizeof(header));
+    if (g_create.file.write(sector, sizeof(sector)) != sizeof(sector))
+    {
+      logmsg("-- Could not write sparse image header to '", g_create.tmpname, "'");
+      g_create.file.close();
+      SD.remove(g_create.tmpname);
+      LED_OFF();
+      return false;
+    }
 
-  if (!file.preAllocate(size))
+    g_create.size = header.data_offset;
+    g_create.done = sizeof(sector);
+  }
+  else if (!g_create.file.preAllocate(size))
   {
     logmsg("-- Preallocation didn't find contiguous set of clusters, continuing anyway");
   }
+  else if (size % 512 == 0 && g_create.file.fileSize() == size &&
+           g_create.file.contiguousRange(&begin, &end) && g_create.file.sync())
+  {
+    // File size is already set, contents can be cleared without going through the filesystem.
+    // exFAT only extends the valid length on writes, so it uses the file path instead.
+    g_create.method = CREATE_ERASE;
+    g_create.first_sector = begin;
+  }
 
-  int blocks = size/write_buf_len;
+  g_create.start_done = g_create.done;
 
-  // Write zeros to fill the file
-  uint32_t start = millis();
-  memset(write_buf, 0, write_buf_len);
-  uint64_t remain = size;
+  logmsg("-- Creating ", (int)(size / 1048576), " MB ", sparse ? "sparse " : "", "image '", imgname, "' using ",
+      (g_create.method == CREATE_ERASE) ? "SD card erase" : "file writes");
+  return true;
+}
 
-  int block = 0;
-  bool writing_serial_out = false;
-  char serial_string[128];
-  char *string_marker = serial_string;
-  uint32_t seconds = 0;
-  uint32_t serial_time = 0;
+// Rename the command file so that a creation that cannot finish is not retried forever
+static void markCreateCommandFailed()
+{
+  if (!g_create.cmd_filename[0])
+  {
+    return;
+  }
 
-  while (remain > 0)
+  char failed_name[MAX_FILE_PATH + 1];
+  snprintf(failed_name, sizeof(failed_name), "%s%s", CREATEFILE_FAILED_PREFIX, g_create.cmd_filename);
+  if (SD.exists(failed_name) || !SD.rename(g_create.cmd_filename, failed_name))
   {
-    uint32_t time_start = millis();
+    logmsg("-- Removing command file '", g_create.cmd_filename, "'");
+    SD.remove(g_create.cmd_filename);
+  }
+  else
+  {
+    logmsg("-- Renamed command file to '", failed_name, "'");
+  }
+}
 
-    if (millis() & 128) { LED_ON(); } else { LED_OFF(); }
-    platform_reset_watchdog();
+// Returns true if the image was created and the command file removed
+static bool finishCreateImage(bool success)
+{
+  g_create.file.close();
+  g_create.method = CREATE_IDLE;
+  LED_OFF();
+
+  if (!success)
+  {
+    SD.remove(g_create.tmpname);
+    return false;
+  }
+
+  if (!SD.rename(g_create.tmpname, g_create.imgname))
+  {
+    logmsg("-- Renaming '", g_create.tmpname, "' to '", g_create.imgname, "' failed");
+    SD.remove(g_create.tmpname);
+    markCreateCommandFailed();
+    return false;
+  }
+
+  uint32_t time = millis() - g_create.start_time;
+  if (time == 0) time = 1;
+  int kb_per_s = (g_create.size - g_create.start_done) / time;
+  logmsg("-- Image creation successful, ", (int)time, " ms, write speed ", kb_per_s, " kB/s");
+  g_create.completed = true;
+
+  if (g_create.cmd_filename[0])
+  {
+    // Remove the command file after successful creation
+    logmsg("-- Image creation successful, removing '", g_create.cmd_filename, "'");
+    SD.remove(g_create.cmd_filename);
+  }
+  return true;
+}
+
+// Check that erased sectors read back as zeros, the card may also use 0xFF
+static bool eraseReadsZero(uint32_t sector, uint8_t *buf)
+{
+  if (!SD.card()->readSectors(sector, buf, 1))
+  {
+    return false;
+  }
 
-    size_t to_write = write_buf_len;
-    if (to_write > remain) to_write = remain;
-    if (file.write(write_buf, to_write) != to_write)
+  for (int i = 0; i < 512; i++)
+  {
+    if (buf[i] != 0) return false;
+  }
+  return true;
+}
+
+static bool createImageStep(uint8_t *write_buf, size_t write_buf_len)
+{
+  uint32_t sector = g_create.first_sector + (uint32_t)(g_create.done / 512);
+  uint64_t remain = g_create.size - g_create.done;
+
+  if (g_create.method == CREATE_ERASE)
+  {
+    uint32_t count = CREATEFILE_ERASE_SECTORS;
+    if (count > remain / 512) count = remain / 512;
+
+    if (SD.card()->erase(sector, sector + count - 1) &&
+        (g_create.done != 0 || eraseReadsZero(sector, write_buf)))
     {
-      logmsg("-- File writing to '", imgname, "' failed with ", (int)remain, " bytes remaining");
-      file.close();
-      LED_OFF();
+      g_create.done += (uint64_t)count * 512;
+      return true;
+    }
+
+    logmsg("-- SD card erase not usable, writing zeros to sectors instead");
+    g_create.method = CREATE_RAW_WRITE;
+    g_create.done = 0;
+    return true;
+  }
+
+  // Buffer is shared with IDE transfers, so clear it on every step
+  size_t to_write = write_buf_len;
+  if (to_write > remain) to_write = remain;
+  memset(write_buf, 0, to_write);
+
+  if (g_create.method == CREATE_RAW_WRITE)
+  {
+    if (!SD.card()->writeSectors(sector, write_buf, to_write / 512))
+    {
+      logmsg("-- Writing sectors to '", g_create.tmpname, "' failed with ", (int)(remain / 1048576), " MB remaining");
       return false;
     }
+  }
+  else if (g_create.file.write(write_buf, to_write) != to_write)
+  {
+    logmsg("-- File writing to '", g_create.tmpname, "' failed with ", (int)(remain / 1048576), " MB remaining");
+    return false;
+  }
+
+  uint64_t prev_done = g_create.done;
+  g_create.done += to_write;
 
-    remain -= to_write;
-    uint32_t time = (uint32_t)(millis() - start);
-    // Create a new string to overwrite the previous line every second
-    if(platform_serial_ready() && (time / 1000) > seconds)
+  // Record progress in the directory entry, lets creation resume after power loss
+  if (g_create.method == CREATE_FILE_WRITE &&
+      prev_done / CREATEFILE_SYNC_BYTES != g_create.done / CREATEFILE_SYNC_BYTES &&
+      !g_create.file.sync())
+  {
+    logmsg("-- Syncing '", g_create.tmpname, "' failed");
+    return false;
+  }
+
+  return true;
+}
+
+static void reportCreateProgress()
+{
+  uint64_t remain = g_create.size - g_create.done;
+  uint32_t time = (uint32_t)(millis() - g_create.start_time);
+
+  int step = (int)(g_create.done * 10 / g_create.size);
+  if (step > g_create.progress_step && step < 10)
+  {
+    g_create.progress_step = step;
+    logmsg("-- Creating image '", g_create.imgname, "': ", step * 10, "% done");
+  }
+
+  // Create a new string to overwrite the previous line every second
+  if (platform_serial_ready() && (time / 1000) > g_create.seconds)
+  {
+    int kb_per_s = (g_create.done - g_create.start_done) / time;
+    // "\x1b[2K" is a control charater to clear the current line
+    snprintf(g_create.serial_string, sizeof(g_create.serial_string),"\r\x1b[2KWrote %lu MB with %lu MB remaining at %d kB/s\r", (uint32_t)(g_create.done / 1048576), (uint32_t)(remain / 1048576), kb_per_s);
+    g_create.string_marker = g_create.serial_string;
+    g_create.writing_serial_out = true;
+    g_create.seconds = time / 1000;
+  }
+
+  // Attempt write to the serial port every 1/4 second
+  if (g_create.writing_serial_out && (time / 250) > g_create.serial_time)
+  {
+    uint32_t len = strlen(g_create.string_marker);
+    if (len > 0)
     {
-      int kb_per_s = (size - remain) / time;
-      // "\x1b[2K" is a control charater to clear the current line
-      snprintf(serial_string, sizeof(serial_string),"\r\x1b[2KWrote %lu MB with %lu MB remaining at %d kB/s\r", (uint32_t)((size - remain) / 1048576), (uint32_t)(remain / 1048576), kb_per_s);
-      string_marker = serial_string;
-      writing_serial_out = true;
-      seconds++;
+      g_create.string_marker += platform_serial_write((uint8_t*)g_create.string_marker, len);
     }
+    if (strlen(g_create.string_marker) == 0)
+    {
+      g_create.writing_serial_out = false;
+    }
+    g_create.serial_time = time / 250;
+  }
+}
 
-    // Attempt write to the serial port every 1/4 second
-    if(writing_serial_out && (time / 250) > serial_time)
+bool createImageInProgress()
+{
+  return g_create.method != CREATE_IDLE;
+}
+
+bool createImageCompleted()
+{
+  bool completed = g_create.completed;
+  g_create.completed = false;
+  return completed;
+}
+
+void createImageAbort()
+{
+  if (g_create.method != CREATE_IDLE)
+  {
+    logmsg("-- Image creation of '", g_create.imgname, "' aborted");
+    g_create.file.close();
+    g_create.method = CREATE_IDLE;
+  }
+}
+
+bool createImagePoll(uint8_t *write_buf, size_t write_buf_len, uint32_t max_time_ms)
+{
+  if (g_create.method == CREATE_IDLE)
+  {
+    return false;
+  }
+
+  uint32_t start = millis();
+  do
+  {
+    if (millis() & 128) { LED_ON(); } else { LED_OFF(); }
+    platform_reset_watchdog();
+
+    if (g_create.done < g_create.size && !createImageStep(write_buf, write_buf_len))
     {
-      uint32_t len = strlen(string_marker);
-      uint32_t wrote = 0;
-      if (len > 0)
-      {
-        wrote = platform_serial_write((uint8_t*)string_marker, len);
-        string_marker += wrote;
-      }
-      if (strlen(string_marker) == 0)
+      finishCreateImage(false);
+      break;
+    }
+
+    reportCreateProgress();
+
+    if (g_create.done >= g_create.size)
+    {
+      // Continue with the next command file, if any.
+      // Not done after a failure, the same command file would be found again.
+      if (finishCreateImage(true))
       {
-        writing_serial_out = false;
+        searchAndCreateImage(write_buf, write_buf_len);
       }
-      serial_time++;
+      break;
     }
+  } while ((uint32_t)(millis() - start) < max_time_ms);
 
-    block++;
+  return g_create.method != CREATE_IDLE;
+}
+
+bool createImageFile(const char *imgname, uint64_t size, uint8_t *write_buf, size_t write_buf_len)
+{
+  if (g_create.method != CREATE_IDLE || !startCreateImage(nullptr, imgname, size, false))
+  {
+    return false;
   }
 
-  file.close();
-  uint32_t time = millis() - start;
-  int kb_per_s = size / time;
-  logmsg("-- Image creation successful, write speed ", kb_per_s, " kB/s");
+  while (createImagePoll(write_buf, write_buf_len, CREATEFILE_STEP_MS));
 
-  LED_OFF();
-  return true;
+  return SD.exists(imgname);
 }
 
 
 // When a file is called e.g. "Create_1024M_HD40.txt",
 // create image file with specified size.
-// Returns true if image file creation succeeded.
+// Returns true if image file creation was started, the work is done
+// by createImagePoll().
 //
 // Parsing rules:
 // - Filename must start with "Create", case-insensitive
 // - Separator can be either underscore, dash or space
 // - Size must start with a number. Unit of k, kb, m, mb, g, gb is supported,
 //   case-insensitive, with 1024 as the base. If no unit, assume MB.
+// - Size can be followed by "sparse" to create a thin provisioned image that
+//   only takes as much space as the host has written, e.g. "Create_32G_sparse_HD40.txt"
 // - If target filename does not have extension (just .txt), use ".bin"
-bool createImage(const char *cmd_filename, char imgname[MAX_FILE_PATH + 1], uint8_t *write_buf, size_t write_buf_len)
+static bool startCreateImageFromCommand(const char *cmd_filename, char imgname[MAX_FILE_PATH + 1])
 {
   uint64_t size;
+  bool sparse;
 
   // Parse the command filename
-  if (!parseCreateCommand(cmd_filename, size, imgname))
+  if (!parseCreateCommand(cmd_filename, size, sparse, imgname))
   {
     return false;
   }
 
   logmsg("Create image using special file: \"", cmd_filename, "\"");
+  return startCreateImage(cmd_filename, imgname, size, sparse);
+}
 
-  // Create the actual image file
-  if (!createImageFile(imgname, size, write_buf, write_buf_len))
+// Blocking version of the above, returns true if image file creation succeeded.
+bool createImage(const char *cmd_filename, char imgname[MAX_FILE_PATH + 1], uint8_t *write_buf, size_t write_buf_len)
+{
+  if (!startCreateImageFromCommand(cmd_filename, imgname))
   {
     return false;
   }
 
-  // Remove the command file after successful creation
-  logmsg("-- Image creation successful, removing '", cmd_filename, "'");
-  SD.remove(cmd_filename);
-  return true;
+  while (createImagePoll(write_buf, write_buf_len, CREATEFILE_STEP_MS));
+
+  return SD.exists(imgname);
 }
 
 bool searchAndCreateImage(uint8_t *write_buf, size_t write_buf_len)
 {
+    if (g_create.method != CREATE_IDLE)
+        return true;
+
     FsFile root = SD.open("/");
     if (!root.isOpen())
         return false;
 
     FsFile file;
-    bool created = false;
-    while(file.openNext(&root))
+    bool started = false;
+    while(!started && file.openNext(&root))
     {
         char filename[MAX_FILE_PATH + 1] = {};
         char image_name[MAX_FILE_PATH + 1] = {};
         file.getName(filename, sizeof(filename));
-        if(createImage(filename, image_name, write_buf, write_buf_len))
-        {
-            created = true;
-        }
+        file.close();
+        started = startCreateImageFromCommand(filename, image_name);
     }
-    file.close();
     root.close();
-    return created;
-}
\ No newline at end of file
+    return started;
+}
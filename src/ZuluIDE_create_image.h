@@ -23,6 +23,22 @@
  * along with this program.  If not, see <https://www.gnu.org/licenses/>.
 **/
 
+// Start creating an image for the first "create" command file found on the SD card.
+// Returns true if image creation is in progress.
 bool searchAndCreateImage(uint8_t *write_buf, size_t write_buf_len);
+
+// Continue image creation for up to max_time_ms, returns true while still in progress.
+// write_buf is only used during the call.
+bool createImagePoll(uint8_t *write_buf, size_t write_buf_len, uint32_t max_time_ms);
+
+bool createImageInProgress();
+
+// Returns true once after an image has been created, so that the caller can
+// select the device again when the new image was not there at boot.
+bool createImageCompleted();
+
+// Stop image creation without touching the SD card, used when the card is removed.
+void createImageAbort();
+
 bool createImageFile(const char *imgname, uint64_t size, uint8_t *write_buf, size_t write_buf_len);
 bool createImage(const char *cmd_filename, char imgname[MAX_FILE_PATH + 1], uint8_t *write_buf, size_t write_buf_len);
\ No newline at end of file
@@ -0,0 +1,217 @@
+/** 
+ * ZuluIDE™ - Copyright (c) 2026 Rabbit Hole Computing™
+ * 
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version. 
+ * 
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version. 
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. 
+ *
+ * Under Section 7 of GPL version 3, you are granted additional
+ * permissions described in the ZuluIDE Hardware Support Library Exception
+ * (GPL-3.0_HSL_Exception.md), as published by Rabbit Hole Computing™.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "ZuluIDE_firmware_zip.h"
+#include "ZuluIDE_config.h"
+#include "ZuluIDE_log.h"
+#include <string.h>
+
+#include "ZuluIDE_inflate.h"
+
+// Length of the firmware file name inside the package,
+// e.g. ZuluIDE_RP2040_2025-02-21_e4be9ed.bin
+static const uint32_t g_fwzip_target_filename_length = sizeof(FIRMWARE_NAME_PREFIX "_2025-02-21_e4be9ed.bin") - 1;
+
+bool fwzip_find_entry(FsFile &file, zipparser::Parser &parser)
+{
+    parser.SetMatchingFilename(FIRMWARE_NAME_PREFIX, sizeof(FIRMWARE_NAME_PREFIX) - 1, g_fwzip_target_filename_length);
+    parser.Reset();
+
+    uint8_t buf[512];
+    int32_t parsed_length;
+    int bytes_read = 0;
+    while ((bytes_read = file.read(buf, sizeof(buf))) > 0)
+    {
+        parsed_length = parser.Parse(buf, bytes_read);
+        if (parsed_length == bytes_read)
+            continue;
+        if (parsed_length >= 0)
+        {
+            if (!parser.FoundMatch())
+            {
+                uint32_t skip = parser.GetCompressedSize();
+                parser.Reset();
+                file.seekSet(file.position() - (bytes_read - parsed_length) + skip);
+            }
+            else
+            {
+                // seek to start of compressed data in matching file
+                file.seekSet(file.position() - (bytes_read - parsed_length));
+                break;
+            }
+        }
+        if (parsed_length == zipparser::Parser::PARSE_UNSUPPORTED_COMPRESSION)
+        {
+            logmsg("Firmware package uses an unsupported compression method");
+            return false;
+        }
+        if (parsed_length < 0)
+        {
+            logmsg("Filename character length of ", (int)g_fwzip_target_filename_length, " with a prefix of ", FIRMWARE_NAME_PREFIX, " not found in package");
+            return false;
+        }
+    }
+
+    if (!parser.FoundMatch())
+    {
+        logmsg("Error reading firmware package file");
+        return false;
+    }
+
+    if (parser.HasDataDescriptor() && parser.GetCompressedSize() == 0)
+    {
+        logmsg("Firmware package entry has no size in its local header, repack it without data descriptors");
+        return false;
+    }
+
+    return true;
+}
+
+// Input state for the decompressor, which must be the first member
+// so that the read callback can get back to the file.
+struct fwzip_inflate_t
+{
+    inflate_state_t d;
+    FsFile *file;
+    uint32_t remaining;
+    uint8_t *inbuf;
+};
+
+static int fwzip_read_cb(inflate_state_t *d)
+{
+    fwzip_inflate_t *s = (fwzip_inflate_t*)d;
+    if (s->remaining == 0)
+        return -1;
+
+    uint32_t len = s->remaining;
+    if (len > FWZIP_INBUF_SIZE)
+        len = FWZIP_INBUF_SIZE;
+
+    int bytes_read = s->file->read(s->inbuf, len);
+    if (bytes_read <= 0)
+    {
+        s->remaining = 0;
+        return -1;
+    }
+
+    s->remaining -= bytes_read;
+    d->source = s->inbuf + 1;
+    d->source_limit = s->inbuf + bytes_read;
+    return s->inbuf[0];
+}
+
+bool fwzip_extract(FsFile &file, zipparser::Parser &parser,
+                   uint8_t *work, size_t work_size, size_t chunk_size,
+                   fwzip_write_cb_t write_cb, void *param)
+{
+    bool deflate = (parser.GetMethod() == zipparser::Parser::METHOD_DEFLATE);
+    size_t needed = deflate ? FWZIP_WORK_SIZE(chunk_size) : chunk_size;
+    if (work_size < needed)
+    {
+        logmsg("Firmware extraction buffer too small: ", (int)work_size, " need ", (int)needed);
+        return false;
+    }
+
+    uint32_t expected_size = parser.GetUncompressedSize();
+    uint32_t total = 0;
+    uint32_t crc = 0xFFFFFFFF;
+    uint8_t *out = work;
+
+    if (!deflate)
+    {
+        uint32_t remaining = parser.GetCompressedSize();
+        while (remaining > 0)
+        {
+            uint32_t len = remaining < chunk_size ? remaining : chunk_size;
+            int bytes_read = file.read(out, len);
+            if (bytes_read != (int)len)
+            {
+                logmsg("Error reading firmware package file at offset ", (int)total);
+                return false;
+            }
+
+            crc = inflate_crc32(out, len, crc);
+            if (write_cb && !write_cb(param, out, len))
+                return false;
+            remaining -= len;
+            total += len;
+        }
+    }
+    else
+    {
+        static fwzip_inflate_t s;
+        uint8_t *dict = work + chunk_size;
+        s.file = &file;
+        s.remaining = parser.GetCompressedSize();
+        s.inbuf = dict + FWZIP_DICT_SIZE;
+
+        inflate_init(&s.d, dict, FWZIP_DICT_SIZE);
+        s.d.source = NULL;
+        s.d.source_limit = NULL;
+        s.d.source_read_cb = fwzip_read_cb;
+
+        int res;
+        do
+        {
+            s.d.dest_start = s.d.dest = out;
+            s.d.dest_limit = out + chunk_size;
+            res = inflate_run(&s.d);
+
+            if (res != INFLATE_OK && res != INFLATE_DONE)
+            {
+                logmsg("Firmware decompression failed with error ", res, " at offset ", (int)total);
+                return false;
+            }
+
+            size_t len = s.d.dest - out;
+            if (len > 0)
+            {
+                crc = inflate_crc32(out, len, crc);
+                if (write_cb && !write_cb(param, out, len))
+                    return false;
+                total += len;
+            }
+
+            if (total > expected_size)
+                break;
+        } while (res != INFLATE_DONE);
+    }
+
+    crc = ~crc;
+    if (total != expected_size)
+    {
+        logmsg("Firmware size mismatch: extracted ", (int)total, " bytes, expected ", (int)expected_size);
+        return false;
+    }
+
+    if (crc != parser.GetCrc())
+    {
+        logmsg("Firmware CRC32 mismatch: computed ", crc, " expected ", parser.GetCrc());
+        return false;
+    }
+
+    dbgmsg("Firmware extracted and verified: ", (int)total, " bytes, CRC32 ", crc);
+    return true;
+}
@@ -0,0 +1,54 @@
+/** 
+ * ZuluIDE™ - Copyright (c) 2026 Rabbit Hole Computing™
+ * 
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version. 
+ * 
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version. 
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details. 
+ *
+ * Under Section 7 of GPL version 3, you are granted additional
+ * permissions described in the ZuluIDE Hardware Support Library Exception
+ * (GPL-3.0_HSL_Exception.md), as published by Rabbit Hole Computing™.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+// Extraction of the platform specific firmware from the FIRMWARE_PREFIX*.zip
+// package. Shared by the main firmware and the bootloader.
+
+#pragma once
+
+#include <SdFat.h>
+#include <zip_parser.h>
+
+// Deflate needs the full 32 kB history window
+#define FWZIP_DICT_SIZE 32768
+#define FWZIP_INBUF_SIZE 512
+
+// Minimum work buffer size for fwzip_extract() with the given output chunk size
+#define FWZIP_WORK_SIZE(chunk_size) (FWZIP_DICT_SIZE + FWZIP_INBUF_SIZE + (chunk_size))
+
+// Receives the extracted data in chunk_size pieces, the last one may be shorter.
+// Return false to stop the extraction.
+typedef bool (*fwzip_write_cb_t)(void *param, const uint8_t *data, size_t len);
+
+// Find the firmware entry for this platform in the zip package.
+// On success the file is positioned at the start of the entry data and
+// parser holds the entry header.
+bool fwzip_find_entry(FsFile &file, zipparser::Parser &parser);
+
+// Decompress the entry found by fwzip_find_entry() and check it against the
+// CRC32 and size from the local header. write_cb may be NULL to only verify.
+bool fwzip_extract(FsFile &file, zipparser::Parser &parser,
+                   uint8_t *work, size_t work_size, size_t chunk_size,
+                   fwzip_write_cb_t write_cb, void *param);
@@ -0,0 +1,414 @@
+/**
+ * ZuluIDE™ - Copyright (c) 2026 Rabbit Hole Computing™
+ *
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version.
+ *
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional
+ * permissions described in the ZuluIDE Hardware Support Library Exception
+ * (GPL-3.0_HSL_Exception.md), as published by Rabbit Hole Computing™.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "ZuluIDE_inflate.h"
+#include <string.h>
+
+enum inflate_mode_t { MODE_HEADER, MODE_STORED, MODE_CODES, MODE_COPY, MODE_DONE, MODE_ERROR };
+
+// Base values and extra bits of length symbols 257 to 285 and distance symbols 0 to 29
+static const uint16_t g_length_base[29] = {
+    3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+    35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const uint8_t g_length_extra[29] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+    3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+static const uint16_t g_dist_base[30] = {
+    1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+    257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const uint8_t g_dist_extra[30] = {
+    0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+    7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+// Order in which code length code lengths are stored in a dynamic block header
+static const uint8_t g_clen_order[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+// CRC-32 with polynomial 0xEDB88320, 4 bits at a time to keep the table small
+static const uint32_t g_crc32_table[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C};
+
+static int read_byte(inflate_state_t *s)
+{
+    if (s->source < s->source_limit)
+        return *s->source++;
+    if (s->source_read_cb)
+        return s->source_read_cb(s);
+    return -1;
+}
+
+// Get up to 16 bits from the stream, LSB first. Returns -1 at end of input.
+static int32_t get_bits(inflate_state_t *s, uint32_t num)
+{
+    while (s->bit_count < num)
+    {
+        int c = read_byte(s);
+        if (c < 0)
+            return -1;
+        s->bit_buf |= (uint32_t)c << s->bit_count;
+        s->bit_count += 8;
+    }
+
+    uint32_t value = s->bit_buf & ((1u << num) - 1);
+    s->bit_buf >>= num;
+    s->bit_count -= num;
+    return value;
+}
+
+// Build canonical Huffman decoding tables from code lengths.
+// Over-subscribed sets of lengths are rejected, incomplete ones are allowed
+// because a block may use a single distance code.
+static bool build_tree(inflate_huff_t *t, const uint8_t *lengths, uint32_t num)
+{
+    memset(t->counts, 0, sizeof(t->counts));
+    for (uint32_t i = 0; i < num; i++)
+    {
+        t->counts[lengths[i]]++;
+    }
+    t->counts[0] = 0;
+
+    int32_t left = 1;
+    for (int len = 1; len < 16; len++)
+    {
+        left = (left << 1) - t->counts[len];
+        if (left < 0)
+            return false;
+    }
+
+    uint16_t offsets[16];
+    offsets[1] = 0;
+    for (int len = 1; len < 15; len++)
+    {
+        offsets[len + 1] = offsets[len] + t->counts[len];
+    }
+
+    for (uint32_t i = 0; i < num; i++)
+    {
+        if (lengths[i])
+            t->symbols[offsets[lengths[i]]++] = i;
+    }
+
+    return true;
+}
+
+// Decode one symbol a bit at a time. Returns -1 at end of input or for an unused code.
+static int32_t decode_symbol(inflate_state_t *s, const inflate_huff_t *t)
+{
+    int32_t code = 0;
+    int32_t first = 0;
+    int32_t index = 0;
+    for (int len = 1; len < 16; len++)
+    {
+        if (s->bit_count == 0)
+        {
+            int c = read_byte(s);
+            if (c < 0)
+                return -1;
+            s->bit_buf = c;
+            s->bit_count = 8;
+        }
+
+        code |= s->bit_buf & 1;
+        s->bit_buf >>= 1;
+        s->bit_count--;
+
+        int32_t count = t->counts[len];
+        if (code - first < count)
+            return t->symbols[index + code - first];
+
+        index += count;
+        first = (first + count) << 1;
+        code <<= 1;
+    }
+
+    return -1;
+}
+
+static void build_fixed_trees(inflate_state_t *s)
+{
+    uint8_t lengths[288];
+    memset(lengths, 8, 144);
+    memset(lengths + 144, 9, 112);
+    memset(lengths + 256, 7, 24);
+    memset(lengths + 280, 8, 8);
+    build_tree(&s->lit_tree, lengths, 288);
+
+    // Distance codes 30 and 31 never occur, leave them undecodable
+    memset(lengths, 5, 30);
+    build_tree(&s->dist_tree, lengths, 30);
+}
+
+static bool read_dynamic_trees(inflate_state_t *s)
+{
+    int32_t hlit = get_bits(s, 5);
+    int32_t hdist = get_bits(s, 5);
+    int32_t hclen = get_bits(s, 4);
+    if (hlit < 0 || hdist < 0 || hclen < 0)
+        return false;
+
+    hlit += 257;
+    hdist += 1;
+    hclen += 4;
+    if (hlit > 286 || hdist > 30)
+        return false;
+
+    // The code length code is built in the distance tree, which is not in use yet
+    uint8_t lengths[286 + 30];
+    memset(lengths, 0, 19);
+    for (int i = 0; i < hclen; i++)
+    {
+        int32_t len = get_bits(s, 3);
+        if (len < 0)
+            return false;
+        lengths[g_clen_order[i]] = len;
+    }
+
+    if (!build_tree(&s->dist_tree, lengths, 19))
+        return false;
+
+    int32_t num = hlit + hdist;
+    int32_t i = 0;
+    while (i < num)
+    {
+        int32_t sym = decode_symbol(s, &s->dist_tree);
+        if (sym < 0)
+            return false;
+
+        if (sym < 16)
+        {
+            lengths[i++] = sym;
+            continue;
+        }
+
+        // 16 repeats the previous length 3 to 6 times,
+        // 17 and 18 repeat zero 3 to 10 and 11 to 138 times
+        static const uint8_t repeat_bits[3] = {2, 3, 7};
+        static const uint8_t repeat_base[3] = {3, 3, 11};
+        uint8_t value = 0;
+        if (sym == 16)
+        {
+            if (i == 0)
+                return false;
+            value = lengths[i - 1];
+        }
+
+        int32_t repeat = get_bits(s, repeat_bits[sym - 16]);
+        if (repeat < 0)
+            return false;
+        repeat += repeat_base[sym - 16];
+        if (i + repeat > num)
+            return false;
+
+        memset(lengths + i, value, repeat);
+        i += repeat;
+    }
+
+    // Every block needs the end of block code
+    if (lengths[256] == 0)
+        return false;
+
+    return build_tree(&s->lit_tree, lengths, hlit) &&
+           build_tree(&s->dist_tree, lengths + hlit, hdist);
+}
+
+static inline void put_byte(inflate_state_t *s, uint8_t c)
+{
+    *s->dest++ = c;
+    if (s->dict)
+    {
+        s->dict[s->dict_pos++] = c;
+        if (s->dict_pos == s->dict_size)
+            s->dict_pos = 0;
+        if (s->dict_fill < s->dict_size)
+            s->dict_fill++;
+    }
+}
+
+void inflate_init(inflate_state_t *s, uint8_t *dict, uint32_t dict_size)
+{
+    memset(s, 0, sizeof(*s));
+    s->dict = dict;
+    s->dict_size = dict_size;
+    s->mode = MODE_HEADER;
+}
+
+int inflate_run(inflate_state_t *s)
+{
+    while (true)
+    {
+        switch (s->mode)
+        {
+        case MODE_HEADER:
+        {
+            if (s->final_block)
+            {
+                s->mode = MODE_DONE;
+                break;
+            }
+
+            int32_t header = get_bits(s, 3);
+            if (header < 0)
+                goto error;
+
+            s->final_block = header & 1;
+            uint32_t type = header >> 1;
+            if (type == 0)
+            {
+                // Stored block starts at the next byte boundary
+                get_bits(s, s->bit_count & 7);
+                int32_t len = get_bits(s, 16);
+                int32_t nlen = get_bits(s, 16);
+                if (len < 0 || nlen < 0 || len != (~nlen & 0xFFFF))
+                    goto error;
+
+                s->copy_length = len;
+                s->mode = MODE_STORED;
+            }
+            else if (type == 1)
+            {
+                build_fixed_trees(s);
+                s->mode = MODE_CODES;
+            }
+            else if (type == 2)
+            {
+                if (!read_dynamic_trees(s))
+                    goto error;
+                s->mode = MODE_CODES;
+            }
+            else
+            {
+                goto error;
+            }
+            break;
+        }
+
+        case MODE_STORED:
+            while (s->copy_length > 0)
+            {
+                if (s->dest >= s->dest_limit)
+                    return INFLATE_OK;
+
+                int32_t c = get_bits(s, 8);
+                if (c < 0)
+                    goto error;
+                put_byte(s, c);
+                s->copy_length--;
+            }
+            s->mode = MODE_HEADER;
+            break;
+
+        case MODE_CODES:
+        {
+            if (s->dest >= s->dest_limit)
+                return INFLATE_OK;
+
+            int32_t sym = decode_symbol(s, &s->lit_tree);
+            if (sym < 0)
+                goto error;
+
+            if (sym < 256)
+            {
+                put_byte(s, sym);
+                break;
+            }
+
+            if (sym == 256)
+            {
+                s->mode = MODE_HEADER;
+                break;
+            }
+
+            sym -= 257;
+            if (sym >= 29)
+                goto error;
+
+            int32_t extra = get_bits(s, g_length_extra[sym]);
+            int32_t dsym = decode_symbol(s, &s->dist_tree);
+            if (extra < 0 || dsym < 0 || dsym >= 30)
+                goto error;
+            s->copy_length = g_length_base[sym] + extra;
+
+            extra = get_bits(s, g_dist_extra[dsym]);
+            if (extra < 0)
+                goto error;
+            s->copy_distance = g_dist_base[dsym] + extra;
+
+            // Distance must stay within the data produced so far
+            if (s->dict ? (s->copy_distance > s->dict_fill)
+                        : (s->copy_distance > (uint32_t)(s->dest - s->dest_start)))
+                goto error;
+
+            s->mode = MODE_COPY;
+            break;
+        }
+
+        case MODE_COPY:
+            while (s->copy_length > 0)
+            {
+                if (s->dest >= s->dest_limit)
+                    return INFLATE_OK;
+
+                uint8_t c;
+                if (s->dict)
+                {
+                    uint32_t pos = s->dict_pos + s->dict_size - s->copy_distance;
+                    if (pos >= s->dict_size)
+                        pos -= s->dict_size;
+                    c = s->dict[pos];
+                }
+                else
+                {
+                    c = *(s->dest - s->copy_distance);
+                }
+                put_byte(s, c);
+                s->copy_length--;
+            }
+            s->mode = MODE_CODES;
+            break;
+
+        case MODE_DONE:
+            return INFLATE_DONE;
+
+        default:
+            return INFLATE_DATA_ERROR;
+        }
+    }
+
+error:
+    s->mode = MODE_ERROR;
+    return INFLATE_DATA_ERROR;
+}
+
+uint32_t inflate_crc32(const void *data, uint32_t length, uint32_t crc)
+{
+    const uint8_t *p = (const uint8_t*)data;
+    while (length--)
+    {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ g_crc32_table[crc & 0x0F];
+        crc = (crc >> 4) ^ g_crc32_table[crc & 0x0F];
+    }
+    return crc;
+}
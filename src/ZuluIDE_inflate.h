@@ -0,0 +1,87 @@
+/**
+ * ZuluIDE™ - Copyright (c) 2026 Rabbit Hole Computing™
+ *
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version.
+ *
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional
+ * permissions described in the ZuluIDE Hardware Support Library Exception
+ * (GPL-3.0_HSL_Exception.md), as published by Rabbit Hole Computing™.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+// Decompressor for raw deflate streams (RFC 1951), used for deflate
+// compressed firmware packages and for block compressed images.
+// Output can be produced in pieces: inflate_run() returns when dest_limit
+// is reached and continues where it left off on the next call.
+
+#pragma once
+
+#include <stdint.h>
+
+// Return values of inflate_run()
+#define INFLATE_OK 0           // Output buffer full, call again to continue
+#define INFLATE_DONE 1         // End of the last block reached
+#define INFLATE_DATA_ERROR -3  // Invalid or truncated stream
+
+struct inflate_huff_t
+{
+    uint16_t counts[16];    // Number of codes of each bit length
+    uint16_t symbols[288];  // Symbols in canonical code order
+};
+
+struct inflate_state_t
+{
+    // Input. When source reaches source_limit, source_read_cb is called
+    // if set. It returns the next byte and may point source and source_limit
+    // to the rest of a refilled buffer, or returns -1 at the end of input.
+    const uint8_t *source;
+    const uint8_t *source_limit;
+    int (*source_read_cb)(inflate_state_t *s);
+
+    // Output, dest advances up to dest_limit
+    uint8_t *dest_start;
+    uint8_t *dest;
+    uint8_t *dest_limit;
+
+    // Window for back references when the output is not kept in one
+    // buffer from dest_start on. Must cover the window of the compressor.
+    uint8_t *dict;
+    uint32_t dict_size;
+    uint32_t dict_pos;
+    uint32_t dict_fill;
+
+    // Decoder state
+    uint32_t bit_buf;
+    uint32_t bit_count;
+    uint8_t mode;
+    bool final_block;
+    uint32_t copy_length;
+    uint32_t copy_distance;
+    inflate_huff_t lit_tree;
+    inflate_huff_t dist_tree;
+};
+
+// Prepare for a new stream. dict may be NULL if back references can be
+// resolved from the output buffer, i.e. dest_start stays the same and the
+// whole output fits between dest_start and dest_limit.
+void inflate_init(inflate_state_t *s, uint8_t *dict, uint32_t dict_size);
+
+// Decompress until the output buffer is full or the stream ends
+int inflate_run(inflate_state_t *s);
+
+// Update a CRC-32 (as used by zip) without the initial and final inversion
+uint32_t inflate_crc32(const void *data, uint32_t length, uint32_t crc);
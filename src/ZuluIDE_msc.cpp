@@ -36,6 +36,14 @@
 // external global SD variable
 extern SdFs SD;
 
+// delay while servicing read-ahead and write flushes for the MSC callbacks
+static void msc_delay(uint32_t ms) {
+  uint32_t start = millis();
+  do {
+    platform_poll_msc();
+  } while ((uint32_t)(millis() - start) < ms);
+}
+
 // card reader operation loop
 // assumption that SD card was enumerated and is working
 void zuluide_msc_loop() {
@@ -71,12 +79,12 @@ void zuluide_msc_loop() {
     switch (MSC_LEDMode) {
       case LED_BLINK_FAST:
         LED_OFF();
-        delay(30);
+        msc_delay(30);
         break;
       case LED_BLINK_SLOW:
-        delay(30);
+        msc_delay(30);
         LED_OFF();
-        delay(100);
+        msc_delay(100);
         syncCounter = 1;
         break;
       default:
@@ -90,7 +98,7 @@ void zuluide_msc_loop() {
     // LED always on in card reader mode
     MSC_LEDMode = LED_SOLIDON;
 	  LED_ON(); 
-    delay(30);
+    msc_delay(30);
   }
 
   // turn the LED off to indicate exiting MSC
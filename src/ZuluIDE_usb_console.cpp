@@ -58,6 +58,7 @@ extern void       zuluide_console_load_image(int dev_idx, const char *path);
 extern void       zuluide_console_eject(int dev_idx);
 extern bool       zuluide_console_insert(int dev_idx);
 extern bool       zuluide_console_load_next(int dev_idx);
+extern void       zuluide_console_run_benchmark();
 
 // -----------------------------------------------------------------------
 // Direct serial output — bypasses the log buffer so menu text never
@@ -110,6 +111,7 @@ enum class MenuState : uint8_t
     MainMenuUF2Confirm,       // Waiting for 'y' confirmation on UF2 bootloader reboot
     MainMenuMSCConfirm,       // Waiting for 'y' confirmation on USB SD card reader reboot
     MainMenuExitMSCConfirm,   // Waiting for 'y' confirmation on exiting USB SD card reader mode
+    MainMenuBenchmarkConfirm, // Waiting for 'y' confirmation on SD card benchmark
     ImageSelection,           // Image list and selection for primary device
     ImageSelectionList,       // Browsing enumerated images
 };
@@ -142,6 +144,7 @@ static void show_main_menu()
 #endif
         serial_println("    'r' - reboot");
         serial_println("    'u' - reboot into UF2 bootloader");
+        serial_println("    'k' - SD card benchmark");
 #ifdef PLATFORM_MASS_STORAGE
     }
     if (!platform_in_msc_mode())
@@ -352,6 +355,19 @@ void ideConsoleMenuProcess(char c)
                     serial_println("  Reboot into UF2 bootloader? Press 'y' to confirm or any other key to cancel:");
                     break;
 
+                case 'k':
+#ifdef PLATFORM_MASS_STORAGE
+                    if (platform_in_msc_mode())
+                    {
+                        show_main_menu();
+                        break;
+                    }
+#endif
+                    s_state = MenuState::MainMenuBenchmarkConfirm;
+                    serial_println("  The IDE bus does not respond during the benchmark, which takes about 40 seconds.");
+                    serial_println("  Run SD card benchmark? Press 'y' to confirm or any other key to cancel:");
+                    break;
+
 #ifdef PLATFORM_MASS_STORAGE
                 case 's':
                     if (!platform_in_msc_mode())
@@ -459,6 +475,24 @@ void ideConsoleMenuProcess(char c)
             break;
         }
 
+        // ----------------------------------------------------------------
+        case MenuState::MainMenuBenchmarkConfirm:
+        {
+            if (c == 'y' || c == 'Y')
+            {
+                logmsg("Starting SD card benchmark, results are logged as BENCH lines");
+                zuluide_console_run_benchmark();
+                s_state = MenuState::Inactive;
+            }
+            else
+            {
+                s_state             = MenuState::MainMenu;
+                s_menu_just_entered = true;
+                ideConsoleMenuProcess(c);
+            }
+            break;
+        }
+
 #ifdef PLATFORM_MASS_STORAGE
         // ----------------------------------------------------------------
         case MenuState::MainMenuMSCConfirm:
@@ -43,6 +43,14 @@ bootloader_bin = env.ElfToBin(
     bootloader_elf
 )
 
+# Report bootloader size against its 128 kB flash slot,
+# the linker script already fails the build if it does not fit.
+def report_bootloader_size(target, source, env):
+    size = os.path.getsize(str(target[0]))
+    print("Bootloader size: %d bytes, %.1f %% of 128 kB" % (size, size * 100.0 / (128 * 1024)))
+
+env.AddPostAction(bootloader_bin, report_bootloader_size)
+
 # Convert back to .o to facilitate linking
 def escape_cpp(path):
     '''Apply double-escaping for path name to include in generated C++ file'''
@@ -59,6 +59,7 @@ void IDEATAPIDevice::initialize(int devidx)
     if (m_devinfo.removable && !m_removable.ignore_prevent_removal)
         logmsg("Respecting host preventing removal of media");
     memset(&m_atapi_state, 0, sizeof(m_atapi_state));
+    memset(&m_poll_stats, 0, sizeof(m_poll_stats));
     IDEDevice::initialize(devidx);
 }
 
@@ -394,9 +395,22 @@ bool IDEATAPIDevice::cmd_packet(ide_registers_t *regs)
     uint8_t cmdbuf[12] = {0};
     ide_phy_read_block(cmdbuf, sizeof(cmdbuf));
 
+    uint32_t start_us = micros();
+    if (atapi_poll_is_steady() && handle_polling_command(cmdbuf))
+    {
+        dbgmsg("-- ATAPI command: ", get_atapi_command_name(cmdbuf[0]), " (fast path)");
+        update_poll_stats(true, start_us);
+        return true;
+    }
+
     dbgmsg("-- ATAPI command: ", get_atapi_command_name(cmdbuf[0]), " ", bytearray(cmdbuf, 12));
 
-    return handle_atapi_command_wrapper(cmdbuf);
+    bool status = handle_atapi_command_wrapper(cmdbuf);
+    if (is_polling_command(cmdbuf[0]))
+    {
+        update_poll_stats(false, start_us);
+    }
+    return status;
 }
 
 bool IDEATAPIDevice::cmd_device_reset(ide_registers_t *regs)
@@ -839,6 +853,89 @@ bool IDEATAPIDevice::atapi_recv_data_block(uint8_t *data, uint16_t blocksize)
     return true;
 }
 
+// REQUEST SENSE response when there is nothing to report, see atapi_request_sense()
+alignas(4) static const uint8_t g_atapi_no_sense_response[18] = {
+    0x80, 0, ATAPI_SENSE_NO_SENSE, 0, 0, 0, 0, 18 - 7, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+// GET EVENT STATUS NOTIFICATION response when there are no media events
+alignas(4) static const uint8_t g_atapi_no_event_response[4] = {
+    0, 2, 0x00, 0x04
+};
+
+bool IDEATAPIDevice::atapi_poll_is_steady()
+{
+    return !m_atapi_state.not_ready
+        && !m_atapi_state.unit_attention
+        && m_atapi_state.sense_key == ATAPI_SENSE_NO_SENSE
+        && m_atapi_state.sense_asc == ATAPI_ASC_NO_ASC
+        && is_medium_present();
+}
+
+bool IDEATAPIDevice::is_polling_command(uint8_t opcode)
+{
+    return opcode == ATAPI_CMD_TEST_UNIT_READY
+        || opcode == ATAPI_CMD_REQUEST_SENSE
+        || opcode == ATAPI_CMD_GET_EVENT_STATUS_NOTIFICATION;
+}
+
+// In steady state these commands do not change the device state,
+// so the responses are constant.
+bool IDEATAPIDevice::handle_polling_command(const uint8_t *cmd)
+{
+    switch (cmd[0])
+    {
+        case ATAPI_CMD_TEST_UNIT_READY:
+            return atapi_cmd_ok();
+
+        case ATAPI_CMD_REQUEST_SENSE:
+            atapi_send_data(g_atapi_no_sense_response, std::min<size_t>(cmd[4], sizeof(g_atapi_no_sense_response)));
+            if (ide_phy_is_command_interrupted())
+            {
+                return true;
+            }
+            if (m_atapi_state.crc_errors > 0)
+            {
+                logmsg("-- Detected ", m_atapi_state.crc_errors, " CRC errors during transfer, reporting error to host");
+                return atapi_cmd_error(ATAPI_SENSE_HARDWARE_ERROR, ATAPI_ASC_CRC_ERROR);
+            }
+            return atapi_request_sense_done();
+
+        case ATAPI_CMD_GET_EVENT_STATUS_NOTIFICATION:
+            if (!(cmd[1] & 1) || m_devinfo.media_status_events != ATAPI_MEDIA_EVENT_NOCHG) return false;
+            atapi_send_data(g_atapi_no_event_response, sizeof(g_atapi_no_event_response));
+            return atapi_cmd_ok();
+
+        default:
+            return false;
+    }
+}
+
+void IDEATAPIDevice::update_poll_stats(bool fast, uint32_t start_us)
+{
+    uint32_t elapsed = micros() - start_us;
+    if (fast)
+    {
+        m_poll_stats.fast_count++;
+        m_poll_stats.fast_us += elapsed;
+    }
+    else
+    {
+        m_poll_stats.normal_count++;
+        m_poll_stats.normal_us += elapsed;
+    }
+
+    uint32_t now = millis();
+    if ((uint32_t)(now - m_poll_stats.last_log_time) >= ATAPI_POLL_STATS_INTERVAL_MS)
+    {
+        dbgmsg("-- Status polling in last ", (int)((now - m_poll_stats.last_log_time) / 1000), " s: ",
+               (int)m_poll_stats.fast_count, " fast path commands in ", (int)m_poll_stats.fast_us, " us, ",
+               (int)m_poll_stats.normal_count, " normal commands in ", (int)m_poll_stats.normal_us, " us");
+        memset(&m_poll_stats, 0, sizeof(m_poll_stats));
+        m_poll_stats.last_log_time = now;
+    }
+}
+
 bool IDEATAPIDevice::handle_atapi_command_wrapper(const uint8_t *cmd)
 {
         // These command bypass unit attention
@@ -1290,6 +1387,11 @@ bool IDEATAPIDevice::atapi_request_sense(const uint8_t *cmd)
         m_atapi_state.not_ready = false;
     }
 
+    return atapi_request_sense_done();
+}
+
+bool IDEATAPIDevice::atapi_request_sense_done()
+{
     m_atapi_state.data_state = ATAPI_DATA_IDLE;
 
     ide_registers_t regs = {};
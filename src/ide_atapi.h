@@ -168,6 +168,16 @@ protected:
         char deferred_image_name[MAX_FILE_PATH+1];
     } m_removable;
 
+    // Time spent on commands the host repeats while polling for status
+    struct
+    {
+        uint32_t fast_count;
+        uint32_t fast_us;
+        uint32_t normal_count;
+        uint32_t normal_us;
+        uint32_t last_log_time;
+    } m_poll_stats;
+
     // Buffer used for responses, ide_phy code benefits from this being aligned to 32 bits
     // Enough for any inquiry/mode response and for up to one CD sector with Q subchannel
     union {
@@ -214,6 +224,16 @@ protected:
     bool atapi_cmd_error(uint8_t sense_key, uint16_t sense_asc);
     virtual bool atapi_cmd_not_ready_error();
     bool atapi_cmd_ok();
+    // Completion of REQUEST SENSE after the sense data has been sent
+    bool atapi_request_sense_done();
+
+    // Status polling commands are answered without the full dispatch when
+    // there are no pending errors, unit attention or media changes.
+    // Returns false if the command must go through handle_atapi_command_wrapper().
+    bool atapi_poll_is_steady();
+    virtual bool handle_polling_command(const uint8_t *cmd);
+    virtual bool is_polling_command(uint8_t opcode);
+    void update_poll_stats(bool fast, uint32_t start_us);
 
     // ATAPI command handlers
 
@@ -35,6 +35,7 @@
  */
 
 #include "ide_cdrom.h"
+#include "ide_cdrom_ecc.h"
 #include "ide_utils.h"
 #include "atapi_constants.h"
 #include "ZuluIDE_log.h"
@@ -225,43 +226,43 @@ static void doStopAudio();
 
 // Format track info read from cue sheet into the format used by ReadTOC command.
 // Refer to T10/1545-D MMC-4 Revision 5a, "Response Format 0000b: Formatted TOC"
-static void formatTrackInfo(const CUETrackInfo *track, uint8_t *dest, bool use_MSF_time)
+static void formatTrackInfo(uint8_t track_number, bool audio, uint32_t data_start, uint8_t *dest, bool use_MSF_time)
 {
     uint8_t control_adr = 0x14; // Digital track
 
-    if (track->track_mode == CUETrack_AUDIO)
+    if (audio)
     {
         control_adr = 0x10; // Audio track
     }
 
     dest[0] = 0; // Reserved
     dest[1] = control_adr;
-    dest[2] = track->track_number;
+    dest[2] = track_number;
     dest[3] = 0; // Reserved
 
     if (use_MSF_time)
     {
         // Time in minute-second-frame format
         dest[4] = 0;
-        LBA2MSF(track->data_start, &dest[5], false);
+        LBA2MSF(data_start, &dest[5], false);
     }
     else
     {
         // Time as logical block address
-        dest[4] = (track->data_start >> 24) & 0xFF;
-        dest[5] = (track->data_start >> 16) & 0xFF;
-        dest[6] = (track->data_start >>  8) & 0xFF;
-        dest[7] = (track->data_start >>  0) & 0xFF;
+        dest[4] = (data_start >> 24) & 0xFF;
+        dest[5] = (data_start >> 16) & 0xFF;
+        dest[6] = (data_start >>  8) & 0xFF;
+        dest[7] = (data_start >>  0) & 0xFF;
     }
 }
 
 // Format track info read from cue sheet into the format used by ReadFullTOC command.
 // Refer to T10/1545-D MMC-4 Revision 5a, "Response Format 0010b: Raw TOC"
-static void formatRawTrackInfo(const CUETrackInfo *track, uint8_t *dest, bool useBCD)
+static void formatRawTrackInfo(uint8_t track_number, bool audio, uint32_t data_start, uint8_t *dest, bool useBCD)
 {
     uint8_t control_adr = 0x14; // Digital track
 
-    if (track->track_mode == CUETrack_AUDIO)
+    if (audio)
     {
         control_adr = 0x10; // Audio track
     }
@@ -269,7 +270,7 @@ static void formatRawTrackInfo(const CUETrackInfo *track, uint8_t *dest, bool us
     dest[0] = 0x01; // Session always 1
     dest[1] = control_adr;
     dest[2] = 0x00; // "TNO", always 0?
-    dest[3] = track->track_number; // "POINT", contains track number
+    dest[3] = track_number; // "POINT", contains track number
     // Next three are ATIME. The spec doesn't directly address how these
     // should be reported in the TOC, just giving a description of Q-channel
     // data from Red Book/ECMA-130. On all disks tested so far these are
@@ -280,9 +281,9 @@ static void formatRawTrackInfo(const CUETrackInfo *track, uint8_t *dest, bool us
     dest[7] = 0; // HOUR
 
     if (useBCD) {
-        LBA2MSFBCD(track->data_start, &dest[8], false);
+        LBA2MSFBCD(data_start, &dest[8], false);
     } else {
-        LBA2MSF(track->data_start, &dest[8], false);
+        LBA2MSF(data_start, &dest[8], false);
     }
 }
 
@@ -307,6 +308,7 @@ void IDECDROMDevice::initialize(int devidx)
     set_esn_event(esn_event_t::NoChange);
 
     clear_cached_track_info();
+    m_toc.valid = false;
 
     m_eject_then_load_cycle = false;
 }
@@ -329,6 +331,7 @@ void IDECDROMDevice::set_image(IDEImage *image)
 {
     bool valid = false;
     clear_cached_track_info();
+    m_toc.valid = false;
     IDEATAPIDevice::set_image(image);
     memset(&m_first_track, 0, sizeof(m_first_track));
     memset(&m_last_track, 0, sizeof(m_last_track));
@@ -430,6 +433,7 @@ void IDECDROMDevice::set_image(IDEImage *image)
     else
     {
         m_devinfo.media_status_events = ATAPI_MEDIA_EVENT_NEW;
+        buildTOCCache();
     }
 
     if (valid)
@@ -725,6 +729,44 @@ bool IDECDROMDevice::atapi_read_cd_msf(const uint8_t *cmd)
     return doReadCD(start, end - start, sector_type, main_channel, sub_channel, false);
 }
 
+bool IDECDROMDevice::is_polling_command(uint8_t opcode)
+{
+    return opcode == ATAPI_CMD_READ_SUB_CHANNEL || IDEATAPIDevice::is_polling_command(opcode);
+}
+
+bool IDECDROMDevice::handle_polling_command(const uint8_t *cmd)
+{
+    // Media status with no pending events, see atapi_get_event_status_notification()
+    alignas(4) static const uint8_t no_media_event_response[8] = {
+        0, 6, IDECDROMDevice::esn_class_request_t::Media, 0x52, 0x00, 0x02, 0, 0
+    };
+
+    switch (cmd[0])
+    {
+        case ATAPI_CMD_GET_EVENT_STATUS_NOTIFICATION:
+            if (!(cmd[1] & 1) || !(cmd[4] & 0x10) ||
+                m_esn.event != esn_event_t::NoChange ||
+                m_esn.current_event != esn_event_t::NoChange ||
+                m_esn.request != esn_class_request_t::Media)
+            {
+                return false;
+            }
+            m_removable.receiving_event_status_notifications = true;
+            if (!atapi_send_data(no_media_event_response, sizeof(no_media_event_response)))
+            {
+                return atapi_cmd_error(ATAPI_SENSE_ABORTED_CMD, 0);
+            }
+            return atapi_cmd_ok();
+
+        // Subchannel data follows audio playback, but the command needs no other checks
+        case ATAPI_CMD_READ_SUB_CHANNEL:
+            return atapi_read_sub_channel(cmd);
+
+        default:
+            return IDEATAPIDevice::handle_polling_command(cmd);
+    }
+}
+
 bool IDECDROMDevice::atapi_get_event_status_notification(const uint8_t *cmd)
 {
     m_removable.receiving_event_status_notifications = true;
@@ -1131,47 +1173,60 @@ bool IDECDROMDevice::atapi_mechanism_status(const uint8_t *cmd)
     return atapi_cmd_ok();
 }
 
-bool IDECDROMDevice::doReadTOC(bool MSF, uint8_t track, uint16_t allocationLength)
+void IDECDROMDevice::buildTOCCache()
 {
-    uint8_t *buf = m_buffer.bytes;
-
-    // Format track info
-    uint8_t *trackdata = &buf[4];
     int trackcount = 0;
-    int firsttrack = -1;
     CUETrackInfo lasttrack = {0};
     const CUETrackInfo *trackinfo;
     uint64_t prev_capacity = 0;
     m_cueparser.restart();
-    while ((trackinfo = m_cueparser.next_track(prev_capacity)) != NULL)
+    while ((trackinfo = m_cueparser.next_track(prev_capacity)) != NULL && trackcount < TOC_MAX_TRACKS)
     {
-        if (firsttrack < 0) firsttrack = trackinfo->track_number;
         lasttrack = *trackinfo;
 
-        if (track <= trackinfo->track_number)
-        {
-            formatTrackInfo(trackinfo, &trackdata[8 * trackcount], MSF);
-            trackcount += 1;
-        }
+        toc_entry_t *entry = &m_toc.entries[trackcount++];
+        entry->track_number = trackinfo->track_number;
+        entry->audio = (trackinfo->track_mode == CUETrack_AUDIO);
+        entry->data_start = trackinfo->data_start;
 
         selectBinFileForTrack(trackinfo);
         prev_capacity = m_image->capacity();
     }
 
-    // Format lead-out track info
-    CUETrackInfo leadout = {};
-    leadout.track_number = 0xAA;
-    leadout.track_mode = (lasttrack.track_number != 0) ? lasttrack.track_mode : CUETrack_MODE1_2048;
-    leadout.data_start = getLeadOutLBA(&lasttrack);
-    formatTrackInfo(&leadout, &trackdata[8 * trackcount], MSF);
-    trackcount += 1;
+    // Lead-out track info
+    toc_entry_t *leadout = &m_toc.entries[trackcount];
+    leadout->track_number = 0xAA;
+    leadout->audio = (lasttrack.track_number != 0 && lasttrack.track_mode == CUETrack_AUDIO);
+    leadout->data_start = getLeadOutLBA(&lasttrack);
+
+    m_toc.count = trackcount;
+    m_toc.valid = true;
+}
+
+bool IDECDROMDevice::doReadTOC(bool MSF, uint8_t track, uint16_t allocationLength)
+{
+    uint8_t *buf = m_buffer.bytes;
+    if (!m_toc.valid) buildTOCCache();
+
+    // Format track info, including lead-out
+    uint8_t *trackdata = &buf[4];
+    int trackcount = 0;
+    for (int i = 0; i <= m_toc.count; i++)
+    {
+        const toc_entry_t *entry = &m_toc.entries[i];
+        if (i == m_toc.count || track <= entry->track_number)
+        {
+            formatTrackInfo(entry->track_number, entry->audio, entry->data_start, &trackdata[8 * trackcount], MSF);
+            trackcount += 1;
+        }
+    }
 
     // Format response header
     uint16_t toc_length = 2 + trackcount * 8;
     buf[0] = toc_length >> 8;
     buf[1] = toc_length & 0xFF;
-    buf[2] = firsttrack;
-    buf[3] = lasttrack.track_number;
+    buf[2] = (m_toc.count > 0) ? m_toc.entries[0].track_number : 0xFF;
+    buf[3] = (m_toc.count > 0) ? m_toc.entries[m_toc.count - 1].track_number : 0;
 
     if (track != 0xAA && trackcount < 2)
     {
@@ -1194,11 +1249,11 @@ bool IDECDROMDevice::doReadSessionInfo(bool MSF, uint16_t allocationLength)
 
     // Replace first track info in the session table
     // based on data from CUE sheet.
-    m_cueparser.restart();
-    const CUETrackInfo *trackinfo = m_cueparser.next_track();
-    if (trackinfo)
+    if (!m_toc.valid) buildTOCCache();
+    if (m_toc.count > 0)
     {
-        formatTrackInfo(trackinfo, &buf[4], MSF);
+        const toc_entry_t *entry = &m_toc.entries[0];
+        formatTrackInfo(entry->track_number, entry->audio, entry->data_start, &buf[4], MSF);
     }
 
     atapi_send_data(buf, std::min<uint32_t>(allocationLength, len));
@@ -1219,49 +1274,41 @@ bool IDECDROMDevice::doReadFullTOC(uint8_t session, uint16_t allocationLength, b
     memcpy(buf, FullTOCHeader, len);
 
     // Add track descriptors
-    int trackcount = 0;
-    int firsttrack = -1;
-    CUETrackInfo lasttrack = {0};
-    const CUETrackInfo *trackinfo;
-    uint64_t prev_capacity = 0;
-    m_cueparser.restart();
-    while ((trackinfo = m_cueparser.next_track(prev_capacity)) != NULL)
+    if (!m_toc.valid) buildTOCCache();
+    for (int i = 0; i < m_toc.count; i++)
     {
-        if (firsttrack < 0)
-        {
-            firsttrack = trackinfo->track_number;
-            if (trackinfo->track_mode == CUETrack_AUDIO)
-            {
-                buf[5] = 0x10;
-            }
-        }
-        lasttrack = *trackinfo;
-
-        formatRawTrackInfo(trackinfo, &buf[len], useBCD);
-        trackcount += 1;
+        const toc_entry_t *entry = &m_toc.entries[i];
+        formatRawTrackInfo(entry->track_number, entry->audio, entry->data_start, &buf[len], useBCD);
         len += 11;
-
-        selectBinFileForTrack(trackinfo);
-        prev_capacity = m_image->capacity();
     }
 
     // First and last track numbers
-    buf[12] = firsttrack;
-    if (lasttrack.track_number != 0)
+    if (m_toc.count > 0)
     {
-        buf[23] = lasttrack.track_number;
-        if (lasttrack.track_mode == CUETrack_AUDIO)
+        const toc_entry_t *first = &m_toc.entries[0];
+        const toc_entry_t *last = &m_toc.entries[m_toc.count - 1];
+        buf[12] = first->track_number;
+        buf[23] = last->track_number;
+        if (first->audio)
+        {
+            buf[5] = 0x10;
+        }
+        if (last->audio)
         {
             buf[16] = 0x10;
             buf[27] = 0x10;
         }
     }
+    else
+    {
+        buf[12] = 0xFF;
+    }
 
     // Leadout track position
     if (useBCD) {
-        LBA2MSFBCD(getLeadOutLBA(&lasttrack), &buf[34], false);
+        LBA2MSFBCD(m_toc.entries[m_toc.count].data_start, &buf[34], false);
     } else {
-        LBA2MSF(getLeadOutLBA(&lasttrack), &buf[34], false);
+        LBA2MSF(m_toc.entries[m_toc.count].data_start, &buf[34], false);
     }
 
     // Correct the record length in header
@@ -1388,6 +1435,11 @@ bool IDECDROMDevice::doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type
     // We may need to loop if the request spans multiple .bin files
     uint32_t total_length = length;
     uint32_t length_done = 0;
+    m_cd_read_format.ecc_sectors = 0;
+    m_cd_read_format.ecc_offloaded = 0;
+    m_cd_read_format.ecc_us = 0;
+    m_cd_read_format.next_valid = false;
+    cdrom_ecc_init();
 
     bool write_unfilled_pregap = false;
     while (length_done < total_length)
@@ -1535,12 +1587,12 @@ bool IDECDROMDevice::doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type
         }
         else if (trackinfo.track_mode == CUETrack_MODE1_2048 && (main_channel & 0xB8) == 0xB8)
         {
-            // Transfer 2048 bytes of data from file and fake the headers
+            // Transfer 2048 bytes of data from file and generate the headers and ECC
             m_cd_read_format.sector_length_file = 2048;
             m_cd_read_format.sector_data_length = 2048;
             m_cd_read_format.sector_length_out = 2048 + 304;
             m_cd_read_format.add_fake_headers = true;
-            dbgmsg("------ Host requested ECC data but image file lacks it, replacing with zeros");
+            dbgmsg("------ Host requested ECC data but image file lacks it, generating it");
         }
         else if (trackinfo.track_mode == CUETrack_MODE1_2352 && main_channel == 0x10)
         {
@@ -1617,6 +1669,19 @@ bool IDECDROMDevice::doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type
 
     }
 
+#ifdef PLATFORM_HAS_CORE1_WORKER
+    // Second core may still be working on a sector that was not sent
+    platform_core1_wait(m_cd_read_format.next_ticket);
+#endif
+    m_cd_read_format.next_valid = false;
+
+    if (m_cd_read_format.ecc_sectors > 0)
+    {
+        dbgmsg("------ Generated EDC/ECC for ", (int)m_cd_read_format.ecc_sectors, " sectors, ",
+               (int)m_cd_read_format.ecc_offloaded, " on second core, ",
+               (int)m_cd_read_format.ecc_us, " us on main core");
+    }
+
     return atapi_send_wait_finish() && atapi_cmd_ok();
 }
 
@@ -1647,59 +1712,36 @@ ssize_t IDECDROMDevice::read_callback(const uint8_t *data, size_t blocksize, siz
     size_t blocks_done = 0;
     while (blocks_done < num_blocks && atapi_send_data_is_ready(m_cd_read_format.sector_length_out))
     {
-        uint8_t *buf = m_buffer.bytes;
+        uint8_t *sector = m_buffer.bytes;
         uint32_t current_lba = m_cd_read_format.start_lba + m_cd_read_format.sectors_done;
 
-        if (m_cd_read_format.add_fake_headers)
-        {
-            // 12-byte data sector sync pattern
-            *buf++ = 0x00;
-            for (int i = 0; i < 10; i++)
-            {
-                *buf++ = 0xFF;
-            }
-            *buf++ = 0x00;
-
-            // 4-byte data sector header
-            LBA2MSFBCD(current_lba, buf, false);
-            buf += 3;
-            *buf++ = 0x01; // Mode 1
-        }
-
-        if (m_cd_read_format.sector_data_length > 0)
+#ifdef PLATFORM_HAS_CORE1_WORKER
+        // Sector queued on previous round may still be in progress in either buffer
+        platform_core1_wait(m_cd_read_format.next_ticket);
+#endif
+        if (m_cd_read_format.next_valid && m_cd_read_format.next_lba == current_lba)
         {
-            const uint8_t *data_start = data + blocksize * blocks_done + m_cd_read_format.sector_data_skip;
-            size_t data_length = m_cd_read_format.sector_data_length;
-            memcpy(buf, data_start, data_length);
-            buf += data_length;
+            sector = m_cd_read_format.next_buffer;
         }
-
-        if (m_cd_read_format.add_fake_headers)
+        else
         {
-            // 288 bytes of ECC
-            memset(buf, 0, 288);
-            buf += 288;
+            formatSector(sector, data + blocksize * blocks_done, current_lba, nullptr);
         }
+        m_cd_read_format.next_valid = false;
 
-        if (m_cd_read_format.field_q_subchannel)
+#ifdef PLATFORM_HAS_CORE1_WORKER
+        // Let the second core generate EDC/ECC for the next sector while this one is sent
+        if (m_cd_read_format.add_fake_headers && blocks_done + 1 < num_blocks && platform_core1_is_running())
         {
-            // Formatted Q subchannel data
-            // Refer to table 354 in T10/1545-D MMC-4 Revision 5a
-            // and ECMA-130 22.3.3
-            *buf++ = (m_cd_read_format.trackinfo.track_mode == CUETrack_AUDIO ? 0x10 : 0x14); // Control & ADR
-            *buf++ = BYTE2BCD(m_cd_read_format.trackinfo.track_number);
-            *buf++ = (current_lba >= m_cd_read_format.trackinfo.data_start) ? 1 : 0; // Index number (0 = pregap)
-            int32_t rel = (int32_t)(current_lba) - (int32_t)m_cd_read_format.trackinfo.data_start;
-            LBA2MSFBCD(rel, buf, true); buf += 3;
-            *buf++ = 0;
-            LBA2MSFBCD(current_lba, buf, false); buf += 3;
-            *buf++ = 0; *buf++ = 0; // CRC (optional)
-            *buf++ = 0; *buf++ = 0; *buf++ = 0; // (pad)
-            *buf++ = 0; // No P subchannel
+            uint8_t *next = (sector == m_buffer.bytes) ? (uint8_t*)m_format_buffer : m_buffer.bytes;
+            formatSector(next, data + blocksize * (blocks_done + 1), current_lba + 1, &m_cd_read_format.next_ticket);
+            m_cd_read_format.next_valid = true;
+            m_cd_read_format.next_lba = current_lba + 1;
+            m_cd_read_format.next_buffer = next;
         }
+#endif
 
-        assert(buf == m_buffer.bytes + m_cd_read_format.sector_length_out);
-        ssize_t status = atapi_send_data_async(m_buffer.bytes, m_cd_read_format.sector_length_out, 1);
+        ssize_t status = atapi_send_data_async(sector, m_cd_read_format.sector_length_out, 1);
 
         if (status < 0)
         {
@@ -1722,6 +1764,80 @@ ssize_t IDECDROMDevice::read_callback(const uint8_t *data, size_t blocksize, siz
     return blocks_done;
 }
 
+static void cdrom_ecc_job(void *param)
+{
+    cdrom_ecc_encode_mode1((uint8_t*)param);
+}
+
+// Build one output sector from the image file data. When ecc_ticket is given,
+// EDC/ECC generation is queued to the second core if it is available.
+void IDECDROMDevice::formatSector(uint8_t *dest, const uint8_t *data, uint32_t lba, uint32_t *ecc_ticket)
+{
+    uint8_t *buf = dest;
+
+    if (m_cd_read_format.add_fake_headers)
+    {
+        // 12-byte data sector sync pattern
+        *buf++ = 0x00;
+        for (int i = 0; i < 10; i++)
+        {
+            *buf++ = 0xFF;
+        }
+        *buf++ = 0x00;
+
+        // 4-byte data sector header
+        LBA2MSFBCD(lba, buf, false);
+        buf += 3;
+        *buf++ = 0x01; // Mode 1
+    }
+
+    if (m_cd_read_format.sector_data_length > 0)
+    {
+        const uint8_t *data_start = data + m_cd_read_format.sector_data_skip;
+        size_t data_length = m_cd_read_format.sector_data_length;
+        memcpy(buf, data_start, data_length);
+        buf += data_length;
+    }
+
+    if (m_cd_read_format.add_fake_headers)
+    {
+        // 288 bytes of EDC and ECC
+#ifdef PLATFORM_HAS_CORE1_WORKER
+        if (ecc_ticket && (*ecc_ticket = platform_core1_submit(cdrom_ecc_job, dest)) != 0)
+        {
+            m_cd_read_format.ecc_offloaded++;
+        }
+        else
+#endif
+        {
+            uint32_t start = micros();
+            cdrom_ecc_job(dest);
+            m_cd_read_format.ecc_us += (uint32_t)(micros() - start);
+        }
+        m_cd_read_format.ecc_sectors++;
+        buf += 288;
+    }
+
+    if (m_cd_read_format.field_q_subchannel)
+    {
+        // Formatted Q subchannel data
+        // Refer to table 354 in T10/1545-D MMC-4 Revision 5a
+        // and ECMA-130 22.3.3
+        *buf++ = (m_cd_read_format.trackinfo.track_mode == CUETrack_AUDIO ? 0x10 : 0x14); // Control & ADR
+        *buf++ = BYTE2BCD(m_cd_read_format.trackinfo.track_number);
+        *buf++ = (lba >= m_cd_read_format.trackinfo.data_start) ? 1 : 0; // Index number (0 = pregap)
+        int32_t rel = (int32_t)(lba) - (int32_t)m_cd_read_format.trackinfo.data_start;
+        LBA2MSFBCD(rel, buf, true); buf += 3;
+        *buf++ = 0;
+        LBA2MSFBCD(lba, buf, false); buf += 3;
+        *buf++ = 0; *buf++ = 0; // CRC (optional)
+        *buf++ = 0; *buf++ = 0; *buf++ = 0; // (pad)
+        *buf++ = 0; // No P subchannel
+    }
+
+    assert(buf == dest + m_cd_read_format.sector_length_out);
+}
+
 bool IDECDROMDevice::loadAndValidateCueSheet(FsFile *dir, const char *cuesheetname, CUETrackInfo &first_track, CUETrackInfo &last_track)
 {
     memset(&first_track, 0, sizeof(CUETrackInfo));
@@ -2309,6 +2425,13 @@ bool IDECDROMDevice::doPlayAudio(uint32_t lba, uint32_t length)
             return atapi_cmd_error(ATAPI_SENSE_ILLEGAL_REQ, ATAPI_ASC_ILLEGAL_MODE_FOR_TRACK);
         }
 
+        // Audio output reads the track file directly and would play compressed data as is
+        if (selectBinFileForTrack(&trackinfo) && m_image->is_compressed())
+        {
+            dbgmsg("---- Host tried audio playback on a compressed image");
+            return atapi_cmd_error(ATAPI_SENSE_ILLEGAL_REQ, ATAPI_ASC_ILLEGAL_MODE_FOR_TRACK);
+        }
+
         // if transfer length is zero no audio playback happens.
         // don't treat as an error per SCSI-2; audio_play returns true
 
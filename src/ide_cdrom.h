@@ -28,6 +28,7 @@
 #pragma once
 
 #include "ide_atapi.h"
+#include "ZuluIDE_platform.h"
 #include <scp/SharedCUEParser.h>
 
 class IDECDROMDevice: public IDEATAPIDevice
@@ -85,6 +86,8 @@ public:
 protected:
     
     virtual bool handle_atapi_command(const uint8_t *cmd);
+    virtual bool handle_polling_command(const uint8_t *cmd) override;
+    virtual bool is_polling_command(uint8_t opcode) override;
     bool atapi_cmd_not_ready_error() override;
     virtual bool atapi_set_cd_speed(const uint8_t *cmd);
     virtual bool atapi_read_disc_information(const uint8_t *cmd);
@@ -118,13 +121,27 @@ protected:
         int sector_length_out; // Sector length output to IDE bus
         int sector_data_skip; // Skip number of bytes at beginning of file sector
         int sector_data_length; // Number of bytes of sector data to copy
-        bool add_fake_headers;
+        bool add_fake_headers; // Generate sync, header, EDC and ECC around 2048 byte data
         bool field_q_subchannel;
         CUETrackInfo trackinfo;
         uint32_t start_lba;
         uint32_t sectors_done;
+        uint32_t ecc_sectors; // Time spent on EDC/ECC generation for the command
+        uint32_t ecc_offloaded;
+        uint32_t ecc_us;
+        bool next_valid; // Sector at next_lba has already been formatted into next_buffer
+        uint32_t next_lba;
+        uint8_t *next_buffer;
+        uint32_t next_ticket; // Second core job generating EDC/ECC for next_buffer
     } m_cd_read_format;
 
+#ifdef PLATFORM_HAS_CORE1_WORKER
+    // Raw sectors are formatted alternately into m_buffer and this,
+    // so that one is sent while the second core generates EDC/ECC for the other.
+    uint32_t m_format_buffer[sizeof(m_buffer) / 4];
+#endif
+    void formatSector(uint8_t *dest, const uint8_t *data, uint32_t lba, uint32_t *ecc_ticket);
+
     // Read handling and sector format translation if needed
     virtual bool doRead(uint32_t lba, uint32_t transfer_len) override;
     bool doReadCD(uint32_t lba, uint32_t length, uint8_t sector_type,
@@ -142,6 +159,23 @@ protected:
     uint32_t m_cached_end_lba;
     uint64_t m_cached_capacity_lba;
 
+    // Track list for READ TOC responses, collected from the cue sheet once
+    // when media is loaded so that repeated TOC reads need no parsing or bin file switching.
+    static constexpr int TOC_MAX_TRACKS = 99;
+    struct toc_entry_t
+    {
+        uint8_t track_number;
+        bool audio;
+        uint32_t data_start;
+    };
+    struct
+    {
+        bool valid;
+        int count; // Number of tracks, followed by the lead-out entry
+        toc_entry_t entries[TOC_MAX_TRACKS + 1];
+    } m_toc;
+    void buildTOCCache();
+
     int m_selected_file_index;
     // If the .cue file has data split across multiple files,
     // this function will reopen m_imagefile when track is changed.
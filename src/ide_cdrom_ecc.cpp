@@ -0,0 +1,122 @@
+/**
+ * ZuluIDE™ - Copyright (c) 2026 Rabbit Hole Computing™
+ *
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version.
+ *
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional
+ * permissions described in the ZuluIDE Hardware Support Library Exception
+ * (GPL-3.0_HSL_Exception.md), as published by Rabbit Hole Computing™.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "ide_cdrom_ecc.h"
+
+// Tables are generated into RAM on first use, as table lookups from flash
+// would be slowed down by XIP cache misses.
+static bool g_ecc_tables_ready;
+static uint32_t g_edc_table[256];
+static uint8_t g_ecc_f_table[256];
+static uint8_t g_ecc_b_table[256];
+
+static void ecc_init_tables()
+{
+    for (uint32_t i = 0; i < 256; i++)
+    {
+        // EDC is CRC-32 with polynomial x^32 + x^31 + x^16 + x^15 + x^4 + x^3 + x + 1, LSB first
+        uint32_t edc = i;
+        for (int j = 0; j < 8; j++)
+        {
+            edc = (edc >> 1) ^ ((edc & 1) ? 0xD8018001 : 0);
+        }
+        g_edc_table[i] = edc;
+
+        // Multiplication by alpha in GF(2^8) with polynomial x^8 + x^4 + x^3 + x^2 + 1,
+        // and the inverse of (1 + alpha) used for solving the second parity byte.
+        uint32_t f = (i << 1) ^ ((i & 0x80) ? 0x11D : 0);
+        g_ecc_f_table[i] = f;
+        g_ecc_b_table[i ^ f] = i;
+    }
+
+    g_ecc_tables_ready = true;
+}
+
+static uint32_t edc_compute(const uint8_t *data, uint32_t length)
+{
+    uint32_t edc = 0;
+    while (length--)
+    {
+        edc = (edc >> 8) ^ g_edc_table[(edc ^ *data++) & 0xFF];
+    }
+    return edc;
+}
+
+// Compute one set of parity bytes (P or Q) over the data starting at the sector header.
+// Each of major_count codewords takes minor_count bytes, stepping by minor_inc and
+// wrapping around at the end of the covered area.
+static void ecc_compute_block(const uint8_t *src, uint32_t major_count, uint32_t minor_count,
+                              uint32_t major_mult, uint32_t minor_inc, uint8_t *dest)
+{
+    uint32_t size = major_count * minor_count;
+    for (uint32_t major = 0; major < major_count; major++)
+    {
+        uint32_t index = (major >> 1) * major_mult + (major & 1);
+        uint8_t ecc_a = 0;
+        uint8_t ecc_b = 0;
+        for (uint32_t minor = 0; minor < minor_count; minor++)
+        {
+            uint8_t temp = src[index];
+            index += minor_inc;
+            if (index >= size) index -= size;
+            ecc_a ^= temp;
+            ecc_b ^= temp;
+            ecc_a = g_ecc_f_table[ecc_a];
+        }
+        ecc_a = g_ecc_b_table[g_ecc_f_table[ecc_a] ^ ecc_b];
+        dest[major] = ecc_a;
+        dest[major + major_count] = ecc_a ^ ecc_b;
+    }
+}
+
+void cdrom_ecc_init()
+{
+    if (!g_ecc_tables_ready)
+    {
+        ecc_init_tables();
+    }
+}
+
+void cdrom_ecc_encode_mode1(uint8_t *sector)
+{
+    cdrom_ecc_init();
+
+    // EDC over sync, header and user data, stored little endian
+    uint32_t edc = edc_compute(sector, 2064);
+    sector[2064] = (edc >>  0) & 0xFF;
+    sector[2065] = (edc >>  8) & 0xFF;
+    sector[2066] = (edc >> 16) & 0xFF;
+    sector[2067] = (edc >> 24) & 0xFF;
+
+    // Intermediate field is zero in Mode 1
+    for (int i = 2068; i < 2076; i++)
+    {
+        sector[i] = 0;
+    }
+
+    // P parity: 86 columns of 24 bytes, Q parity: 52 diagonals of 43 bytes including P
+    ecc_compute_block(sector + 12, 86, 24, 2, 86, sector + 2076);
+    ecc_compute_block(sector + 12, 52, 43, 86, 88, sector + 2248);
+}
@@ -0,0 +1,42 @@
+/**
+ * ZuluIDE™ - Copyright (c) 2026 Rabbit Hole Computing™
+ *
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version.
+ *
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional
+ * permissions described in the ZuluIDE Hardware Support Library Exception
+ * (GPL-3.0_HSL_Exception.md), as published by Rabbit Hole Computing™.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+// EDC and ECC generation for CD-ROM Mode 1 sectors, used when the host
+// reads raw 2352 byte sectors from an image that only stores 2048 byte user data.
+// Refer to ECMA-130 Annex A (CRC) and Annex B (Reed-Solomon Product Code).
+
+#pragma once
+
+#include <stdint.h>
+
+#define CDROM_SECTOR_RAW_SIZE 2352
+
+// Generate the lookup tables, done automatically on first encode.
+// Call before encoding from several cores at once.
+void cdrom_ecc_init();
+
+// Fill in the EDC, zero and P/Q parity fields (bytes 2064 to 2351) of a Mode 1 sector.
+// The sync pattern, header and 2048 bytes of user data must already be in place.
+void cdrom_ecc_encode_mode1(uint8_t *sector);
@@ -0,0 +1,373 @@
+/**
+ * ZuluIDE™ - Copyright (c) 2026 Rabbit Hole Computing™
+ *
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version.
+ *
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional
+ * permissions described in the ZuluIDE Hardware Support Library Exception
+ * (GPL-3.0_HSL_Exception.md), as published by Rabbit Hole Computing™.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "ide_imagefile.h"
+#include "ZuluIDE.h"
+#include "ZuluIDE_log.h"
+#include <string.h>
+#include <algorithm>
+#include "ZuluIDE_inflate.h"
+
+extern "C" unsigned long micros();
+
+IDECompressedImage::cache_slot_t IDECompressedImage::s_cache[IDE_COMPRESSED_CACHE_SIZE / IDE_COMPRESSED_MIN_BLOCK_SIZE];
+uint32_t IDECompressedImage::s_cache_storage[IDE_COMPRESSED_CACHE_SIZE / 4];
+uint32_t IDECompressedImage::s_cache_block_size;
+uint32_t IDECompressedImage::s_cache_slots;
+uint32_t IDECompressedImage::s_cache_counter;
+
+IDECompressedImage::IDECompressedImage():
+    m_file(nullptr), m_work(nullptr), m_work_size(0),
+    m_block_size(0), m_block_count(0), m_index_offset(0), m_image_size(0),
+    m_index_first(0), m_index_count(0)
+{
+    memset(&m_stats, 0, sizeof(m_stats));
+}
+
+bool IDECompressedImage::open(ZuluContainerFs::ZCFsFile *file, uint8_t *work_buffer, size_t work_buffer_size)
+{
+    close();
+
+    ide_compressed_header_t header;
+    if (file->size() < sizeof(header) || !file->seek(0) ||
+        file->read(&header, sizeof(header)) != sizeof(header) ||
+        memcmp(header.magic, IDE_COMPRESSED_MAGIC, sizeof(header.magic)) != 0)
+    {
+        file->seek(0);
+        return false;
+    }
+
+    uint32_t block_size = header.block_size;
+    if (block_size < IDE_COMPRESSED_MIN_BLOCK_SIZE || block_size > IDE_COMPRESSED_MAX_BLOCK_SIZE ||
+        (block_size & (block_size - 1)) != 0 || block_size > IDE_COMPRESSED_CACHE_SIZE ||
+        header.block_count != (header.image_size + block_size - 1) / block_size ||
+        header.header_size < sizeof(header))
+    {
+        logmsg("Compressed image has invalid header, block size ", (int)block_size,
+               " block count ", (int)header.block_count);
+        return false;
+    }
+
+    if (work_buffer_size < 2 * block_size)
+    {
+        logmsg("Compressed image block size ", (int)block_size, " too large for buffer of ", (int)work_buffer_size);
+        return false;
+    }
+
+    m_file = file;
+    m_work = work_buffer;
+    m_work_size = work_buffer_size;
+    m_block_size = block_size;
+    m_block_count = header.block_count;
+    m_index_offset = header.header_size;
+    m_image_size = header.image_size;
+    m_index_first = 0;
+    m_index_count = 0;
+    memset(&m_stats, 0, sizeof(m_stats));
+
+    logmsg("Image is compressed, ", (int)(m_image_size / 1024), " kB in ", (int)m_block_count,
+           " blocks of ", (int)m_block_size, " bytes, file size ", (int)(file->size() / 1024), " kB");
+    return true;
+}
+
+void IDECompressedImage::close()
+{
+    if (!m_file) return;
+
+    if (m_stats.bytes_read > 0)
+    {
+        uint64_t kb = (uint64_t)m_stats.decompressed_blocks * (m_block_size / 1024);
+        uint64_t us = m_stats.decompress_us;
+        logmsg("Compressed image read ", (int)(m_stats.bytes_read / 1024), " kB, cache hits ",
+               (int)m_stats.cache_hits, " misses ", (int)m_stats.cache_misses,
+               " zero blocks ", (int)m_stats.zero_blocks,
+               ", decompression speed ", (int)(us > 0 ? kb * 1000000 / us : 0), " kB/s");
+    }
+
+    // Drop cached blocks of this image
+    for (uint32_t i = 0; i < s_cache_slots; i++)
+    {
+        if (s_cache[i].owner == this)
+            s_cache[i].owner = nullptr, s_cache[i].length = 0;
+    }
+
+    m_file = nullptr;
+    m_image_size = 0;
+}
+
+// Divide the cache storage into slots of one block each.
+// Everything cached is dropped if the block size changes.
+void IDECompressedImage::cache_setup(uint32_t block_size)
+{
+    if (s_cache_block_size == block_size) return;
+
+    s_cache_block_size = block_size;
+    s_cache_slots = IDE_COMPRESSED_CACHE_SIZE / block_size;
+    for (uint32_t i = 0; i < s_cache_slots; i++)
+    {
+        s_cache[i].owner = nullptr;
+        s_cache[i].length = 0;
+        s_cache[i].zero = false;
+        s_cache[i].last_used = 0;
+        s_cache[i].data = (uint8_t*)s_cache_storage + i * block_size;
+    }
+}
+
+uint32_t IDECompressedImage::block_length(uint32_t block)
+{
+    uint64_t start = (uint64_t)block * m_block_size;
+    return (uint32_t)std::min<uint64_t>(m_block_size, m_image_size - start);
+}
+
+// Get the file offsets of a block from the index.
+// A window of index entries is kept in RAM so that sequential access
+// rarely needs to read the index from the SD card.
+bool IDECompressedImage::get_block_range(uint32_t block, uint64_t *start, uint64_t *end)
+{
+    if (block < m_index_first || block + 1 >= m_index_first + m_index_count)
+    {
+        uint32_t count = std::min<uint32_t>(INDEX_WINDOW, m_block_count + 1 - block);
+        if (!m_file->seek(m_index_offset + (uint64_t)block * sizeof(uint64_t)) ||
+            m_file->read(m_index, count * sizeof(uint64_t)) != count * sizeof(uint64_t))
+        {
+            logmsg("Compressed image index read failed for block ", (int)block);
+            m_index_count = 0;
+            return false;
+        }
+
+        m_index_first = block;
+        m_index_count = count;
+    }
+
+    *start = m_index[block - m_index_first];
+    *end = m_index[block + 1 - m_index_first];
+    return *end >= *start && *end - *start <= m_block_size;
+}
+
+bool IDECompressedImage::load_block(uint32_t block, cache_slot_t *slot, uint32_t length)
+{
+    uint64_t start, end;
+    if (!get_block_range(block, &start, &end))
+    {
+        logmsg("Compressed image has invalid index entry for block ", (int)block);
+        return false;
+    }
+
+    uint32_t stored_len = (uint32_t)(end - start);
+    if (stored_len == 0)
+    {
+        // Zero blocks share one cache slot, no need to read anything
+        memset(slot->data, 0, m_block_size);
+        slot->owner = nullptr;
+        slot->zero = true;
+        slot->length = m_block_size;
+        m_stats.zero_blocks++;
+        return true;
+    }
+
+    slot->owner = this;
+    slot->block = block;
+    slot->zero = false;
+    slot->length = 0;
+
+    if (!m_file->seek(start))
+    {
+        logmsg("Compressed image seek failed for block ", (int)block);
+        return false;
+    }
+
+    if (stored_len == length)
+    {
+        // Incompressible block is stored as is
+        if (m_file->read(slot->data, length) != length)
+        {
+            logmsg("Compressed image read failed for block ", (int)block);
+            return false;
+        }
+    }
+    else
+    {
+        if (m_file->read(m_work, stored_len) != stored_len)
+        {
+            logmsg("Compressed image read failed for block ", (int)block);
+            return false;
+        }
+
+        uint32_t start_us = micros();
+        inflate_state_t d;
+        inflate_init(&d, NULL, 0);
+        d.source = m_work;
+        d.source_limit = m_work + stored_len;
+        d.dest_start = d.dest = slot->data;
+        d.dest_limit = slot->data + length;
+        int res = inflate_run(&d);
+        m_stats.decompress_us += (uint32_t)(micros() - start_us);
+        m_stats.decompressed_blocks++;
+
+        if ((res != INFLATE_DONE && res != INFLATE_OK) || d.dest != slot->data + length)
+        {
+            logmsg("Compressed image block ", (int)block, " decompression failed with error ", res);
+            return false;
+        }
+    }
+
+    slot->length = length;
+    return true;
+}
+
+// Find block from cache or load it to the least recently used slot.
+// The pinned slot is never evicted, it is used for data still being transferred.
+IDECompressedImage::cache_slot_t *IDECompressedImage::get_block(uint32_t block, const cache_slot_t *pinned)
+{
+    cache_setup(m_block_size);
+    uint32_t length = block_length(block);
+
+    cache_slot_t *victim = nullptr;
+    for (uint32_t i = 0; i < s_cache_slots; i++)
+    {
+        cache_slot_t *slot = &s_cache[i];
+        if (slot->length > 0 && slot->owner == this && slot->block == block)
+        {
+            slot->last_used = ++s_cache_counter;
+            m_stats.cache_hits++;
+            return slot;
+        }
+
+        if (slot != pinned && (!victim || slot->last_used < victim->last_used))
+        {
+            victim = slot;
+        }
+    }
+
+    if (!victim) return nullptr;
+
+    // Check the index before reusing an existing zero slot
+    uint64_t start, end;
+    if (!get_block_range(block, &start, &end))
+    {
+        return nullptr;
+    }
+
+    if (start == end)
+    {
+        for (uint32_t i = 0; i < s_cache_slots; i++)
+        {
+            if (s_cache[i].zero && s_cache[i].length >= length)
+            {
+                s_cache[i].last_used = ++s_cache_counter;
+                m_stats.zero_blocks++;
+                return &s_cache[i];
+            }
+        }
+    }
+
+    m_stats.cache_misses++;
+    if (!load_block(block, victim, length))
+    {
+        victim->length = 0;
+        return nullptr;
+    }
+
+    victim->last_used = ++s_cache_counter;
+    return victim;
+}
+
+bool IDECompressedImage::read(uint64_t startpos, size_t blocksize, size_t num_blocks, IDEImage::Callback *callback)
+{
+    dbgmsg("IDECompressedImage::read: startpos=", (int64_t)startpos, " blocksize=", (int)blocksize,
+           " num_blocks=", (int)num_blocks);
+
+    if (startpos + (uint64_t)blocksize * num_blocks > m_image_size || blocksize > m_block_size)
+    {
+        logmsg("IDECompressedImage::read: request beyond image end or block size too large");
+        return false;
+    }
+
+    // Sectors that cross a compressed block boundary are gathered after the
+    // area used for compressed input
+    uint8_t *gather = m_work + m_block_size;
+    uint64_t pos = startpos;
+    size_t remaining = num_blocks;
+
+    while (remaining > 0)
+    {
+        platform_poll();
+
+        uint32_t block = pos / m_block_size;
+        uint32_t offset = pos % m_block_size;
+        cache_slot_t *slot = get_block(block, nullptr);
+        if (!slot) return false;
+
+        const uint8_t *data;
+        size_t count;
+        uint32_t available = block_length(block) - offset;
+        if (available >= blocksize)
+        {
+            data = slot->data + offset;
+            count = std::min<size_t>(remaining, available / blocksize);
+        }
+        else
+        {
+            // The first part is already copied, so the slot may be evicted.
+            // With a single cache slot the next block has to reuse it.
+            memcpy(gather, slot->data + offset, available);
+            cache_slot_t *next = get_block(block + 1, nullptr);
+            if (!next) return false;
+            memcpy(gather + available, next->data, blocksize - available);
+            slot = next;
+            data = gather;
+            count = 1;
+        }
+
+        // Decompress the following block while the previous data is being sent
+        bool prefetched = (s_cache_slots < 2);
+        uint32_t next_block = (pos + count * blocksize) / m_block_size;
+        size_t done = 0;
+        while (done < count)
+        {
+            ssize_t status = callback->read_callback(data + done * blocksize, blocksize, count - done);
+            if (status < 0)
+                return false;
+
+            done += status;
+            if (done < count && !prefetched)
+            {
+                prefetched = true;
+                if (next_block < m_block_count && next_block != block)
+                    get_block(next_block, slot);
+            }
+            else if (done < count)
+            {
+                platform_poll();
+            }
+        }
+
+        pos += count * blocksize;
+        remaining -= count;
+        m_stats.bytes_read += count * blocksize;
+    }
+
+    return true;
+}
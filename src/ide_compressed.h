@@ -0,0 +1,132 @@
+/**
+ * ZuluIDE™ - Copyright (c) 2026 Rabbit Hole Computing™
+ *
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version.
+ *
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional
+ * permissions described in the ZuluIDE Hardware Support Library Exception
+ * (GPL-3.0_HSL_Exception.md), as published by Rabbit Hole Computing™.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+// Read-only block compressed image format.
+//
+// The image is split into fixed size blocks that are each deflate compressed
+// independently, so that any block can be decompressed without its neighbours.
+//
+// File layout (all values little endian):
+//   0:            ide_compressed_header_t
+//   header_size:  block_count + 1 uint64_t file offsets, block i is stored at
+//                 offsets [i, i+1). Length 0 means the block is all zeros,
+//                 length equal to the block length means it is stored uncompressed,
+//                 otherwise it is a raw deflate stream.
+//
+// The packer tool is in utils/zuluide_compress_image.c.
+//
+// This is used through IDEImageFile, which includes this header after
+// the IDEImage interface definition.
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <ZCFsFile.h>
+#include "ZuluIDE_config.h"
+
+#define IDE_COMPRESSED_MAGIC "ZIDECMP1"
+// Minimum block size is larger than a raw CD sector so that a sector
+// never spans more than two blocks
+#define IDE_COMPRESSED_MIN_BLOCK_SIZE 4096
+#define IDE_COMPRESSED_MAX_BLOCK_SIZE 32768
+
+struct ide_compressed_header_t
+{
+    char magic[8];
+    uint32_t header_size;
+    uint32_t block_size;
+    uint64_t image_size;
+    uint32_t block_count;
+    uint32_t flags;
+    uint8_t reserved[32];
+};
+
+class IDECompressedImage
+{
+public:
+    IDECompressedImage();
+
+    // Check the file for the compressed image header and load its parameters.
+    // Returns false for normal images. The work buffer must hold two blocks,
+    // one for compressed data and one for gathering sectors that cross blocks.
+    bool open(ZuluContainerFs::ZCFsFile *file, uint8_t *work_buffer, size_t work_buffer_size);
+    void close();
+    bool is_open() { return m_file != nullptr; }
+
+    uint64_t capacity() { return m_image_size; }
+
+    // Same contract as IDEImage::read(), data is served from the block cache
+    bool read(uint64_t startpos, size_t blocksize, size_t num_blocks, IDEImage::Callback *callback);
+
+protected:
+    ZuluContainerFs::ZCFsFile *m_file;
+    uint8_t *m_work;
+    size_t m_work_size;
+
+    uint32_t m_block_size;
+    uint32_t m_block_count;
+    uint32_t m_index_offset;
+    uint64_t m_image_size;
+
+    // Window of the block offset index, loaded on demand
+    static constexpr uint32_t INDEX_WINDOW = 64;
+    uint64_t m_index[INDEX_WINDOW];
+    uint32_t m_index_first;
+    uint32_t m_index_count;
+
+    // Statistics, logged when the image is closed
+    struct {
+        uint64_t bytes_read;
+        uint32_t cache_hits;
+        uint32_t cache_misses;
+        uint32_t zero_blocks;
+        uint64_t decompress_us;
+        uint32_t decompressed_blocks;
+    } m_stats;
+
+    // Decompressed blocks are kept in a small LRU cache shared by all
+    // compressed images, IDE_COMPRESSED_CACHE_SIZE / block_size slots.
+    struct cache_slot_t
+    {
+        const IDECompressedImage *owner;
+        uint32_t block;
+        uint32_t length;
+        uint32_t last_used;
+        bool zero;
+        uint8_t *data;
+    };
+    static cache_slot_t s_cache[IDE_COMPRESSED_CACHE_SIZE / IDE_COMPRESSED_MIN_BLOCK_SIZE];
+    static uint32_t s_cache_storage[IDE_COMPRESSED_CACHE_SIZE / 4];
+    static uint32_t s_cache_block_size;
+    static uint32_t s_cache_slots;
+    static uint32_t s_cache_counter;
+
+    static void cache_setup(uint32_t block_size);
+
+    uint32_t block_length(uint32_t block);
+    bool get_block_range(uint32_t block, uint64_t *start, uint64_t *end);
+    cache_slot_t *get_block(uint32_t block, const cache_slot_t *pinned);
+    bool load_block(uint32_t block, cache_slot_t *slot, uint32_t length);
+};
@@ -24,12 +24,16 @@
 **/
 
 #include "ide_imagefile.h"
+#include <stdio.h>
 #include <strings.h>
 #include "ZuluIDE.h"
 #include "ZuluIDE_config.h"
 #include <assert.h>
+#include <ctype.h>
 #include <algorithm>
 
+extern "C" unsigned long micros();
+
 // SD card callbacks from platform code use global state
 IDEImageFile::sd_cb_state_t IDEImageFile::sd_cb_state;
 
@@ -59,6 +63,20 @@ bool IDEImageFile::open_file(const char *filename, bool read_only)
   return open_file(SD.vol(), filename, read_only);
 }
 
+// FNV-1a of the path, case-insensitive like FAT and without the leading slash
+static uint32_t image_path_hash(const char *path)
+{
+    while (*path == '/') path++;
+
+    uint32_t hash = 2166136261u;
+    while (*path)
+    {
+        hash ^= (uint8_t)tolower(*path++);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
 bool IDEImageFile::open_file(FsVolume *volume, const char *filename, bool read_only)
 {
     if (volume->attrib(filename) & FS_ATTRIB_READ_ONLY)
@@ -69,6 +87,11 @@ bool IDEImageFile::open_file(FsVolume *volume, const char *filename, bool read_o
     m_contiguous = false;
     m_capacity = 0;
     m_read_only = read_only;
+    m_path_hash = image_path_hash(filename);
+    memset(&m_write_stats, 0, sizeof(m_write_stats));
+    m_compressed.close();
+    m_sparse.close();
+    close_overlay();
     m_file.close();
     m_folder.close();
 
@@ -95,6 +118,9 @@ bool IDEImageFile::open_file(FsVolume *volume, const char *filename, bool read_o
 // If m_is_folder is false, this is used only for opening the initial image.
 bool IDEImageFile::internal_open(const char *filename, bool quiet)
 {
+    m_compressed.close();
+    m_sparse.close();
+    close_overlay();
     m_file.open(&m_folder, filename, m_read_only ? O_RDONLY : O_RDWR);
 
     if (!m_file.isOpen())
@@ -124,6 +150,15 @@ bool IDEImageFile::internal_open(const char *filename, bool quiet)
     m_capacity = m_file.size();
     if (!quiet) dbgmsg("Image file ", filename, " size ", (int64_t)m_capacity);
 
+    if (m_compressed.open(&m_file, m_buffer, m_buffer_size))
+    {
+        m_capacity = m_compressed.capacity();
+    }
+    else if (m_sparse.open(&m_file))
+    {
+        m_capacity = m_sparse.capacity();
+    }
+
     uint32_t begin = 0, end = 0;
     if (m_file.contiguousRange(&begin, &end))
     {
@@ -144,9 +179,126 @@ bool IDEImageFile::internal_open(const char *filename, bool quiet)
 
 void IDEImageFile::close()
 {
+    m_compressed.close();
+    m_sparse.close();
+    close_overlay();
     m_file.close();
 }
 
+bool IDEImageFile::open_overlay(bool revert)
+{
+    close_overlay();
+
+    if (!m_file.isOpen() || m_is_folder || m_compressed.is_open() || m_sparse.is_open())
+    {
+        logmsg("Copy-on-write overlay is only supported for normal hard drive images");
+        return false;
+    }
+
+    char filename[MAX_FILE_PATH + 1];
+    if (!get_filename(filename, sizeof(filename)))
+    {
+        return false;
+    }
+
+    char name[MAX_FILE_PATH + 1];
+    snprintf(name, sizeof(name), "%s%08lx_%s", OVERLAY_PREFIX, (unsigned long)m_path_hash, filename);
+
+    // Overlays are kept in the root folder, next to the configuration file
+    FsFile root = SD.open("/", O_RDONLY);
+    m_overlay_file.open(&root, name, O_RDWR | O_CREAT);
+    if (!m_overlay_file.isOpen())
+    {
+        logmsg("Failed to open overlay file ", name);
+        return false;
+    }
+
+    uint32_t base_mtime, base_hash;
+    get_overlay_base_id(filename, &base_mtime, &base_hash);
+
+    bool valid = !revert && m_overlay.open(&m_overlay_file, true);
+    if (valid && (m_overlay.capacity() != m_capacity ||
+                  m_overlay.base_mtime() != base_mtime || m_overlay.base_hash() != base_hash))
+    {
+        logmsg("Overlay ", name, " was made for a different image, discarding it");
+        valid = false;
+    }
+
+    if (valid)
+    {
+        logmsg("Using overlay ", name, ", ", (int)(((uint64_t)m_overlay.allocated_blocks() * m_overlay.block_size()) / 1024),
+               " kB of changes to the image");
+    }
+    else
+    {
+        // Reverting drops all the blocks by recreating the block table
+        uint32_t start = millis();
+        m_overlay.close();
+        m_overlay_file.close();
+        m_overlay_file.open(&root, name, O_RDWR | O_CREAT | O_TRUNC);
+        if (!m_overlay_file.isOpen() ||
+            !IDESparseImage::create(&m_overlay_file, m_capacity, OVERLAY_BLOCK_SIZE, m_buffer, m_buffer_size,
+                                    base_mtime, base_hash) ||
+            !m_overlay.open(&m_overlay_file, true))
+        {
+            logmsg("Failed to create overlay file ", name);
+            m_overlay_file.close();
+            return false;
+        }
+
+        logmsg("Started empty overlay ", name, " in ", (int)(millis() - start), " ms, image is not modified");
+    }
+
+    memset(&m_overlay_stats, 0, sizeof(m_overlay_stats));
+    return true;
+}
+
+// Modification time from the directory entry and FNV-1a of the first sector of the image
+void IDEImageFile::get_overlay_base_id(const char *filename, uint32_t *mtime, uint32_t *hash)
+{
+    uint16_t date = 0, time = 0;
+    FsFile base;
+    if (base.open(&m_folder, filename, O_RDONLY))
+    {
+        base.getModifyDateTime(&date, &time);
+        base.close();
+    }
+    *mtime = ((uint32_t)date << 16) | time;
+
+    *hash = 2166136261u;
+    size_t len = std::min<uint64_t>(512, std::min<uint64_t>(m_buffer_size, m_capacity));
+    if (m_file.seek(0) && m_file.read(m_buffer, len) == (int)len)
+    {
+        for (size_t i = 0; i < len; i++)
+        {
+            *hash ^= m_buffer[i];
+            *hash *= 16777619u;
+        }
+    }
+}
+
+void IDEImageFile::close_overlay()
+{
+    if (m_overlay.is_open() && m_overlay_stats.write_count > 0)
+    {
+        log_overlay_stats();
+    }
+
+    m_overlay.close();
+    m_overlay_file.close();
+}
+
+void IDEImageFile::log_overlay_stats()
+{
+    // Time spent copying image data into the overlay, compared to writing host data
+    uint64_t total_us = m_overlay_stats.write_us + m_overlay_stats.copy_us;
+    logmsg("Overlay writes: ", (int)m_overlay_stats.write_count, " commands ",
+           (int)(m_overlay_stats.write_bytes / 1024), " kB in ", (int)(m_overlay_stats.write_us / 1000), " ms, ",
+           "copy-on-write ", (int)m_overlay_stats.copy_count, " blocks ",
+           (int)(m_overlay_stats.copy_bytes / 1024), " kB in ", (int)(m_overlay_stats.copy_us / 1000), " ms, ",
+           "overhead ", (int)(total_us ? m_overlay_stats.copy_us * 100 / total_us : 0), "%");
+}
+
 bool IDEImageFile::get_filename(char *buf, size_t buflen)
 {
     if (!m_file.isOpen())
@@ -252,7 +404,13 @@ bool IDEImageFile::is_open()
 
 bool IDEImageFile::writable()
 {
-    return !m_read_only;
+    // Compressed images are read-only, overlay can be used with a read-only image
+    return (!m_read_only || m_overlay.is_open()) && !m_compressed.is_open();
+}
+
+bool IDEImageFile::is_compressed()
+{
+    return m_compressed.is_open();
 }
 
 /******************************/
@@ -260,17 +418,37 @@ bool IDEImageFile::writable()
 /******************************/
 
 bool IDEImageFile::read(uint64_t startpos, size_t blocksize, size_t num_blocks, Callback *callback)
+{
+    if (m_compressed.is_open())
+    {
+        return m_compressed.read(startpos, blocksize, num_blocks, callback);
+    }
+    else if (m_sparse.is_open())
+    {
+        return read_mapped(&m_sparse, startpos, blocksize, num_blocks, callback);
+    }
+    else if (m_overlay.is_open())
+    {
+        return read_mapped(&m_overlay, startpos, blocksize, num_blocks, callback);
+    }
+    else
+    {
+        return read_file(&m_file, startpos, blocksize, num_blocks, callback);
+    }
+}
+
+bool IDEImageFile::read_file(ZuluContainerFs::ZCFsFile *file, uint64_t startpos, size_t blocksize, size_t num_blocks, Callback *callback)
 {
     dbgmsg("IDEImageFile::read: startpos=", (int64_t)startpos, " blocksize=", (int)blocksize,
            " num_blocks=", (int)num_blocks, " contiguous=", (int)m_contiguous);
 
-    if (!m_file.seek(startpos))
+    if (!file->seek(startpos))
     {
         logmsg("IDEImageFile::read: seek failed to position ", (int64_t)startpos);
         return false;
     }
 
-    uint64_t actual_pos = m_file.position();
+    uint64_t actual_pos = file->position();
     if (actual_pos != startpos)
     {
         logmsg("IDEImageFile::read: seek mismatch! requested=", (int64_t)startpos,
@@ -311,7 +489,7 @@ bool IDEImageFile::read(uint64_t startpos, size_t blocksize, size_t num_blocks,
             // Read from SD card and process callbacks
             uint8_t *buf = m_buffer + blocksize * start_idx;
             platform_set_sd_callback(&IDEImageFile::sd_read_callback, buf);
-            int status = m_file.read(buf, blocksize * max_read);
+            int status = file->read(buf, blocksize * max_read);
             platform_set_sd_callback(nullptr, nullptr);
 
             // Check status of SD card read
@@ -384,7 +562,48 @@ void IDEImageFile::sd_read_callback(uint32_t bytes_complete)
 // For now this uses simple blocking access, because we don't need CD-ROM write yet.
 bool IDEImageFile::write(uint64_t startpos, size_t blocksize, size_t num_blocks, Callback *callback)
 {
-    if (!m_file.seek(startpos)) return false;
+    if (m_compressed.is_open())
+    {
+        return false;
+    }
+    else if (m_sparse.is_open())
+    {
+        return write_mapped(&m_sparse, startpos, blocksize, num_blocks, callback);
+    }
+    else if (m_overlay.is_open())
+    {
+        return write_mapped(&m_overlay, startpos, blocksize, num_blocks, callback);
+    }
+    else
+    {
+        uint32_t start = micros();
+        bool status = write_file(&m_file, startpos, blocksize, num_blocks, callback);
+
+        m_write_stats.count++;
+        m_write_stats.bytes += blocksize * num_blocks;
+        m_write_stats.us += (uint32_t)(micros() - start);
+        if (m_write_stats.bytes >= WRITE_STATS_INTERVAL_KB * 1024)
+        {
+            log_write_stats();
+        }
+
+        return status;
+    }
+}
+
+// Throughput of host writes, including the time spent receiving data from the IDE bus
+void IDEImageFile::log_write_stats()
+{
+    uint32_t kb = (uint32_t)(m_write_stats.bytes / 1024);
+    uint32_t ms = (uint32_t)(m_write_stats.us / 1000);
+    dbgmsg("Image writes: ", (int)m_write_stats.count, " commands ", (int)kb, " kB in ", (int)ms, " ms, ",
+           (int)(ms ? (uint64_t)kb * 1000 / ms : 0), " kB/s", m_contiguous ? "" : ", image not contiguous");
+    memset(&m_write_stats, 0, sizeof(m_write_stats));
+}
+
+bool IDEImageFile::write_file(ZuluContainerFs::ZCFsFile *file, uint64_t startpos, size_t blocksize, size_t num_blocks, Callback *callback)
+{
+    if (!file->seek(startpos)) return false;
 
     assert(blocksize <= m_buffer_size);
 
@@ -417,7 +636,7 @@ bool IDEImageFile::write(uint64_t startpos, size_t blocksize, size_t num_blocks,
             // Write data to SD card and process callbacks
             uint8_t *buf = m_buffer + blocksize * start_idx;
             platform_set_sd_callback(&IDEImageFile::sd_write_callback, buf);
-            int status = m_file.write(buf, blocksize * max_write);
+            int status = file->write(buf, blocksize * max_write);
             platform_set_sd_callback(nullptr, nullptr);
 
             // Check status of SD card write
@@ -468,3 +687,138 @@ void IDEImageFile::sd_write_callback(uint32_t bytes_complete)
         }
     }
 }
+
+/**************************************/
+/* Sparse image and overlay transfers */
+/**************************************/
+
+bool IDEImageFile::read_mapped(IDESparseImage *map, uint64_t startpos, size_t blocksize, size_t num_blocks, Callback *callback)
+{
+    ZuluContainerFs::ZCFsFile *file = (map == &m_overlay) ? &m_overlay_file : &m_file;
+    uint32_t map_block = map->block_size();
+    if (map_block % blocksize != 0)
+    {
+        logmsg("IDEImageFile::read_mapped: block size ", (int)blocksize, " not supported");
+        return false;
+    }
+
+    while (num_blocks > 0)
+    {
+        uint64_t file_pos;
+        if (!map->lookup(startpos, &file_pos)) return false;
+
+        // Combine following blocks that are also unallocated or stored right after this one
+        size_t count = std::min<size_t>(num_blocks, (map_block - startpos % map_block) / blocksize);
+        while (count < num_blocks)
+        {
+            uint64_t next_pos;
+            if (!map->lookup(startpos + count * blocksize, &next_pos)) return false;
+            if (file_pos == 0 ? next_pos != 0 : next_pos != file_pos + count * blocksize) break;
+            count = std::min<size_t>(num_blocks, count + map_block / blocksize);
+        }
+
+        // Unallocated blocks of a sparse image read as zeros without accessing the SD card,
+        // those of an overlay come from the unmodified image.
+        bool status;
+        if (file_pos != 0)
+            status = read_file(file, file_pos, blocksize, count, callback);
+        else if (map == &m_overlay)
+            status = read_file(&m_file, startpos, blocksize, count, callback);
+        else
+            status = read_zeros(blocksize, count, callback);
+
+        if (!status) return false;
+
+        startpos += count * blocksize;
+        num_blocks -= count;
+    }
+
+    return true;
+}
+
+bool IDEImageFile::write_mapped(IDESparseImage *map, uint64_t startpos, size_t blocksize, size_t num_blocks, Callback *callback)
+{
+    bool overlay = (map == &m_overlay);
+    ZuluContainerFs::ZCFsFile *file = overlay ? &m_overlay_file : &m_file;
+    uint32_t map_block = map->block_size();
+    if (map_block % blocksize != 0)
+    {
+        logmsg("IDEImageFile::write_mapped: block size ", (int)blocksize, " not supported");
+        return false;
+    }
+
+    while (num_blocks > 0)
+    {
+        uint64_t file_pos;
+        if (!map->lookup(startpos, &file_pos)) return false;
+
+        uint32_t offset = startpos % map_block;
+        size_t count = std::min<size_t>(num_blocks, (map_block - offset) / blocksize);
+        bool allocated = false;
+        if (file_pos == 0)
+        {
+            // Block written for the first time. It only needs to be cleared or
+            // copied from the image if the host does not overwrite all of it.
+            bool whole_block = (offset == 0 && count * blocksize == map_block);
+            if (!map->allocate(startpos, !whole_block && !overlay, m_buffer, m_buffer_size, &file_pos)) return false;
+            if (!whole_block && overlay && !copy_to_overlay(startpos - offset, file_pos - offset)) return false;
+            allocated = true;
+        }
+        else
+        {
+            // Combine following blocks that are stored right after this one
+            while (count < num_blocks)
+            {
+                uint64_t next_pos;
+                if (!map->lookup(startpos + count * blocksize, &next_pos)) return false;
+                if (next_pos == 0 || next_pos != file_pos + count * blocksize) break;
+                count = std::min<size_t>(num_blocks, count + map_block / blocksize);
+            }
+        }
+
+        uint32_t start = micros();
+        if (!write_file(file, file_pos, blocksize, count, callback)) return false;
+
+        // Block table is updated only after the data is in place
+        if (allocated && !map->commit(startpos, file_pos)) return false;
+
+        if (overlay)
+        {
+            m_overlay_stats.write_count++;
+            m_overlay_stats.write_bytes += count * blocksize;
+            m_overlay_stats.write_us += (uint32_t)(micros() - start);
+        }
+
+        startpos += count * blocksize;
+        num_blocks -= count;
+    }
+
+    return true;
+}
+
+bool IDEImageFile::copy_to_overlay(uint64_t pos, uint64_t file_pos)
+{
+    uint32_t start = micros();
+    uint64_t end = std::min<uint64_t>(pos + m_overlay.block_size(), m_capacity);
+    if (!m_overlay_file.seek(file_pos)) return false;
+
+    while (pos < end)
+    {
+        size_t len = std::min<uint64_t>(m_buffer_size, end - pos);
+        if (!m_file.seek(pos) || m_file.read(m_buffer, len) != (int)len ||
+            m_overlay_file.write(m_buffer, len) != len)
+        {
+            logmsg("Overlay copy-on-write failed at image position ", (int64_t)pos);
+            return false;
+        }
+        m_overlay_stats.copy_bytes += len;
+        pos += len;
+    }
+
+    m_overlay_stats.copy_us += (uint32_t)(micros() - start);
+    if (++m_overlay_stats.copy_count % OVERLAY_STATS_INTERVAL == 0)
+    {
+        log_overlay_stats();
+    }
+    return true;
+}
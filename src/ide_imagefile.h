@@ -64,6 +64,9 @@ public:
     // Is the image file writable?
     virtual bool writable() = 0;
 
+    // Is the data stored block compressed? Direct file access then sees the compressed data.
+    virtual bool is_compressed() = 0;
+
     // Are there multiple image files we can switch between?
     // Currently used for .cue / .bin sets.
     virtual bool is_folder() = 0;
@@ -106,6 +109,9 @@ public:
 
 };
 
+#include "ide_compressed.h"
+#include "ide_sparse.h"
+
 // Implementation for SD-card based image files
 class IDEImageFile: public IDEImage
 {
@@ -122,12 +128,20 @@ public:
     bool open_file(const char* filename, bool read_only = false);
     void close();
 
+    // Redirect writes to a copy-on-write overlay file, leaving the image itself unmodified.
+    // If revert is true or the overlay does not match the image, it is started empty.
+    // The overlay records the size, modification time and first sector hash of the image,
+    // so an image replaced with another of the same size does not reuse it.
+    bool open_overlay(bool revert);
+    bool has_overlay() { return m_overlay.is_open(); }
+
     virtual bool get_filename(char *buf, size_t buflen) override;
     virtual bool get_image_name(char *buf, size_t buflen) override;
     virtual uint64_t capacity() override;
     virtual uint64_t file_position();
     virtual bool is_open();
     virtual bool writable() override;
+    virtual bool is_compressed() override;
     virtual bool read(uint64_t startpos, size_t blocksize, size_t num_blocks, Callback *callback) override;
     virtual bool read_zeros(size_t blocksize, size_t num_blocks, Callback *callback) override;
     virtual bool write(uint64_t startpos, size_t blocksize, size_t num_blocks, Callback *callback) override;
@@ -174,8 +188,53 @@ protected:
     char m_prefix[5];
     drive_type_t m_drive_type;
 
+    // Set up when the opened file is a block compressed image
+    IDECompressedImage m_compressed;
+
+    // Set up when the opened file is a sparse image
+    IDESparseImage m_sparse;
+
+    // Set up when writes go to a copy-on-write overlay
+    ZuluContainerFs::ZCFsFile m_overlay_file;
+    IDESparseImage m_overlay;
+
+    // Hash of the image path, keeps overlays of same named images apart
+    uint32_t m_path_hash;
+
+    struct {
+        uint32_t write_count;
+        uint64_t write_bytes;
+        uint64_t write_us;
+        uint32_t copy_count;
+        uint64_t copy_bytes;
+        uint64_t copy_us;
+    } m_overlay_stats;
+
+    struct {
+        uint32_t count;
+        uint64_t bytes;
+        uint64_t us;
+    } m_write_stats;
+
     bool internal_open(const char *filename, bool quiet = false);
 
+    // Transfers at a position in the given file
+    bool read_file(ZuluContainerFs::ZCFsFile *file, uint64_t startpos, size_t blocksize, size_t num_blocks, Callback *callback);
+    bool write_file(ZuluContainerFs::ZCFsFile *file, uint64_t startpos, size_t blocksize, size_t num_blocks, Callback *callback);
+
+    // Transfers split at sparse image or overlay block boundaries.
+    // Unallocated blocks of the sparse image read as zeros and those of the overlay
+    // are read from the image file.
+    bool read_mapped(IDESparseImage *map, uint64_t startpos, size_t blocksize, size_t num_blocks, Callback *callback);
+    bool write_mapped(IDESparseImage *map, uint64_t startpos, size_t blocksize, size_t num_blocks, Callback *callback);
+
+    // Copy the image data of a newly allocated overlay block
+    bool copy_to_overlay(uint64_t pos, uint64_t file_pos);
+    void get_overlay_base_id(const char *filename, uint32_t *mtime, uint32_t *hash);
+    void close_overlay();
+    void log_overlay_stats();
+    void log_write_stats();
+
     struct sd_cb_state_t {
         IDEImage::Callback *callback;
         bool error;
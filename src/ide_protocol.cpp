@@ -62,9 +62,11 @@ static uint32_t g_last_reset_time;
 static bool g_drive1_detected;
 uint8_t g_ide_signals;
 static uint32_t g_last_event_time;
+static uint32_t g_last_bus_activity;
 static ide_event_t g_last_event;
 static ide_registers_t g_prev_ide_regs;
 static bool g_ide_reset_after_init_done;
+static bool g_ide_early_init_done;
 
 bool g_ignore_cmd_interrupt;
 
@@ -128,6 +130,27 @@ const ide_phy_config_t *ide_protocol_get_config()
     return &g_ide_config;
 }
 
+uint32_t ide_protocol_idle_time()
+{
+    return millis() - g_last_bus_activity;
+}
+
+void ide_protocol_early_init(int device_id)
+{
+    ide_phy_config_t config = {};
+    config.enable_dev0 = (device_id == 0);
+    config.enable_dev1 = (device_id == 1);
+    ide_phy_config(&config);
+
+    // Devices clear BSY when they handle the reset event after ide_protocol_init()
+    ide_registers_t regs = {};
+    regs.status = IDE_STATUS_BSY;
+    ide_phy_set_regs(&regs);
+
+    g_ide_early_init_done = true;
+    dbgmsg("-- IDE PHY enabled early as ", device_id == 0 ? "primary" : "secondary", " drive, reporting busy");
+}
+
 void ide_protocol_init(IDEDevice *primary, IDEDevice *secondary)
 {
     g_ide_devices[0] = primary;
@@ -137,6 +160,14 @@ void ide_protocol_init(IDEDevice *primary, IDEDevice *secondary)
     if (secondary) secondary->initialize(1);
 
     do_phy_config();
+
+    if (g_ide_early_init_done)
+    {
+        // Drop anything the host did while the drive was reporting busy,
+        // the reset event below brings the devices to a known state.
+        ide_phy_reset();
+        g_ide_early_init_done = false;
+    }
     g_ide_reset_after_init_done = false;
 }
 
@@ -178,6 +209,7 @@ void ide_protocol_poll()
                 regs.device &= ~IDE_DEVICE_DEV;
                 ide_phy_set_regs(&regs);
                 g_last_event_time = millis();
+                g_last_bus_activity = g_last_event_time;
                 g_last_event = IDE_EVENT_CMD_EXE_DEV_DIAG;
 
                 if (g_ide_config.enable_dev0)
@@ -312,6 +344,7 @@ void ide_protocol_poll()
 
         LED_OFF();
         g_last_event_time = millis();
+        g_last_bus_activity = g_last_event_time;
         g_last_event = evt;
     }
     else if ((millis() - g_last_event_time) > 10)
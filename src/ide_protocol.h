@@ -145,6 +145,10 @@ protected:
     void set_ident_strings(const char* default_model, const char* default_serial, const char* default_revision);
 };
 
+// Bring up the PHY before the devices are configured, so that the host
+// sees a busy drive instead of an empty bus during the rest of startup.
+void ide_protocol_early_init(int device_id);
+
 // Initialize the protocol layer with devices
 void ide_protocol_init(IDEDevice *primary, IDEDevice *secondary);
 
@@ -154,3 +158,6 @@ const ide_phy_config_t *ide_protocol_get_config();
 // Call this periodically to process events
 void ide_protocol_poll();
 
+// Milliseconds since the last event was received from the IDE bus
+uint32_t ide_protocol_idle_time();
+
@@ -76,6 +76,10 @@ void IDERigidDevice::initialize(int devidx)
     memset(&m_ata_state, 0, sizeof(m_ata_state));
     memset(&m_removable, 0, sizeof(m_removable));
     m_devinfo.bytes_per_sector = 512;
+
+    m_overlay.enabled = ini_getbool("IDE", "overlay", false, CONFIGFILE);
+    m_overlay.revert = ini_getbool("IDE", "overlay_revert", false, CONFIGFILE);
+    m_overlay.revert_pending = m_overlay.revert;
 }
 
 void IDERigidDevice::print_device_config()
@@ -83,11 +87,18 @@ void IDERigidDevice::print_device_config()
     char imgfile[MAX_FILE_PATH + 1];
     if (!m_image || !m_image->get_image_name(imgfile, sizeof(imgfile))) strcpy(imgfile, "not loaded");
     logmsg("-- ATA hard drive, image ", imgfile);
+    if (m_image && ((IDEImageFile*)m_image)->has_overlay())
+    {
+        logmsg("-- Writes go to copy-on-write overlay", m_overlay.revert ? ", discarded at boot" : "");
+    }
     IDEDevice::print_device_config();
 }
 
 void IDERigidDevice::post_image_setup()
 {
+    // Dual drive images are set before initialize() has read the settings
+    open_overlay();
+
     IDEDevice::post_image_setup();
 
     uint64_t cap = capacity();
@@ -178,11 +189,26 @@ void IDERigidDevice::set_image(IDEImage *image)
     }
 
     m_image = image;
+    m_overlay.open_pending = true;
+    open_overlay();
 }
 
 void IDERigidDevice::insert_media(IDEImage *image)
 {
     m_image = image;
+    m_overlay.open_pending = true;
+    open_overlay();
+}
+
+void IDERigidDevice::open_overlay()
+{
+    // Opening an image file closes its overlay, so it is opened again for every image
+    if (m_overlay.enabled && m_overlay.open_pending && m_image)
+    {
+        ((IDEImageFile*)m_image)->open_overlay(m_overlay.revert_pending);
+        m_overlay.revert_pending = false;
+        m_overlay.open_pending = false;
+    }
 }
 
 
@@ -130,6 +130,18 @@ protected:
         bool reinsert_media_after_eject;
     } m_removable;
 
+    // Copy-on-write overlay settings and state
+    struct
+    {
+        bool enabled;
+        bool revert;
+        bool revert_pending; // Only the first image after boot is reverted
+        bool open_pending;   // Image set but its overlay not opened yet
+    } m_overlay;
+
+    // Open the overlay of every image set on the device, including runtime image changes
+    void open_overlay();
+
     // Track current read LBA for debugging
     uint32_t m_current_read_lba = 0xFFFFFFFF;
 
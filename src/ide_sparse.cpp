@@ -0,0 +1,234 @@
+/**
+ * ZuluIDE™ - Copyright (c) 2026 Rabbit Hole Computing™
+ *
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version.
+ *
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional
+ * permissions described in the ZuluIDE Hardware Support Library Exception
+ * (GPL-3.0_HSL_Exception.md), as published by Rabbit Hole Computing™.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+#include "ide_imagefile.h"
+#include "ZuluIDE_log.h"
+#include <string.h>
+#include <algorithm>
+
+IDESparseImage::IDESparseImage():
+    m_file(nullptr), m_block_size(0), m_block_count(0), m_table_offset(0),
+    m_data_offset(0), m_image_size(0), m_base_mtime(0), m_base_hash(0),
+    m_table_first(0), m_table_count(0), m_allocated(0)
+{
+}
+
+void IDESparseImage::init_header(ide_sparse_header_t *header, uint64_t image_size, uint32_t block_size)
+{
+    memset(header, 0, sizeof(*header));
+    memcpy(header->magic, IDE_SPARSE_MAGIC, sizeof(header->magic));
+    header->header_size = 512;
+    header->block_size = block_size;
+    header->image_size = image_size;
+    header->block_count = (image_size + block_size - 1) / block_size;
+
+    // Data area starts at the next sector boundary after the table
+    uint64_t table_end = header->header_size + (uint64_t)header->block_count * sizeof(uint32_t);
+    header->data_offset = (table_end + 511) & ~(uint64_t)511;
+}
+
+bool IDESparseImage::create(ZuluContainerFs::ZCFsFile *file, uint64_t image_size, uint32_t block_size,
+                            uint8_t *buffer, size_t buffer_size,
+                            uint32_t base_mtime, uint32_t base_hash)
+{
+    ide_sparse_header_t header;
+    init_header(&header, image_size, block_size);
+    header.base_mtime = base_mtime;
+    header.base_hash = base_hash;
+
+    // Header sector followed by the zeroed block table
+    memset(buffer, 0, buffer_size);
+    memcpy(buffer, &header, sizeof(header));
+    if (!file->seek(0)) return false;
+
+    uint64_t pos = 0;
+    while (pos < header.data_offset)
+    {
+        size_t len = std::min<uint64_t>(buffer_size, header.data_offset - pos);
+        if (file->write(buffer, len) != len)
+        {
+            logmsg("Sparse image creation failed at ", (int64_t)pos);
+            return false;
+        }
+        if (pos == 0) memset(buffer, 0, sizeof(header));
+        pos += len;
+    }
+
+    file->flush();
+    return true;
+}
+
+bool IDESparseImage::open(ZuluContainerFs::ZCFsFile *file, bool quiet)
+{
+    close();
+
+    ide_sparse_header_t header;
+    if (file->size() < sizeof(header) || !file->seek(0) ||
+        file->read(&header, sizeof(header)) != sizeof(header) ||
+        memcmp(header.magic, IDE_SPARSE_MAGIC, sizeof(header.magic)) != 0)
+    {
+        file->seek(0);
+        return false;
+    }
+
+    uint32_t block_size = header.block_size;
+    if (block_size < IDE_SPARSE_MIN_BLOCK_SIZE || block_size > IDE_SPARSE_MAX_BLOCK_SIZE ||
+        (block_size & (block_size - 1)) != 0 ||
+        header.block_count != (header.image_size + block_size - 1) / block_size ||
+        header.header_size < sizeof(header) ||
+        header.data_offset < header.header_size + (uint64_t)header.block_count * sizeof(uint32_t) ||
+        file->size() < header.data_offset)
+    {
+        logmsg("Sparse image has invalid header, block size ", (int)block_size,
+               " block count ", (int)header.block_count);
+        return false;
+    }
+
+    m_file = file;
+    m_block_size = block_size;
+    m_block_count = header.block_count;
+    m_table_offset = header.header_size;
+    m_data_offset = header.data_offset;
+    m_image_size = header.image_size;
+    m_base_mtime = header.base_mtime;
+    m_base_hash = header.base_hash;
+    m_table_first = 0;
+    m_table_count = 0;
+
+    // A block left partially written by an interrupted allocation is skipped
+    m_allocated = (file->size() - m_data_offset + block_size - 1) / block_size;
+
+    if (!quiet)
+    {
+        logmsg("Image is sparse, ", (int)(m_image_size / 1048576), " MB with ",
+               (int)(((uint64_t)m_allocated * m_block_size) / 1048576), " MB allocated in blocks of ",
+               (int)(m_block_size / 1024), " kB");
+    }
+    return true;
+}
+
+void IDESparseImage::close()
+{
+    m_file = nullptr;
+    m_image_size = 0;
+}
+
+bool IDESparseImage::lookup(uint64_t pos, uint64_t *file_pos)
+{
+    uint32_t block = pos / m_block_size;
+    if (block >= m_block_count) return false;
+
+    if (block < m_table_first || block >= m_table_first + m_table_count)
+    {
+        uint32_t count = std::min<uint32_t>(TABLE_WINDOW, m_block_count - block);
+        if (!m_file->seek(m_table_offset + (uint64_t)block * sizeof(uint32_t)) ||
+            m_file->read(m_table, count * sizeof(uint32_t)) != count * sizeof(uint32_t))
+        {
+            logmsg("Sparse image block table read failed for block ", (int)block);
+            m_table_count = 0;
+            return false;
+        }
+
+        m_table_first = block;
+        m_table_count = count;
+    }
+
+    uint32_t entry = m_table[block - m_table_first];
+    if (entry == 0)
+    {
+        *file_pos = 0;
+    }
+    else if (entry > m_allocated)
+    {
+        logmsg("Sparse image block table entry ", (int)entry, " beyond end of file for block ", (int)block);
+        return false;
+    }
+    else
+    {
+        *file_pos = m_data_offset + (uint64_t)(entry - 1) * m_block_size + pos % m_block_size;
+    }
+
+    return true;
+}
+
+// Write zeros from the current end of file up to the given position
+bool IDESparseImage::extend_to(uint64_t end, uint8_t *buffer, size_t buffer_size)
+{
+    uint64_t size = m_file->size();
+    if (size >= end) return true;
+    if (!m_file->seek(size)) return false;
+
+    memset(buffer, 0, buffer_size);
+    while (size < end)
+    {
+        size_t len = std::min<uint64_t>(buffer_size, end - size);
+        if (m_file->write(buffer, len) != len)
+        {
+            logmsg("Sparse image extending file failed at ", (int64_t)size);
+            return false;
+        }
+        size += len;
+    }
+
+    return true;
+}
+
+bool IDESparseImage::allocate(uint64_t pos, bool zero_fill, uint8_t *buffer, size_t buffer_size, uint64_t *file_pos)
+{
+    uint64_t block_start = m_data_offset + (uint64_t)m_allocated * m_block_size;
+    uint64_t end = zero_fill ? block_start + m_block_size : block_start;
+    if (!extend_to(end, buffer, buffer_size))
+    {
+        return false;
+    }
+
+    dbgmsg("Sparse image allocating block ", (int)(pos / m_block_size), " at file offset ", (int64_t)block_start);
+    m_allocated++;
+    *file_pos = block_start + pos % m_block_size;
+    return true;
+}
+
+bool IDESparseImage::commit(uint64_t pos, uint64_t file_pos)
+{
+    uint32_t block = pos / m_block_size;
+    uint32_t entry = (file_pos - m_data_offset) / m_block_size + 1;
+
+    if (!m_file->seek(m_table_offset + (uint64_t)block * sizeof(uint32_t)) ||
+        m_file->write(&entry, sizeof(entry)) != sizeof(entry))
+    {
+        logmsg("Sparse image block table write failed for block ", (int)block);
+        return false;
+    }
+
+    if (block >= m_table_first && block < m_table_first + m_table_count)
+    {
+        m_table[block - m_table_first] = entry;
+    }
+
+    // Update file size and table on the card right away, so that a power
+    // loss cannot leave the table pointing past the end of the file.
+    m_file->flush();
+    return true;
+}
@@ -0,0 +1,125 @@
+/**
+ * ZuluIDE™ - Copyright (c) 2026 Rabbit Hole Computing™
+ *
+ * ZuluIDE™ firmware is licensed under the GPL version 3 or any later version.
+ *
+ * https://www.gnu.org/licenses/gpl-3.0.html
+ * ----
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * Under Section 7 of GPL version 3, you are granted additional
+ * permissions described in the ZuluIDE Hardware Support Library Exception
+ * (GPL-3.0_HSL_Exception.md), as published by Rabbit Hole Computing™.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+**/
+
+// Thin provisioned sparse image format for hard drive images.
+//
+// File layout (all values little endian):
+//   0:            ide_sparse_header_t
+//   header_size:  block allocation table, block_count uint32_t entries.
+//                 Entry 0 means the block has not been written and reads as zeros,
+//                 otherwise block i is stored at data_offset + (entry - 1) * block_size.
+//   data_offset:  allocated blocks in the order they were first written.
+//
+// Blocks are appended to the end of the file on first write, so the file only
+// takes as much SD card space as the host has actually written.
+//
+// The same format is used for copy-on-write overlays of hard drive images,
+// in which case unallocated blocks are read from the base image instead.
+//
+// This is used through IDEImageFile, which includes this header after
+// the IDEImage interface definition.
+
+#pragma once
+#include <stdint.h>
+#include <stddef.h>
+#include <ZCFsFile.h>
+
+#define IDE_SPARSE_MAGIC "ZIDESPR1"
+#define IDE_SPARSE_MIN_BLOCK_SIZE 4096
+#define IDE_SPARSE_MAX_BLOCK_SIZE (16 * 1024 * 1024)
+
+struct ide_sparse_header_t
+{
+    char magic[8];
+    uint32_t header_size;
+    uint32_t block_size;
+    uint64_t image_size;
+    uint32_t block_count;
+    uint32_t flags;
+    uint64_t data_offset;
+    // Identifies the base image of an overlay, 0 for sparse images
+    uint32_t base_mtime;
+    uint32_t base_hash;
+    uint8_t reserved[16];
+};
+
+class IDESparseImage
+{
+public:
+    IDESparseImage();
+
+    // Fill in header for a new, empty sparse image
+    static void init_header(ide_sparse_header_t *header, uint64_t image_size, uint32_t block_size);
+
+    // Write the header and an empty block table to the start of an empty file
+    static bool create(ZuluContainerFs::ZCFsFile *file, uint64_t image_size, uint32_t block_size,
+                       uint8_t *buffer, size_t buffer_size,
+                       uint32_t base_mtime = 0, uint32_t base_hash = 0);
+
+    // Check the file for the sparse image header, returns false for normal images
+    bool open(ZuluContainerFs::ZCFsFile *file, bool quiet = false);
+    void close();
+    bool is_open() { return m_file != nullptr; }
+
+    uint64_t capacity() { return m_image_size; }
+    uint32_t block_size() { return m_block_size; }
+    uint32_t allocated_blocks() { return m_allocated; }
+    uint32_t base_mtime() { return m_base_mtime; }
+    uint32_t base_hash() { return m_base_hash; }
+
+    // Get the file position of the image position, 0 if the block is not allocated
+    bool lookup(uint64_t pos, uint64_t *file_pos);
+
+    // Allocate the block containing pos at the end of the file.
+    // If the whole block will be overwritten, zero_fill can be false and the
+    // caller must write the block before calling commit().
+    // The buffer is used for writing zeros.
+    bool allocate(uint64_t pos, bool zero_fill, uint8_t *buffer, size_t buffer_size, uint64_t *file_pos);
+
+    // Store the allocation in the block table
+    bool commit(uint64_t pos, uint64_t file_pos);
+
+protected:
+    ZuluContainerFs::ZCFsFile *m_file;
+
+    uint32_t m_block_size;
+    uint32_t m_block_count;
+    uint32_t m_table_offset;
+    uint64_t m_data_offset;
+    uint64_t m_image_size;
+    uint32_t m_base_mtime;
+    uint32_t m_base_hash;
+
+    // Window of the block allocation table, loaded on demand
+    static constexpr uint32_t TABLE_WINDOW = 128;
+    uint32_t m_table[TABLE_WINDOW];
+    uint32_t m_table_first;
+    uint32_t m_table_count;
+
+    // Number of blocks in use in the file
+    uint32_t m_allocated;
+
+    bool extend_to(uint64_t end, uint8_t *buffer, size_t buffer_size);
+};
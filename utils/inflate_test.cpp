@@ -0,0 +1,299 @@
+// Host test and benchmark for the deflate decompressor in src/ZuluIDE_inflate.cpp.
+// Build with: g++ -Wall -O2 -I../src -o inflate_test inflate_test.cpp ../src/ZuluIDE_inflate.cpp -lz
+// Adding -fsanitize=address,undefined also checks memory accesses on corrupted input.
+//
+// Usage:
+//   inflate_test
+//       Compress generated data with zlib in all block types and strategies and
+//       decompress it the way the firmware does: in one piece as for compressed
+//       image blocks, and in page sized pieces with a 32 kB window and a read
+//       callback as for firmware packages. Then check that corrupted and
+//       truncated streams are rejected without overruns, and measure speed.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <vector>
+#include <zlib.h>
+#include "ZuluIDE_inflate.h"
+
+#define DICT_SIZE 32768
+#define INBUF_SIZE 512
+#define BENCH_SIZE (4 * 1024 * 1024)
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static uint32_t g_seed = 1;
+static uint32_t rnd()
+{
+    g_seed = g_seed * 1103515245 + 12345;
+    return g_seed >> 8;
+}
+
+// Data types with different match and literal statistics
+static std::vector<uint8_t> make_data(int type, size_t size)
+{
+    static const char *const words[] = {"ZuluIDE ", "firmware ", "sector ", "image ", "the ", "of ",
+                                        "CD-ROM ", "\n", "0x1F ", "bus ", "write ", "read "};
+    std::vector<uint8_t> data(size);
+    size_t pos = 0;
+    while (pos < size)
+    {
+        if (type == 0)
+        {
+            data[pos++] = 0;
+        }
+        else if (type == 1)
+        {
+            data[pos++] = rnd();
+        }
+        else if (type == 2)
+        {
+            const char *w = words[rnd() % 12];
+            while (*w && pos < size) data[pos++] = *w++;
+        }
+        else
+        {
+            // Runs, random bytes and repeats from far back, like firmware code and tables
+            uint32_t kind = rnd() % 4;
+            uint32_t len = rnd() % 300 + 1;
+            for (uint32_t i = 0; i < len && pos < size; i++, pos++)
+            {
+                if (kind == 0) data[pos] = 0xFF;
+                else if (kind == 1) data[pos] = rnd() & 0x0F;
+                else if (kind == 2 && pos > 30000) data[pos] = data[pos - 30000];
+                else data[pos] = rnd();
+            }
+        }
+    }
+    return data;
+}
+
+static std::vector<uint8_t> deflate_raw(const std::vector<uint8_t> &in, int level, int strategy, bool flushes)
+{
+    z_stream s;
+    memset(&s, 0, sizeof(s));
+    deflateInit2(&s, level, Z_DEFLATED, -15, 9, strategy);
+    std::vector<uint8_t> out(deflateBound(&s, in.size()) + 1024);
+    s.next_out = out.data();
+    s.avail_out = out.size();
+
+    // Full flushes add empty stored blocks and restart matching
+    size_t step = flushes ? 10007 : in.size();
+    size_t pos = 0;
+    do
+    {
+        size_t len = std::min(step, in.size() - pos);
+        s.next_in = (uint8_t*)in.data() + pos;
+        s.avail_in = len;
+        pos += len;
+        deflate(&s, pos < in.size() ? Z_FULL_FLUSH : Z_FINISH);
+    } while (pos < in.size());
+
+    out.resize(s.total_out);
+    deflateEnd(&s);
+    return out;
+}
+
+// Compressed image blocks: whole input and output in memory, no window
+static int decode_whole(const std::vector<uint8_t> &packed, uint8_t *out, size_t out_size, size_t *out_len)
+{
+    static inflate_state_t s;
+    inflate_init(&s, NULL, 0);
+    s.source = packed.data();
+    s.source_limit = packed.data() + packed.size();
+    s.dest_start = s.dest = out;
+    s.dest_limit = out + out_size;
+    int res = inflate_run(&s);
+    *out_len = s.dest - out;
+    return res;
+}
+
+// Firmware packages: input through a read callback, output in chunks with a window
+struct stream_state_t
+{
+    inflate_state_t s;
+    const uint8_t *data;
+    size_t remaining;
+    uint8_t inbuf[INBUF_SIZE];
+};
+
+static int stream_read_cb(inflate_state_t *d)
+{
+    stream_state_t *st = (stream_state_t*)d;
+    if (st->remaining == 0) return -1;
+    size_t len = std::min<size_t>(st->remaining, INBUF_SIZE);
+    memcpy(st->inbuf, st->data, len);
+    st->data += len;
+    st->remaining -= len;
+    d->source = st->inbuf + 1;
+    d->source_limit = st->inbuf + len;
+    return st->inbuf[0];
+}
+
+static int decode_stream(const std::vector<uint8_t> &packed, size_t chunk, std::vector<uint8_t> *result, size_t max_len)
+{
+    static stream_state_t st;
+    static uint8_t dict[DICT_SIZE];
+    std::vector<uint8_t> out(chunk);
+    inflate_init(&st.s, dict, DICT_SIZE);
+    st.data = packed.data();
+    st.remaining = packed.size();
+    st.s.source_read_cb = stream_read_cb;
+    result->clear();
+
+    int res;
+    do
+    {
+        st.s.dest_start = st.s.dest = out.data();
+        st.s.dest_limit = out.data() + chunk;
+        res = inflate_run(&st.s);
+        if (res != INFLATE_OK && res != INFLATE_DONE) return res;
+        result->insert(result->end(), out.data(), st.s.dest);
+    } while (res != INFLATE_DONE && result->size() <= max_len);
+    return res;
+}
+
+static int check_roundtrip(const std::vector<uint8_t> &data, const std::vector<uint8_t> &packed, const char *name)
+{
+    int failures = 0;
+    std::vector<uint8_t> out(data.size() + 16);
+    size_t len;
+    int res = decode_whole(packed, out.data(), out.size(), &len);
+    if (res != INFLATE_DONE || len != data.size() || (len && memcmp(out.data(), data.data(), len) != 0))
+    {
+        printf("%s: whole buffer decode failed, result %d, %zu of %zu bytes\n", name, res, len, data.size());
+        failures++;
+    }
+
+    // Output buffer of exactly the data size, as for compressed image blocks
+    res = decode_whole(packed, out.data(), data.size(), &len);
+    if ((res != INFLATE_DONE && res != INFLATE_OK) || len != data.size() || (len && memcmp(out.data(), data.data(), len) != 0))
+    {
+        printf("%s: exact size decode failed, result %d\n", name, res);
+        failures++;
+    }
+
+    static const size_t chunks[] = {4096, 1000, 1};
+    for (size_t c = 0; c < sizeof(chunks) / sizeof(chunks[0]); c++)
+    {
+        if (chunks[c] == 1 && data.size() > 20000) continue;
+        std::vector<uint8_t> result;
+        res = decode_stream(packed, chunks[c], &result, data.size());
+        if (res != INFLATE_DONE || result != data)
+        {
+            printf("%s: streaming decode in %zu byte chunks failed, result %d\n", name, chunks[c], res);
+            failures++;
+        }
+    }
+    return failures;
+}
+
+// Corrupted streams must fail or produce some output, never overrun buffers
+static int check_corrupted(const std::vector<uint8_t> &data, const std::vector<uint8_t> &packed)
+{
+    int errors = 0;
+    std::vector<uint8_t> out(data.size() + 16);
+    for (int i = 0; i < 300; i++)
+    {
+        std::vector<uint8_t> bad = packed;
+        if (i % 3 == 0)
+        {
+            bad.resize(rnd() % bad.size());
+        }
+        else
+        {
+            for (int j = 0; j < 1 + i % 4; j++) bad[rnd() % bad.size()] ^= 1 << (rnd() % 8);
+        }
+
+        size_t len;
+        if (decode_whole(bad, out.data(), out.size(), &len) == INFLATE_DATA_ERROR) errors++;
+        std::vector<uint8_t> result;
+        decode_stream(bad, 4096, &result, data.size() + 4096);
+    }
+    printf("Corrupted streams: %d of 300 rejected, no crashes\n", errors);
+    return errors > 0 ? 0 : 1;
+}
+
+int main()
+{
+    int failures = 0;
+
+    const char *check_str = "123456789";
+    uint32_t check = ~inflate_crc32(check_str, 9, 0xFFFFFFFF);
+    printf("CRC32 check value: %08X (expected CBF43926)\n", check);
+    if (check != 0xCBF43926) failures++;
+
+    std::vector<uint8_t> crc_data = make_data(1, 100000);
+    if (~inflate_crc32(crc_data.data(), crc_data.size(), 0xFFFFFFFF) != crc32(0, crc_data.data(), crc_data.size()))
+    {
+        printf("CRC32 differs from zlib\n");
+        failures++;
+    }
+
+    static const size_t sizes[] = {0, 1, 258, 4096, 70000, 300000};
+    static const int levels[] = {0, 1, 6, 9};
+    static const int strategies[] = {Z_DEFAULT_STRATEGY, Z_FILTERED, Z_HUFFMAN_ONLY, Z_RLE, Z_FIXED};
+    int cases = 0;
+    for (int type = 0; type < 4; type++)
+    {
+        for (size_t si = 0; si < sizeof(sizes) / sizeof(sizes[0]); si++)
+        {
+            std::vector<uint8_t> data = make_data(type, sizes[si]);
+            for (size_t li = 0; li < sizeof(levels) / sizeof(levels[0]); li++)
+            {
+                for (size_t st = 0; st < sizeof(strategies) / sizeof(strategies[0]); st++)
+                {
+                    for (int flushes = 0; flushes < 2; flushes++)
+                    {
+                        char name[64];
+                        snprintf(name, sizeof(name), "type %d size %zu level %d strategy %d%s",
+                                 type, sizes[si], levels[li], strategies[st], flushes ? " flushed" : "");
+                        failures += check_roundtrip(data, deflate_raw(data, levels[li], strategies[st], flushes), name);
+                        cases++;
+                    }
+                }
+            }
+        }
+    }
+    printf("Round trips: %d cases %s\n", cases, failures ? "FAIL" : "OK");
+
+    std::vector<uint8_t> fuzz_data = make_data(3, 50000);
+    failures += check_corrupted(fuzz_data, deflate_raw(fuzz_data, 9, Z_DEFAULT_STRATEGY, false));
+    failures += check_corrupted(fuzz_data, deflate_raw(fuzz_data, 6, Z_FIXED, true));
+
+    // Speed compared to zlib on firmware-like data
+    std::vector<uint8_t> bench_data = make_data(3, BENCH_SIZE);
+    std::vector<uint8_t> packed = deflate_raw(bench_data, 9, Z_DEFAULT_STRATEGY, false);
+    std::vector<uint8_t> result;
+    double start = now();
+    decode_stream(packed, 4096, &result, BENCH_SIZE);
+    double t_inflate = now() - start;
+    if (result != bench_data) failures++;
+
+    std::vector<uint8_t> out(BENCH_SIZE);
+    z_stream z;
+    memset(&z, 0, sizeof(z));
+    inflateInit2(&z, -15);
+    z.next_in = packed.data();
+    z.avail_in = packed.size();
+    z.next_out = out.data();
+    z.avail_out = out.size();
+    start = now();
+    inflate(&z, Z_FINISH);
+    double t_zlib = now() - start;
+    inflateEnd(&z);
+
+    printf("Decompression of %d kB: %.1f MB/s, zlib %.1f MB/s\n", BENCH_SIZE / 1024,
+           BENCH_SIZE / t_inflate / 1e6, BENCH_SIZE / t_zlib / 1e6);
+
+    printf("%s\n", failures ? "FAILED" : "PASSED");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,394 @@
+// Packer for ZuluIDE block compressed images, see src/ide_compressed.h for the format.
+// Compressed images are read-only on the device.
+// Build with: gcc -Wall -O2 -o zuluide_compress_image zuluide_compress_image.c -lz
+//
+// Usage:
+//   zuluide_compress_image [-b block_size] input.iso output.iso
+//       Compress an image. Keep the original file name prefix and extension
+//       so that the drive type is detected the same way as before.
+//
+//   zuluide_compress_image -t output.iso input.iso
+//       Check that the compressed image decodes to the original in 2048 and
+//       2352 byte sectors and compare sequential and random sector read
+//       throughput of both files.
+
+#define _GNU_SOURCE
+#define _FILE_OFFSET_BITS 64
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#define MAGIC "ZIDECMP1"
+#define HEADER_SIZE 64
+#define MIN_BLOCK_SIZE 4096
+#define MAX_BLOCK_SIZE 32768
+#define DEFAULT_BLOCK_SIZE 16384
+
+// Same as the device default cache size
+#define CACHE_SIZE 32768
+
+// Sector sizes used by -t, 2048 byte data and 2352 byte raw CD-ROM sectors
+#define MAX_SECTOR_SIZE 2352
+#define BENCH_RANDOM_READS 4096
+
+struct header_t
+{
+    char magic[8];
+    uint32_t header_size;
+    uint32_t block_size;
+    uint64_t image_size;
+    uint32_t block_count;
+    uint32_t flags;
+    uint8_t reserved[32];
+};
+
+static double now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static int is_zero(const uint8_t *buf, size_t len)
+{
+    for (size_t i = 0; i < len; i++)
+    {
+        if (buf[i]) return 0;
+    }
+    return 1;
+}
+
+// Compress one block as raw deflate with a window no larger than the block,
+// so that the device can decompress it without a separate dictionary.
+static size_t deflate_block(const uint8_t *in, size_t len, uint8_t *out, size_t out_size, int window_bits)
+{
+    z_stream s;
+    memset(&s, 0, sizeof(s));
+    if (deflateInit2(&s, Z_BEST_COMPRESSION, Z_DEFLATED, -window_bits, 9, Z_DEFAULT_STRATEGY) != Z_OK)
+        return 0;
+
+    s.next_in = (uint8_t*)in;
+    s.avail_in = len;
+    s.next_out = out;
+    s.avail_out = out_size;
+    int status = deflate(&s, Z_FINISH);
+    size_t result = (status == Z_STREAM_END) ? s.total_out : 0;
+    deflateEnd(&s);
+    return result;
+}
+
+static int pack(const char *input, const char *output, uint32_t block_size)
+{
+    FILE *in = fopen(input, "rb");
+    if (!in)
+    {
+        perror(input);
+        return 2;
+    }
+
+    struct stat st;
+    fstat(fileno(in), &st);
+    uint64_t image_size = st.st_size;
+    uint32_t block_count = (image_size + block_size - 1) / block_size;
+
+    FILE *out = fopen(output, "wb");
+    if (!out)
+    {
+        perror(output);
+        return 2;
+    }
+
+    int window_bits = 0;
+    while ((1u << window_bits) < block_size) window_bits++;
+
+    struct header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, 8);
+    header.header_size = HEADER_SIZE;
+    header.block_size = block_size;
+    header.image_size = image_size;
+    header.block_count = block_count;
+
+    uint64_t *index = calloc(block_count + 1, sizeof(uint64_t));
+    uint8_t *block = malloc(block_size);
+    uint8_t *packed = malloc(block_size * 2);
+
+    // Data starts after the header and the index
+    uint64_t pos = HEADER_SIZE + (uint64_t)(block_count + 1) * sizeof(uint64_t);
+    fseeko(out, pos, SEEK_SET);
+
+    uint32_t zero_blocks = 0, stored_blocks = 0;
+    double start = now();
+    for (uint32_t i = 0; i < block_count; i++)
+    {
+        size_t len = fread(block, 1, block_size, in);
+        size_t expected = (i == block_count - 1) ? image_size - (uint64_t)i * block_size : block_size;
+        if (len != expected)
+        {
+            fprintf(stderr, "Read failed at block %u\n", i);
+            return 3;
+        }
+
+        index[i] = pos;
+        if (is_zero(block, len))
+        {
+            zero_blocks++;
+            continue;
+        }
+
+        size_t packed_len = deflate_block(block, len, packed, block_size * 2, window_bits);
+        if (packed_len == 0 || packed_len >= len)
+        {
+            fwrite(block, 1, len, out);
+            pos += len;
+            stored_blocks++;
+        }
+        else
+        {
+            fwrite(packed, 1, packed_len, out);
+            pos += packed_len;
+        }
+    }
+    index[block_count] = pos;
+
+    fseeko(out, 0, SEEK_SET);
+    fwrite(&header, 1, sizeof(header), out);
+    fwrite(index, sizeof(uint64_t), block_count + 1, out);
+
+    if (fclose(out) != 0)
+    {
+        perror(output);
+        return 3;
+    }
+    fclose(in);
+
+    printf("%s: %llu bytes -> %llu bytes (%.1f %%) in %.1f s\n", output,
+        (unsigned long long)image_size, (unsigned long long)pos,
+        image_size ? 100.0 * pos / image_size : 0.0, now() - start);
+    printf("%u blocks of %u bytes, %u zero, %u stored uncompressed\n",
+        block_count, block_size, zero_blocks, stored_blocks);
+    return 0;
+}
+
+// Reader that follows the device implementation: index lookup,
+// raw inflate of single blocks and a small LRU cache.
+struct reader_t
+{
+    int fd;
+    struct header_t header;
+    uint32_t slots;
+    uint8_t *cache;
+    int64_t *cache_block;
+    uint64_t *cache_used;
+    uint64_t counter;
+    uint8_t *packed;
+    uint32_t misses;
+};
+
+static int reader_open(struct reader_t *r, const char *path)
+{
+    memset(r, 0, sizeof(*r));
+    r->fd = open(path, O_RDONLY);
+    if (r->fd < 0 || pread(r->fd, &r->header, sizeof(r->header), 0) != sizeof(r->header) ||
+        memcmp(r->header.magic, MAGIC, 8) != 0)
+    {
+        fprintf(stderr, "%s: not a compressed image\n", path);
+        return 0;
+    }
+
+    uint32_t bs = r->header.block_size;
+    r->slots = CACHE_SIZE / bs;
+    r->cache = malloc(r->slots * bs);
+    r->cache_block = malloc(r->slots * sizeof(int64_t));
+    r->cache_used = calloc(r->slots, sizeof(uint64_t));
+    r->packed = malloc(bs);
+    for (uint32_t i = 0; i < r->slots; i++) r->cache_block[i] = -1;
+    return 1;
+}
+
+static const uint8_t *reader_block(struct reader_t *r, uint32_t block)
+{
+    uint32_t bs = r->header.block_size;
+    uint32_t victim = 0;
+    for (uint32_t i = 0; i < r->slots; i++)
+    {
+        if (r->cache_block[i] == block)
+        {
+            r->cache_used[i] = ++r->counter;
+            return r->cache + i * bs;
+        }
+        if (r->cache_used[i] < r->cache_used[victim]) victim = i;
+    }
+
+    uint64_t range[2];
+    off_t index_pos = r->header.header_size + (off_t)block * sizeof(uint64_t);
+    if (pread(r->fd, range, sizeof(range), index_pos) != sizeof(range)) return NULL;
+
+    uint64_t start = (uint64_t)block * bs;
+    uint32_t len = (r->header.image_size - start < bs) ? r->header.image_size - start : bs;
+    uint32_t stored = range[1] - range[0];
+    uint8_t *dest = r->cache + victim * bs;
+    r->misses++;
+
+    if (stored == 0)
+    {
+        memset(dest, 0, len);
+    }
+    else if (stored == len)
+    {
+        if (pread(r->fd, dest, len, range[0]) != len) return NULL;
+    }
+    else
+    {
+        if (pread(r->fd, r->packed, stored, range[0]) != stored) return NULL;
+        z_stream s;
+        memset(&s, 0, sizeof(s));
+        inflateInit2(&s, -15);
+        s.next_in = r->packed;
+        s.avail_in = stored;
+        s.next_out = dest;
+        s.avail_out = len;
+        int status = inflate(&s, Z_FINISH);
+        inflateEnd(&s);
+        if (status != Z_STREAM_END || s.total_out != len) return NULL;
+    }
+
+    r->cache_block[victim] = block;
+    r->cache_used[victim] = ++r->counter;
+    return dest;
+}
+
+static int reader_read(struct reader_t *r, uint8_t *buf, uint64_t pos, uint32_t len)
+{
+    uint32_t bs = r->header.block_size;
+    while (len > 0)
+    {
+        const uint8_t *data = reader_block(r, pos / bs);
+        if (!data) return 0;
+        uint32_t offset = pos % bs;
+        uint32_t count = (bs - offset < len) ? bs - offset : len;
+        memcpy(buf, data + offset, count);
+        buf += count;
+        pos += count;
+        len -= count;
+    }
+    return 1;
+}
+
+// Compare and benchmark reads of one sector size. Raw CD-ROM sectors of
+// 2352 bytes do not divide the block size, so every block boundary falls
+// inside a sector and exercises the gather path of the device.
+static int test_sector_size(struct reader_t *r, int fd, uint32_t sector_size)
+{
+    uint64_t sectors = r->header.image_size / sector_size;
+    uint8_t a[MAX_SECTOR_SIZE], b[MAX_SECTOR_SIZE];
+
+    // Sequential read and compare
+    double t_raw = 0, t_packed = 0;
+    r->misses = 0;
+    for (uint64_t i = 0; i < sectors; i++)
+    {
+        double t0 = now();
+        if (pread(fd, a, sector_size, i * sector_size) != sector_size) return 3;
+        double t1 = now();
+        if (!reader_read(r, b, i * sector_size, sector_size))
+        {
+            fprintf(stderr, "Decode failed at %u byte sector %llu\n", sector_size, (unsigned long long)i);
+            return 3;
+        }
+        double t2 = now();
+        t_raw += t1 - t0;
+        t_packed += t2 - t1;
+
+        if (memcmp(a, b, sector_size) != 0)
+        {
+            fprintf(stderr, "Data mismatch at %u byte sector %llu\n", sector_size, (unsigned long long)i);
+            return 4;
+        }
+    }
+
+    double mb = sectors * (double)sector_size / 1e6;
+    printf("Contents match, %llu sectors of %u bytes\n", (unsigned long long)sectors, sector_size);
+    printf("bench,%u,sequential,uncompressed_MBps,%.1f,compressed_MBps,%.1f,block_misses,%u\n",
+        sector_size, mb / t_raw, mb / t_packed, r->misses);
+
+    // Random sector reads, the cache helps little here
+    srand(1);
+    r->misses = 0;
+    t_raw = t_packed = 0;
+    for (int i = 0; i < BENCH_RANDOM_READS && sectors > 0; i++)
+    {
+        uint64_t sector = ((uint64_t)rand() * RAND_MAX + rand()) % sectors;
+        double t0 = now();
+        if (pread(fd, a, sector_size, sector * sector_size) != sector_size) return 3;
+        double t1 = now();
+        if (!reader_read(r, b, sector * sector_size, sector_size)) return 3;
+        double t2 = now();
+        t_raw += t1 - t0;
+        t_packed += t2 - t1;
+    }
+
+    mb = BENCH_RANDOM_READS * (double)sector_size / 1e6;
+    printf("bench,%u,random,uncompressed_MBps,%.1f,compressed_MBps,%.1f,block_misses,%u\n",
+        sector_size, mb / t_raw, mb / t_packed, r->misses);
+    return 0;
+}
+
+static int test(const char *packed_path, const char *original_path)
+{
+    struct reader_t r;
+    if (!reader_open(&r, packed_path)) return 2;
+
+    int fd = open(original_path, O_RDONLY);
+    if (fd < 0)
+    {
+        perror(original_path);
+        return 2;
+    }
+
+    static const uint32_t sector_sizes[] = {2048, MAX_SECTOR_SIZE};
+    int status = 0;
+    for (size_t i = 0; i < sizeof(sector_sizes) / sizeof(sector_sizes[0]) && status == 0; i++)
+    {
+        status = test_sector_size(&r, fd, sector_sizes[i]);
+    }
+
+    close(fd);
+    close(r.fd);
+    return status;
+}
+
+int main(int argc, const char **argv)
+{
+    uint32_t block_size = DEFAULT_BLOCK_SIZE;
+    int argi = 1;
+
+    if (argc == 4 && strcmp(argv[1], "-t") == 0)
+    {
+        return test(argv[2], argv[3]);
+    }
+
+    if (argc == 5 && strcmp(argv[1], "-b") == 0)
+    {
+        block_size = strtoul(argv[2], NULL, 0);
+        argi = 3;
+    }
+
+    if (argc - argi != 2 || block_size < MIN_BLOCK_SIZE || block_size > MAX_BLOCK_SIZE ||
+        (block_size & (block_size - 1)) != 0)
+    {
+        fprintf(stderr, "Usage: %s [-b block_size] input.iso output.iso\n", argv[0]);
+        fprintf(stderr, "       %s -t output.iso input.iso\n", argv[0]);
+        fprintf(stderr, "Block size must be a power of two from %d to %d\n", MIN_BLOCK_SIZE, MAX_BLOCK_SIZE);
+        return 1;
+    }
+
+    return pack(argv[argi], argv[argi + 1], block_size);
+}